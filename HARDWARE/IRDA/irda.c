@@ -0,0 +1,254 @@
+#include "irda.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - IrDA SIR驱动
+// 功能说明：USART6的IrDA SIR模式 + DMA发送/接收环形缓冲区
+// 发送：IrDA_Write()把数据复制进发送环形缓冲区，DMA空闲时立即开始；每段发送完成后
+//      在中断中启动下一段连续数据，写入方不等待
+// 接收：DMA循环模式写接收环形缓冲区，半满/全满中断只累加计数；IrDA_Read()由计数和
+//      NDTR算出写位置，读取方落后超过一圈时丢弃积压数据（与红外捕获缓冲区相同）
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+IRDA_HandleTypeDef IRDA6_Handler;           // USART6 IrDA句柄
+static DMA_HandleTypeDef irda_tx_dma;       // DMA2_Stream6通道5
+static DMA_HandleTypeDef irda_rx_dma;       // DMA2_Stream1通道5
+
+// ==================== 发送环形缓冲区 ====================
+// 主循环只写irda_tx_head，中断只写irda_tx_tail；下标自由累加，(u16)(head-tail)为已用长度
+static u8  irda_tx_buf[IRDA_TX_BUF_LEN];
+static vu16 irda_tx_head=0;                 // 写位置（仅IrDA_Write()修改）
+static vu16 irda_tx_tail=0;                 // 已发送位置（仅发送完成中断修改）
+static vu16 irda_tx_len=0;                  // DMA正在发送的字节数（0=空闲）
+
+// ==================== 接收环形缓冲区 ====================
+static u8  irda_rx_buf[IRDA_RX_BUF_LEN];
+static vu32 irda_rx_halves=0;               // DMA已完成的半缓冲区个数（半满/全满中断累加）
+static u32 irda_rx_tail=0;                  // 已读出的字节总数
+
+static IrDA_Stats irda_stats;
+
+// 启动下一段连续数据的DMA发送（到缓冲区末尾为止）
+// 调用：IrDA_Write()（关中断下，DMA空闲时）或发送完成中断
+static void IrDA_Tx_Kick(void)
+{
+	u16 used=(u16)(irda_tx_head-irda_tx_tail);
+	u16 pos=irda_tx_tail&(IRDA_TX_BUF_LEN-1);
+	u16 len=IRDA_TX_BUF_LEN-pos;
+
+	if(!used)
+	{
+		irda_tx_len=0;
+		return;
+	}
+	if(len>used) len=used;
+	irda_tx_len=len;
+	irda_stats.tx_bytes+=len;
+	HAL_IRDA_Transmit_DMA(&IRDA6_Handler,&irda_tx_buf[pos],len);
+}
+
+// 发送完成（最后一个字节移出移位寄存器后由HAL库调用）
+void HAL_IRDA_TxCpltCallback(IRDA_HandleTypeDef *hirda)
+{
+	if(hirda->Instance!=USART6) return;
+	irda_tx_tail+=irda_tx_len;
+	IrDA_Tx_Kick();
+}
+
+// 接收DMA半满/全满：只累加计数，供IrDA_Read()计算写位置和检测溢出
+void HAL_IRDA_RxHalfCpltCallback(IRDA_HandleTypeDef *hirda)
+{
+	if(hirda->Instance==USART6) irda_rx_halves++;
+}
+
+void HAL_IRDA_RxCpltCallback(IRDA_HandleTypeDef *hirda)
+{
+	if(hirda->Instance==USART6) irda_rx_halves++;
+}
+
+// 获取DMA已写入的字节总数（生产者位置），原理同remote.c中的Remote_Cap_Head()
+static u32 IrDA_Rx_Head(void)
+{
+	u32 halves,pos;
+
+	do
+	{
+		halves=irda_rx_halves;
+		pos=IRDA_RX_BUF_LEN-__HAL_DMA_GET_COUNTER(&irda_rx_dma);
+	}while(halves!=irda_rx_halves);
+
+	if((pos>=IRDA_RX_BUF_LEN/2)!=(halves&1)) halves++;  // 中断尚未到来，补上这一半
+	return halves*(IRDA_RX_BUF_LEN/2)+(pos%(IRDA_RX_BUF_LEN/2));
+}
+
+// ==================== 中断服务函数 ====================
+void USART6_IRQHandler(void)
+{
+	HAL_IRDA_IRQHandler(&IRDA6_Handler);
+}
+
+void DMA2_Stream6_IRQHandler(void)          // USART6_TX
+{
+	HAL_DMA_IRQHandler(&irda_tx_dma);
+}
+
+void DMA2_Stream1_IRQHandler(void)          // USART6_RX
+{
+	HAL_DMA_IRQHandler(&irda_rx_dma);
+}
+
+// ==================== 初始化 ====================
+// IrDA SIR初始化
+// 参数：baud - 波特率（最高115200）
+void IrDA_Init(u32 baud)
+{
+	irda_tx_head=irda_tx_tail=0;
+	irda_tx_len=0;
+	irda_rx_halves=0;
+	irda_rx_tail=0;
+	memset(&irda_stats,0,sizeof(irda_stats));
+
+	IRDA6_Handler.Instance=USART6;
+	IRDA6_Handler.Init.BaudRate=baud;
+	IRDA6_Handler.Init.WordLength=IRDA_WORDLENGTH_8B;       // 8位数据
+	IRDA6_Handler.Init.Parity=IRDA_PARITY_NONE;             // 无校验（帧有CRC）
+	IRDA6_Handler.Init.Mode=IRDA_MODE_TX_RX;                // 收发
+	IRDA6_Handler.Init.Prescaler=1;                         // 正常模式下必须为1
+	IRDA6_Handler.Init.IrDAMode=IRDA_POWERMODE_NORMAL;      // 正常模式：脉冲宽度为位宽的3/16
+	HAL_IRDA_Init(&IRDA6_Handler);                          // 会调用HAL_IRDA_MspInit()
+
+	HAL_IRDA_Receive_DMA(&IRDA6_Handler,irda_rx_buf,IRDA_RX_BUF_LEN);  // 循环接收，一直运行
+	// 光路上的噪声帧、帧错误由帧CRC处理；关闭错误中断，否则HAL库会中止接收DMA
+	CLEAR_BIT(USART6->CR3,USART_CR3_EIE);
+	CLEAR_BIT(USART6->CR1,USART_CR1_PEIE);
+}
+
+//USART6底层驱动：时钟使能，引脚配置，收发DMA配置
+//此函数会被HAL_IRDA_Init()调用
+//hirda:IrDA句柄
+void HAL_IRDA_MspInit(IRDA_HandleTypeDef *hirda)
+{
+    GPIO_InitTypeDef GPIO_Initure;
+
+    if(hirda->Instance!=USART6) return;
+    __HAL_RCC_USART6_CLK_ENABLE();          //使能USART6时钟
+    __HAL_RCC_GPIOA_CLK_ENABLE();           //开启GPIOA时钟
+    __HAL_RCC_DMA2_CLK_ENABLE();            //使能DMA2时钟
+
+    GPIO_Initure.Pin=GPIO_PIN_11|GPIO_PIN_12;   //PA11/PA12
+    GPIO_Initure.Mode=GPIO_MODE_AF_PP;      //复用推挽输出
+    GPIO_Initure.Pull=GPIO_PULLUP;          //上拉
+    GPIO_Initure.Speed=GPIO_SPEED_FAST;     //快速
+    GPIO_Initure.Alternate=GPIO_AF8_USART6; //复用为USART6
+    HAL_GPIO_Init(GPIOA,&GPIO_Initure);
+
+    //发送DMA：发送环形缓冲区 -> USART6_DR，每段启动一次
+    irda_tx_dma.Instance=DMA2_Stream6;
+    irda_tx_dma.Init.Channel=DMA_CHANNEL_5;
+    irda_tx_dma.Init.Direction=DMA_MEMORY_TO_PERIPH;
+    irda_tx_dma.Init.PeriphInc=DMA_PINC_DISABLE;
+    irda_tx_dma.Init.MemInc=DMA_MINC_ENABLE;
+    irda_tx_dma.Init.PeriphDataAlignment=DMA_PDATAALIGN_BYTE;
+    irda_tx_dma.Init.MemDataAlignment=DMA_MDATAALIGN_BYTE;
+    irda_tx_dma.Init.Mode=DMA_NORMAL;
+    irda_tx_dma.Init.Priority=DMA_PRIORITY_LOW;
+    irda_tx_dma.Init.FIFOMode=DMA_FIFOMODE_DISABLE;
+    HAL_DMA_Init(&irda_tx_dma);
+    __HAL_LINKDMA(hirda,hdmatx,irda_tx_dma);
+
+    //接收DMA：USART6_DR -> 接收环形缓冲区，循环模式
+    irda_rx_dma.Instance=DMA2_Stream1;
+    irda_rx_dma.Init.Channel=DMA_CHANNEL_5;
+    irda_rx_dma.Init.Direction=DMA_PERIPH_TO_MEMORY;
+    irda_rx_dma.Init.PeriphInc=DMA_PINC_DISABLE;
+    irda_rx_dma.Init.MemInc=DMA_MINC_ENABLE;
+    irda_rx_dma.Init.PeriphDataAlignment=DMA_PDATAALIGN_BYTE;
+    irda_rx_dma.Init.MemDataAlignment=DMA_MDATAALIGN_BYTE;
+    irda_rx_dma.Init.Mode=DMA_CIRCULAR;
+    irda_rx_dma.Init.Priority=DMA_PRIORITY_MEDIUM;
+    irda_rx_dma.Init.FIFOMode=DMA_FIFOMODE_DISABLE;
+    HAL_DMA_Init(&irda_rx_dma);
+    __HAL_LINKDMA(hirda,hdmarx,irda_rx_dma);
+
+    //中断优先级低于红外接收和发射
+    HAL_NVIC_SetPriority(DMA2_Stream6_IRQn,2,2);
+    HAL_NVIC_EnableIRQ(DMA2_Stream6_IRQn);
+    HAL_NVIC_SetPriority(DMA2_Stream1_IRQn,2,2);
+    HAL_NVIC_EnableIRQ(DMA2_Stream1_IRQn);
+    HAL_NVIC_SetPriority(USART6_IRQn,2,2);          //发送完成（TC）中断
+    HAL_NVIC_EnableIRQ(USART6_IRQn);
+}
+
+// ==================== 接口函数 ====================
+// 写入发送数据（非阻塞）
+// 参数：data - 数据，len - 长度
+// 返回值：1=已全部写入发送缓冲区，0=空间不足（一个字节也不写入，调用者稍后重试）
+// 说明：只能在主循环中调用
+u8 IrDA_Write(const u8 *data,u16 len)
+{
+	u16 head=irda_tx_head,pos,n;
+
+	if(len>IrDA_Tx_Free())
+	{
+		irda_stats.tx_full++;
+		return 0;
+	}
+	while(len)
+	{
+		pos=head&(IRDA_TX_BUF_LEN-1);
+		n=IRDA_TX_BUF_LEN-pos;
+		if(n>len) n=len;
+		memcpy(&irda_tx_buf[pos],data,n);
+		head+=n;
+		data+=n;
+		len-=n;
+	}
+	__DMB();                                // 数据写完后再发布写位置
+	irda_tx_head=head;
+
+	__disable_irq();                        // 与发送完成中断互斥
+	if(!irda_tx_len) IrDA_Tx_Kick();
+	__enable_irq();
+	return 1;
+}
+
+// 发送缓冲区剩余空间（字节）
+u16 IrDA_Tx_Free(void)
+{
+	return IRDA_TX_BUF_LEN-(u16)(irda_tx_head-irda_tx_tail);
+}
+
+// 是否还有数据未发送完
+u8 IrDA_Tx_Busy(void)
+{
+	return irda_tx_len||irda_tx_head!=irda_tx_tail;
+}
+
+// 读取已接收的数据（非阻塞）
+// 参数：buf - 缓冲区，max - 最多读取的字节数
+// 返回值：读取的字节数，0=没有新数据
+u16 IrDA_Read(u8 *buf,u16 max)
+{
+	u32 head=IrDA_Rx_Head();
+	u16 n=0;
+
+	if(head-irda_rx_tail>IRDA_RX_BUF_LEN)   // 读取方落后超过一圈，积压数据已被覆盖
+	{
+		irda_stats.rx_overruns++;
+		irda_rx_tail=head;
+		return 0;
+	}
+	while(irda_rx_tail!=head&&n<max)
+		buf[n++]=irda_rx_buf[(irda_rx_tail++)&(IRDA_RX_BUF_LEN-1)];
+	irda_stats.rx_bytes+=n;
+	return n;
+}
+
+void IrDA_Get_Stats(IrDA_Stats *st)
+{
+	__disable_irq();
+	*st=irda_stats;
+	__enable_irq();
+}
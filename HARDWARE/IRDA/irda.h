@@ -0,0 +1,42 @@
+#ifndef __IRDA_H
+#define __IRDA_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - IrDA SIR驱动头文件
+// 功能说明：USART6工作在IrDA SIR模式（3/16位宽脉冲），DMA收发，提供非阻塞的字节流读写
+// 硬件接口：PA11 = USART6_TX（接红外收发器TXD），PA12 = USART6_RX（接红外收发器RXD）
+//          发送DMA：DMA2_Stream6通道5，接收DMA：DMA2_Stream1通道5（循环模式）
+// 说明：SIR为半双工，发送期间IrDA解码器忽略接收线上的数据（不会收到自己发出的回波）
+//      帧格式（起止标志、转义、CRC）见irda_simple.h
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+// IRDA_BAUD：       SIR速率（最高115200）
+// IRDA_TX_BUF_LEN： 发送环形缓冲区（字节，2的幂）；DMA每次发送一段连续数据，回绕处分两次
+// IRDA_RX_BUF_LEN： 接收环形缓冲区（字节，2的幂，DMA循环写入）
+//                   115200bps每秒约11.5KB，256字节可容纳主循环约22ms不读取的数据
+#define IRDA_BAUD           115200
+#define IRDA_TX_BUF_LEN     512
+#define IRDA_RX_BUF_LEN     256
+
+// 驱动统计
+typedef struct
+{
+    u32 tx_bytes;       // 已交给DMA发送的字节数
+    u32 rx_bytes;       // 已读出的字节数
+    u32 tx_full;        // 发送缓冲区空间不足被拒绝的写入次数
+    u32 rx_overruns;    // 主循环读取过慢，接收缓冲区被覆盖的次数（丢弃积压数据）
+} IrDA_Stats;
+
+// ==================== 函数声明 ====================
+void IrDA_Init(u32 baud);
+u8 IrDA_Write(const u8 *data, u16 len);
+u16 IrDA_Tx_Free(void);
+u8 IrDA_Tx_Busy(void);
+u16 IrDA_Read(u8 *buf, u16 max);
+void IrDA_Get_Stats(IrDA_Stats *st);
+
+#endif
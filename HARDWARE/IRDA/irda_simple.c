@@ -0,0 +1,163 @@
+#include "irda_simple.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - IrDA SIR帧层
+// 功能说明：帧编码（BOF/转义/FCS/EOF）后整帧写入发送缓冲区；接收端逐字节运行
+//          搜索/数据/转义三态状态机，FCS正确的帧才交给调用者
+// 说明：两个接口都不阻塞，只能在主循环中调用
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// 接收状态
+#define IRDA_RX_HUNT        0           // 搜索BOF
+#define IRDA_RX_DATA        1           // 接收数据
+#define IRDA_RX_ESC         2           // 收到转义字符，下一字节需还原
+
+// CRC-16/CCITT半字节查找表（反射多项式0x8408）
+static const u16 irda_fcs_tab[16]=
+{
+	0x0000,0x1081,0x2102,0x3183,0x4204,0x5285,0x6306,0x7387,
+	0x8408,0x9489,0xA50A,0xB58B,0xC60C,0xD68D,0xE70E,0xF78F
+};
+
+// 发送：最坏情况每字节都转义，另加BOF/EOF
+static u8 irda_tx_frame[2*(IRDA_FRAME_MAX+2)+2];
+
+// 接收：当前帧（数据+FCS）和从驱动读出但尚未处理的字节
+static u8  irda_rx_frame[IRDA_FRAME_MAX+2];
+static u16 irda_rx_len=0;
+static u8  irda_rx_state=IRDA_RX_HUNT;
+static u8  irda_rx_chunk[32];
+static u8  irda_rx_pos=0,irda_rx_cnt=0;
+
+static IrDA_Frame_Stats irda_frame_stats;
+
+// 计算FCS
+// 参数：fcs - 初值（IRDA_FCS_INIT或上一段的结果），data - 数据，len - 长度
+// 返回值：更新后的FCS（发送时取反）
+u16 IrDA_FCS(u16 fcs,const u8 *data,u16 len)
+{
+	while(len--)
+	{
+		fcs^=*data++;
+		fcs=(fcs>>4)^irda_fcs_tab[fcs&0x0F];
+		fcs=(fcs>>4)^irda_fcs_tab[fcs&0x0F];
+	}
+	return fcs;
+}
+
+// 写入一个字节，需要时转义
+static u16 IrDA_Stuff(u8 *p,u16 n,u8 b)
+{
+	if(b==IRDA_BOF||b==IRDA_EOF||b==IRDA_CE)
+	{
+		p[n++]=IRDA_CE;
+		b^=IRDA_ESC_XOR;
+	}
+	p[n++]=b;
+	return n;
+}
+
+// 发送一帧（非阻塞）
+// 参数：data - 数据，len - 长度（1~IRDA_FRAME_MAX）
+// 返回值：1=整帧已写入发送缓冲区，0=长度非法或缓冲区空间不足（调用者稍后重试）
+u8 IrDA_Frame_Send(const u8 *data,u16 len)
+{
+	u16 fcs,i,n=0;
+
+	if(!len||len>IRDA_FRAME_MAX) return 0;
+	fcs=~IrDA_FCS(IRDA_FCS_INIT,data,len);
+
+	irda_tx_frame[n++]=IRDA_BOF;
+	for(i=0;i<len;i++) n=IrDA_Stuff(irda_tx_frame,n,data[i]);
+	n=IrDA_Stuff(irda_tx_frame,n,fcs&0xFF);
+	n=IrDA_Stuff(irda_tx_frame,n,fcs>>8);
+	irda_tx_frame[n++]=IRDA_EOF;
+
+	if(!IrDA_Write(irda_tx_frame,n))
+	{
+		irda_frame_stats.tx_full++;
+		return 0;
+	}
+	irda_frame_stats.tx_frames++;
+	return 1;
+}
+
+// 接收状态机处理一个字节
+// 返回值：1=收到一个FCS正确的完整帧（irda_rx_frame，长度irda_rx_len含FCS）
+static u8 IrDA_Rx_Byte(u8 b)
+{
+	if(b==IRDA_BOF)                         // 任何状态下BOF都开始新帧
+	{
+		if(irda_rx_state!=IRDA_RX_HUNT&&irda_rx_len) irda_frame_stats.rx_aborts++;
+		irda_rx_state=IRDA_RX_DATA;
+		irda_rx_len=0;
+		return 0;
+	}
+	if(irda_rx_state==IRDA_RX_HUNT) return 0;
+	if(b==IRDA_EOF)
+	{
+		irda_rx_state=IRDA_RX_HUNT;
+		if(irda_rx_len<3)                   // 至少1字节数据+2字节FCS
+		{
+			irda_frame_stats.rx_aborts++;
+			return 0;
+		}
+		if(IrDA_FCS(IRDA_FCS_INIT,irda_rx_frame,irda_rx_len)!=IRDA_FCS_GOOD)
+		{
+			irda_frame_stats.rx_crc_errors++;
+			return 0;
+		}
+		return 1;
+	}
+	if(b==IRDA_CE)
+	{
+		irda_rx_state=IRDA_RX_ESC;
+		return 0;
+	}
+	if(irda_rx_state==IRDA_RX_ESC)
+	{
+		b^=IRDA_ESC_XOR;
+		irda_rx_state=IRDA_RX_DATA;
+	}
+	if(irda_rx_len>=sizeof(irda_rx_frame))  // 过长，丢弃到下一个BOF
+	{
+		irda_frame_stats.rx_aborts++;
+		irda_rx_state=IRDA_RX_HUNT;
+		return 0;
+	}
+	irda_rx_frame[irda_rx_len++]=b;
+	return 0;
+}
+
+// 接收一帧（非阻塞）
+// 参数：buf - 数据缓冲区，max - 缓冲区长度
+// 返回值：数据长度（不含FCS），0=暂时没有完整帧
+// 说明：帧长超过max时截断；一次调用最多返回一帧，其余字节留到下次
+u16 IrDA_Frame_Receive(u8 *buf,u16 max)
+{
+	u16 len;
+
+	for(;;)
+	{
+		if(irda_rx_pos>=irda_rx_cnt)
+		{
+			irda_rx_cnt=IrDA_Read(irda_rx_chunk,sizeof(irda_rx_chunk));
+			irda_rx_pos=0;
+			if(!irda_rx_cnt) return 0;
+		}
+		if(IrDA_Rx_Byte(irda_rx_chunk[irda_rx_pos++])) break;
+	}
+	irda_frame_stats.rx_frames++;
+	len=irda_rx_len-2;
+	if(len>max) len=max;
+	memcpy(buf,irda_rx_frame,len);
+	return len;
+}
+
+void IrDA_Frame_Get_Stats(IrDA_Frame_Stats *st)
+{
+	*st=irda_frame_stats;
+}
@@ -0,0 +1,41 @@
+#ifndef __IRDA_SIMPLE_H
+#define __IRDA_SIMPLE_H
+#include "sys.h"
+#include "irda.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - IrDA SIR帧层头文件
+// 功能说明：在irda.c的字节流上按IrLAP异步帧格式（IrDA SIR）收发数据帧
+// 帧格式：BOF(0xC0) | 数据 | FCS(2字节，低字节在前) | EOF(0xC1)
+//        数据和FCS中的0xC0/0xC1/0x7D转义为 0x7D,(字节^0x20)
+//        FCS为CRC-16/CCITT（反射多项式0x8408，初值0xFFFF，发送取反），正确帧对数据+FCS的校验余数为0xF0B8
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 帧参数 ====================
+#define IRDA_BOF            0xC0        // 帧开始
+#define IRDA_EOF            0xC1        // 帧结束
+#define IRDA_CE             0x7D        // 转义字符
+#define IRDA_ESC_XOR        0x20        // 转义后的字节 = 原字节^0x20
+#define IRDA_FCS_INIT       0xFFFF
+#define IRDA_FCS_GOOD       0xF0B8      // 数据+FCS的校验余数
+#define IRDA_FRAME_MAX      128         // 数据最大长度（字节）
+
+// 帧层统计
+typedef struct
+{
+    u32 tx_frames;      // 已发送的帧
+    u32 tx_full;        // 发送缓冲区空间不足被拒绝的帧
+    u32 rx_frames;      // 校验正确的接收帧
+    u32 rx_crc_errors;  // FCS错误的帧
+    u32 rx_aborts;      // 不完整的帧（过长、过短、帧中出现新的BOF）
+} IrDA_Frame_Stats;
+
+// ==================== 函数声明 ====================
+u16 IrDA_FCS(u16 fcs, const u8 *data, u16 len);
+u8 IrDA_Frame_Send(const u8 *data, u16 len);
+u16 IrDA_Frame_Receive(u8 *buf, u16 max);
+void IrDA_Frame_Get_Stats(IrDA_Frame_Stats *st);
+
+#endif
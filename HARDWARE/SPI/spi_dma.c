@@ -0,0 +1,303 @@
+#include "spi_dma.h"
+#include "spi.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - SPI1 DMA传输引擎
+// 功能说明：任务环形队列 + DMA2_Stream3（SPI1_TX）。提交函数把任务写入队列，引擎空闲时立即启动；
+//          每段传输完成后在DMA中断中启动下一段或下一个任务，超过65535个的任务分段发送
+// 任务切换：等SPI发送完最后一帧（TXE=1且BSY=0）后设置D/C，按需要切换DMA配置和SPI帧格式
+//          （字节任务：8位帧、存储器递增；填充任务：16位帧、存储器不递增，高字节先发）
+// 并发说明：主循环只写spi_head和spi_seq，DMA中断只写spi_tail和spi_done；spi_run=0时没有
+//          进行中的传输，也不会有DMA中断，此时主循环直接启动队首任务
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+#define SPI_DMA_MASK        (SPI_DMA_QUEUE_LEN-1)
+#define SPI_DMA_SEG_MAX     0xFFFF                  // DMA一次最多传输的数据个数（NDTR）
+
+// 一个发送任务
+typedef struct
+{
+    u16 value;                          // 填充任务的RGB565值（DMA源地址，须半字对齐）
+    u8  dc;                             // D/C线电平：0=命令，1=数据
+    u8  fill;                           // 1=填充任务（16位帧，存储器地址不递增）
+    u8  inl[SPI_DMA_INLINE];            // 短任务的数据
+    const u8 *src;                      // 下一段的源地址
+    u32 len;                            // 剩余数据个数（字节任务为字节，填充任务为16位帧），0=通知任务
+    SPI_DMA_Callback cb;                // 完成回调（DMA中断中执行）
+    void *arg;
+} SPI_Job;
+
+static DMA_HandleTypeDef spi_dma;       // DMA2_Stream3通道3
+static void (*spi_dc)(u8 level);        // D/C线控制（由LCD驱动提供）
+
+// ==================== 任务队列 ====================
+// 下标自由累加，(u8)(head-tail)为队列中的任务数（含正在执行的队首任务）
+static SPI_Job spi_job[SPI_DMA_QUEUE_LEN];
+static vu8  spi_head=0;                 // 写位置（仅主循环修改）
+static vu8  spi_tail=0;                 // 队首任务（DMA中断修改，spi_run=0时主循环修改）
+static vu8  spi_run=0;                  // 1=DMA传输进行中
+static vu32 spi_seq=0;                  // 已提交的任务数（最后一个任务的票据）
+static vu32 spi_done=0;                 // 已完成的任务数
+static u16  spi_seg=0;                  // 正在传输的一段的数据个数
+static u8   spi_mode=0;                 // 当前配置：0=8位帧/存储器递增，1=16位帧/存储器不递增
+static SPI_DMA_Stats spi_stats;
+
+static void SPI_DMA_Cplt(DMA_HandleTypeDef *hdma);
+static void SPI_DMA_Error(DMA_HandleTypeDef *hdma);
+
+// 等待SPI发送完最后一帧（切换D/C或关闭SPI之前）
+static void SPI_DMA_Wait_Idle(void)
+{
+    while((SPI1->SR&SPI_SR_TXE)==0);
+    while(SPI1->SR&SPI_SR_BSY);
+}
+
+// 切换DMA配置和SPI帧格式（SPI已空闲、DMA已停止时调用）
+static void SPI_DMA_Mode(u8 fill)
+{
+    spi_dma.Init.MemInc=fill?DMA_MINC_DISABLE:DMA_MINC_ENABLE;
+    spi_dma.Init.PeriphDataAlignment=fill?DMA_PDATAALIGN_HALFWORD:DMA_PDATAALIGN_BYTE;
+    spi_dma.Init.MemDataAlignment=fill?DMA_MDATAALIGN_HALFWORD:DMA_MDATAALIGN_BYTE;
+    HAL_DMA_Init(&spi_dma);
+
+    SPI1->CR1&=~SPI_CR1_SPE;            //DFF只能在SPI关闭时修改
+    if(fill) SPI1->CR1|=SPI_CR1_DFF;
+    else SPI1->CR1&=~SPI_CR1_DFF;
+    SPI1->CR1|=SPI_CR1_SPE;
+    spi_mode=fill;
+}
+
+// 队首任务完成：先释放队列位置再回调
+static void SPI_DMA_Finish(SPI_Job *j)
+{
+    SPI_DMA_Callback cb=j->cb;
+    void *arg=j->arg;
+
+    spi_tail++;
+    spi_done++;
+    spi_stats.jobs++;
+    if(cb) cb(arg);
+}
+
+// 启动队首任务的下一段；队列空时恢复8位帧并进入空闲
+// 调用：DMA中断（上一段完成），或spi_run=0时的主循环（提交任务）
+static void SPI_DMA_Kick(void)
+{
+    SPI_Job *j;
+
+    for(;;)
+    {
+        if(spi_tail==spi_head)
+        {
+            if(spi_mode)                //轮询发送（SPI1_WriteData）使用8位帧
+            {
+                SPI_DMA_Wait_Idle();
+                SPI_DMA_Mode(0);
+            }
+            spi_run=0;
+            return;
+        }
+        j=&spi_job[spi_tail&SPI_DMA_MASK];
+        if(j->len) break;
+        SPI_DMA_Finish(j);              //通知任务：前面的任务都已完成
+    }
+
+    SPI_DMA_Wait_Idle();                //上一个任务的最后一帧发完才能改D/C和帧格式
+    if(j->fill!=spi_mode) SPI_DMA_Mode(j->fill);
+    spi_dc(j->dc);
+    spi_seg=(j->len>SPI_DMA_SEG_MAX)?SPI_DMA_SEG_MAX:(u16)j->len;
+    spi_run=1;
+    HAL_DMA_Start_IT(&spi_dma,(u32)j->src,(u32)&SPI1->DR,spi_seg);
+}
+
+// 取一个空闲的队列位置（队列满时等待DMA中断释放）
+static SPI_Job *SPI_DMA_Alloc(void)
+{
+    if((u8)(spi_head-spi_tail)>=SPI_DMA_QUEUE_LEN)
+    {
+        spi_stats.full_waits++;
+        while((u8)(spi_head-spi_tail)>=SPI_DMA_QUEUE_LEN) SPI_DMA_IDLE();
+    }
+    return &spi_job[spi_head&SPI_DMA_MASK];
+}
+
+// 提交SPI_DMA_Alloc()取得并填好的任务，返回票据
+static u32 SPI_DMA_Post(void)
+{
+    u32 t=++spi_seq;                    //先分配票据再发布任务：中断完成它时spi_seq已包含它
+    u8 depth;
+
+    spi_head++;
+    depth=(u8)(spi_head-spi_tail);
+    if(depth>spi_stats.depth_max) spi_stats.depth_max=depth;
+    if(!spi_run) SPI_DMA_Kick();
+    return t;
+}
+
+static u32 SPI_DMA_Submit(u8 dc,u8 fill,const u8 *src,u32 len,SPI_DMA_Callback cb,void *arg)
+{
+    SPI_Job *j=SPI_DMA_Alloc();
+
+    j->dc=dc;
+    j->fill=fill;
+    j->src=src;
+    j->len=len;
+    j->cb=cb;
+    j->arg=arg;
+    return SPI_DMA_Post();
+}
+
+// ==================== 中断 ====================
+void DMA2_Stream3_IRQHandler(void)          // SPI1_TX
+{
+    HAL_DMA_IRQHandler(&spi_dma);
+}
+
+// 一段传输完成：任务还有剩余时发送下一段，否则完成该任务并启动下一个任务
+static void SPI_DMA_Cplt(DMA_HandleTypeDef *hdma)
+{
+    SPI_Job *j=&spi_job[spi_tail&SPI_DMA_MASK];
+
+    (void)hdma;
+    spi_stats.irqs++;
+    spi_stats.bytes+=j->fill?(u32)spi_seg*2:spi_seg;
+    j->len-=spi_seg;
+    if(!j->fill) j->src+=spi_seg;
+    if(!j->len) SPI_DMA_Finish(j);
+    SPI_DMA_Kick();
+}
+
+// 传输错误：放弃该任务的剩余部分，按完成处理（回调照常执行，队列不停顿）
+static void SPI_DMA_Error(DMA_HandleTypeDef *hdma)
+{
+    spi_stats.errors++;
+    spi_job[spi_tail&SPI_DMA_MASK].len=spi_seg;
+    SPI_DMA_Cplt(hdma);
+}
+
+// ==================== 接口函数 ====================
+// 初始化DMA2_Stream3通道3并打开SPI1的发送DMA请求
+// 参数：dc - 设置D/C线电平的函数（在DMA中断中调用）
+void SPI1_DMA_Init(void (*dc)(u8 level))
+{
+    __HAL_RCC_DMA2_CLK_ENABLE();            //使能DMA2时钟
+
+    spi_dc=dc;
+    spi_head=spi_tail=0;
+    spi_seq=spi_done=0;
+    spi_run=0;
+
+    //发送DMA：任务数据 -> SPI1_DR，每段启动一次
+    spi_dma.Instance=DMA2_Stream3;
+    spi_dma.Init.Channel=DMA_CHANNEL_3;
+    spi_dma.Init.Direction=DMA_MEMORY_TO_PERIPH;
+    spi_dma.Init.PeriphInc=DMA_PINC_DISABLE;
+    spi_dma.Init.Mode=DMA_NORMAL;
+    spi_dma.Init.Priority=DMA_PRIORITY_LOW;
+    spi_dma.Init.FIFOMode=DMA_FIFOMODE_DISABLE;
+    spi_dma.XferCpltCallback=SPI_DMA_Cplt;
+    spi_dma.XferErrorCallback=SPI_DMA_Error;
+    SPI_DMA_Mode(0);
+    __HAL_LINKDMA(&SPI1_Handler,hdmatx,spi_dma);
+    SPI1->CR2|=SPI_CR2_TXDMAEN;             //TXE时请求DMA（DMA未使能时轮询发送不受影响）
+
+    //LCD刷新不要求实时，优先级低于红外收发、软件PWM和IrDA
+    HAL_NVIC_SetPriority(DMA2_Stream3_IRQn,3,2);
+    HAL_NVIC_EnableIRQ(DMA2_Stream3_IRQn);
+}
+
+// 命令字节（D/C=0）
+u32 SPI1_DMA_Cmd(u8 cmd)
+{
+    SPI_Job *j=SPI_DMA_Alloc();
+
+    j->inl[0]=cmd;
+    j->dc=0;
+    j->fill=0;
+    j->src=j->inl;
+    j->len=1;
+    j->cb=0;
+    return SPI_DMA_Post();
+}
+
+// 短数据（D/C=1）：数据复制进队列，调用方可以立即修改；超过SPI_DMA_INLINE字节时拆成多个任务
+// 返回值：最后一个任务的票据
+u32 SPI1_DMA_Data(const u8 *data,u8 len)
+{
+    SPI_Job *j;
+    u8 i,n;
+    u32 t=spi_seq;
+
+    while(len)
+    {
+        n=(len>SPI_DMA_INLINE)?SPI_DMA_INLINE:len;
+        j=SPI_DMA_Alloc();
+        for(i=0;i<n;i++) j->inl[i]=data[i];
+        j->dc=1;
+        j->fill=0;
+        j->src=j->inl;
+        j->len=n;
+        j->cb=0;
+        t=SPI_DMA_Post();
+        data+=n;
+        len-=n;
+    }
+    return t;
+}
+
+// 数据块（D/C=1）：按指针发送len字节，完成前调用方不能修改数据
+// 参数：cb/arg - 完成回调（可为0）
+u32 SPI1_DMA_Burst(const u8 *data,u32 len,SPI_DMA_Callback cb,void *arg)
+{
+    return SPI_DMA_Submit(1,0,len?data:0,len,cb,arg);
+}
+
+// 重复填充（D/C=1）：把RGB565值value发送count次（高字节先发），不占用缓冲区
+u32 SPI1_DMA_Fill(u16 value,u32 count,SPI_DMA_Callback cb,void *arg)
+{
+    SPI_Job *j=SPI_DMA_Alloc();
+
+    j->value=value;
+    j->dc=1;
+    j->fill=count?1:0;
+    j->src=(const u8*)&j->value;
+    j->len=count;
+    j->cb=cb;
+    j->arg=arg;
+    return SPI_DMA_Post();
+}
+
+// 通知：前面提交的任务全部完成时回调cb（引擎空闲时在本函数中直接回调）
+u32 SPI1_DMA_Notify(SPI_DMA_Callback cb,void *arg)
+{
+    return SPI_DMA_Submit(1,0,0,0,cb,arg);
+}
+
+// 票据对应的任务是否已完成（按提交顺序完成，差值判断可跨越32位回绕）
+u8 SPI1_DMA_Done(u32 ticket)
+{
+    return (s32)(spi_done-ticket)>=0;
+}
+
+void SPI1_DMA_Wait(u32 ticket)
+{
+    while(!SPI1_DMA_Done(ticket)) SPI_DMA_IDLE();
+}
+
+// 等待全部任务完成（轮询发送之前调用，保证顺序和D/C线状态）
+void SPI1_DMA_Flush(void)
+{
+    SPI1_DMA_Wait(spi_seq);
+}
+
+u8 SPI1_DMA_Busy(void)
+{
+    return spi_done!=spi_seq;
+}
+
+void SPI1_DMA_Get_Stats(SPI_DMA_Stats *st)
+{
+    *st=spi_stats;
+}
@@ -0,0 +1,57 @@
+#ifndef __SPI_DMA_H
+#define __SPI_DMA_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - SPI1 DMA传输引擎头文件
+// 功能说明：SPI1发送任务队列，任务由DMA2_Stream3通道3（SPI1_TX）依次执行，提交方不等待传输
+// 任务类型：命令字节（D/C=0）、短数据（D/C=1，最多SPI_DMA_INLINE字节，复制进队列）、
+//          数据块（D/C=1，按指针发送，传输完成前调用方不能修改）、
+//          重复填充（D/C=1，16位帧重复发送同一个RGB565值，存储器地址不递增，CPU不填缓冲区）、
+//          通知（不发送数据，前面的任务全部完成时回调）
+// 完成通知：提交函数返回任务票据，SPI1_DMA_Done()查询（事件）；数据块/填充/通知任务可带回调，
+//          回调在DMA中断中执行（引擎空闲时提交的通知任务在提交函数中直接回调）
+// 说明：只能在主循环中提交任务；队列满时提交函数等待空位。切换D/C和帧格式前等SPI发送完最后一帧，
+//      队列空时恢复8位帧，SPI1_WriteData()等轮询发送前须先调用SPI1_DMA_Flush()
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+// SPI_DMA_QUEUE_LEN：任务队列长度（2的幂，不超过128）；一次地址设置为5个任务
+// SPI_DMA_INLINE：   短任务复制进队列的最大字节数（ST7789窗口参数为4字节）
+#define SPI_DMA_QUEUE_LEN   16
+#define SPI_DMA_INLINE      4
+
+// 等待任务完成时的空转操作（主机仿真中由STUB/sys.h改为推进虚拟时间）
+#ifndef SPI_DMA_IDLE
+#define SPI_DMA_IDLE()
+#endif
+
+typedef void (*SPI_DMA_Callback)(void *arg);
+
+// 引擎统计
+typedef struct
+{
+    u32 jobs;           // 完成的任务数
+    u32 bytes;          // DMA发送的字节数
+    u32 irqs;           // DMA传输完成中断次数
+    u32 full_waits;     // 提交时队列满而等待的次数
+    u32 errors;         // DMA传输错误次数
+    u8  depth_max;      // 队列最大深度
+} SPI_DMA_Stats;
+
+// ==================== 函数声明 ====================
+void SPI1_DMA_Init(void (*dc)(u8 level));   // dc：设置D/C线电平（SPI1_Init之后调用）
+u32 SPI1_DMA_Cmd(u8 cmd);
+u32 SPI1_DMA_Data(const u8 *data, u8 len);
+u32 SPI1_DMA_Burst(const u8 *data, u32 len, SPI_DMA_Callback cb, void *arg);
+u32 SPI1_DMA_Fill(u16 value, u32 count, SPI_DMA_Callback cb, void *arg);
+u32 SPI1_DMA_Notify(SPI_DMA_Callback cb, void *arg);
+u8 SPI1_DMA_Done(u32 ticket);
+void SPI1_DMA_Wait(u32 ticket);
+void SPI1_DMA_Flush(void);
+u8 SPI1_DMA_Busy(void);
+void SPI1_DMA_Get_Stats(SPI_DMA_Stats *st);
+
+#endif
@@ -0,0 +1,425 @@
+#include "lcd_band.h"
+#include "tftlcd.h"
+#include "spi_dma.h"
+#include "lcd_gcache.h"
+#include <string.h>
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - LCD分带合成与局部刷新
+// 功能说明：场景为清屏颜色上按绘制顺序叠放的绘制项，与屏幕内容一致；一帧内的绘制追加到场景顶部，
+//          被新项完全盖住的旧项移出场景。帧结束时新增、移出的项的矩形为候选脏区，相交或相邻的
+//          合并后逐行比较帧前、帧后场景合成的像素，只发送有变化的外接矩形；清屏后整屏发送
+// 帧内记录：每项有两个标志：LIVE_OLD=帧开始时在场景中，LIVE_NEW=当前在场景中；
+//          帧结束时去掉LIVE_NEW为0的项，其余两个标志都置位
+// 缓冲区：带缓冲区中的像素按SPI发送顺序存放（高字节在前），DMA按8位帧直接发送；
+//        每个缓冲区记下最后一次发送的票据，再次合成前等它发送完成
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+#define BAND_PIXELS     LCD_BAND_PIXELS
+#define BAND_SWAP(c)    LCD_BAND_SWAP(c)
+
+// 绘制项类型
+#define BAND_FILL       0
+#define BAND_CHAR       1
+#define BAND_IMAGE      2
+
+#define LIVE_OLD        1
+#define LIVE_NEW        2
+
+// 一个绘制项（坐标为闭区间，颜色已转为发送顺序）
+typedef struct
+{
+    u8  type;
+    u8  live;                           // LIVE_OLD/LIVE_NEW
+    u16 x1, y1, x2, y2;
+    u16 fg, bg;                         // 填充项只用fg
+    const u8 *p;                        // 字模或图片数据
+    const u16 *px;                      // 字符项：本次合成中查到的字形像素（0=逐位展开）
+    u32 gseq;                           // 查到px时的band_gseq
+} Band_Item;
+
+// 脏矩形
+typedef struct
+{
+    u16 x1, y1, x2, y2;
+} Band_Rect;
+
+static u16 band_buf[LCD_BAND_BUFS][BAND_PIXELS];
+static u32 band_ticket[LCD_BAND_BUFS];  // 各缓冲区最后一次发送的票据
+static u8  band_next=0;                 // 下一个使用的缓冲区
+static u16 band_row[2][LCD_Width];      // 比较用：帧前、帧后场景合成的一行
+
+static Band_Item band_item[LCD_BAND_ITEMS];
+static u16 band_n=0;
+static Band_Rect band_dirty[LCD_BAND_DIRTY];
+static u8  band_dirty_n=0;
+static u16 band_color;                  // 清屏颜色
+static u16 band_bg;                     // 清屏颜色（发送顺序）
+static u8  band_depth=0;                // Begin嵌套层数
+static u8  band_valid=0;                // 1=场景与屏幕一致（清屏之后），绘制都记录
+static u8  band_pending=0;              // 1=本帧有绘制，未发送
+static u8  band_full=0;                 // 1=本帧清过屏，整屏发送
+static u8  band_sending=0;              // 1=正在发送（LCD_Address_Set()不触发Sync）
+static LCD_Band_Stats band_stats;
+static u32 band_gseq=0;                 // 合成中字形缓存的查找序号：每查一次加1，每次合成开始加LCD_GCACHE_SLOTS
+
+// 场景中live标志含mask的项合成一行：x1~x2列，第y行
+// 字符项每次合成只查一次字形缓存，之后各行复用查到的像素；其后又查了LCD_GCACHE_SLOTS-1个字形时
+// 该槽可能被替换，重新查找
+static void Band_Row(u16 *dst, u16 x1, u16 x2, u16 y, u8 mask)
+{
+    Band_Item *it;
+    u16 i, x, xa, xb, w;
+    const u8 *src;
+    const u16 *px;
+
+    for(x = 0; x <= x2 - x1; x++) dst[x] = band_bg;
+
+    for(i = 0, it = band_item; i < band_n; i++, it++)
+    {
+        if(!(it->live & mask) || y < it->y1 || y > it->y2 || it->x2 < x1 || it->x1 > x2) continue;
+
+        xa = it->x1 > x1 ? it->x1 : x1;
+        xb = it->x2 < x2 ? it->x2 : x2;
+        w = it->x2 - it->x1 + 1;
+
+        switch(it->type)
+        {
+            case BAND_FILL:
+                for(x = xa; x <= xb; x++) dst[x - x1] = it->fg;
+                break;
+
+            case BAND_IMAGE:            // 图片数据已是高字节在前
+                memcpy(dst + (xa - x1), it->p + ((u32)(y - it->y1) * w + (xa - it->x1)) * 2, (xb - xa + 1) * 2);
+                break;
+
+            case BAND_CHAR:             // 缓存的字形按行复制；不缓存的字号逐位展开（字模逐行、高位在前）
+                if(band_gseq - it->gseq > LCD_GCACHE_SLOTS - 1)
+                {
+                    it->px = LCD_GCache_Get(it->p, it->y2 - it->y1 + 1, it->fg, it->bg);
+                    it->gseq = band_gseq++;
+                }
+                px = it->px;
+                if(px)
+                {
+                    memcpy(dst + (xa - x1), px + (y - it->y1) * w + (xa - it->x1), (xb - xa + 1) * 2);
+                    break;
+                }
+
+                src = it->p + (y - it->y1) * ((w + 7) / 8);
+                for(x = xa; x <= xb; x++)
+                    dst[x - x1] = (src[(x - it->x1) >> 3] & (0x80 >> ((x - it->x1) & 7))) ? it->fg : it->bg;
+                break;
+        }
+    }
+}
+
+// 发送一个矩形（帧后场景）：没有绘制项时用DMA重复填充，否则分块合成到带缓冲区后发送
+static void Band_Send_Rect(const Band_Rect *r)
+{
+    u16 w = r->x2 - r->x1 + 1, rows = BAND_PIXELS / w;
+    u16 y, y_end, i;
+    u16 *buf;
+
+    band_sending = 1;
+    band_gseq += LCD_GCACHE_SLOTS;      // 上次合成查到的字形像素作废（其间LCD_Text()可能替换了槽）
+    LCD_Address_Set(r->x1, r->y1, r->x2, r->y2);
+
+    for(i = 0; i < band_n; i++)
+        if((band_item[i].live & LIVE_NEW) && band_item[i].x1 <= r->x2 && band_item[i].x2 >= r->x1 &&
+           band_item[i].y1 <= r->y2 && band_item[i].y2 >= r->y1) break;
+
+    if(i == band_n) SPI1_DMA_Fill(band_color, (u32)w * (r->y2 - r->y1 + 1), 0, 0);
+    else
+    {
+        for(y = r->y1; y <= r->y2; )
+        {
+            y_end = y + rows - 1 < r->y2 ? y + rows - 1 : r->y2;
+            buf = LCD_Band_Buf();
+
+            for(i = 0; y <= y_end; y++, i++) Band_Row(buf + i * w, r->x1, r->x2, y, LIVE_NEW);
+
+            LCD_Band_Send_Buf((u32)i * w);
+            band_stats.bands++;
+        }
+    }
+
+    band_sending = 0;
+    band_stats.rects++;
+    band_stats.pixels += (u32)w * (r->y2 - r->y1 + 1);
+}
+
+// 候选脏区逐行比较帧前、帧后的合成结果，缩小到有变化的外接矩形；返回0表示没有变化
+static u8 Band_Diff(Band_Rect *r)
+{
+    u16 y, x, w = r->x2 - r->x1 + 1;
+    u16 x1 = LCD_Width, x2 = 0, y1 = LCD_Height, y2 = 0;
+
+    band_gseq += LCD_GCACHE_SLOTS;      // 帧前、帧后两次合成共用一次查找
+    for(y = r->y1; y <= r->y2; y++)
+    {
+        Band_Row(band_row[0], r->x1, r->x2, y, LIVE_OLD);
+        Band_Row(band_row[1], r->x1, r->x2, y, LIVE_NEW);
+        if(!memcmp(band_row[0], band_row[1], w * 2)) continue;
+
+        for(x = 0; band_row[0][x] == band_row[1][x]; x++);
+        if(x + r->x1 < x1) x1 = x + r->x1;
+        for(x = w - 1; band_row[0][x] == band_row[1][x]; x--);
+        if(x + r->x1 > x2) x2 = x + r->x1;
+        if(y < y1) y1 = y;
+        y2 = y;
+    }
+
+    if(y1 > y2) return 0;
+
+    r->x1 = x1;
+    r->y1 = y1;
+    r->x2 = x2;
+    r->y2 = y2;
+    return 1;
+}
+
+// 两个矩形相交，或合并后多出的面积不超过LCD_BAND_SLACK个像素时可以合并
+static u8 Band_Near(const Band_Rect *a, const Band_Rect *b)
+{
+    u32 ua, ub, uu;
+
+    if(a->x1 <= b->x2 && b->x1 <= a->x2 && a->y1 <= b->y2 && b->y1 <= a->y2) return 1;
+
+    ua = (u32)(a->x2 - a->x1 + 1) * (a->y2 - a->y1 + 1);
+    ub = (u32)(b->x2 - b->x1 + 1) * (b->y2 - b->y1 + 1);
+    uu = (u32)((a->x2 > b->x2 ? a->x2 : b->x2) - (a->x1 < b->x1 ? a->x1 : b->x1) + 1) *
+         ((a->y2 > b->y2 ? a->y2 : b->y2) - (a->y1 < b->y1 ? a->y1 : b->y1) + 1);
+    return uu - ua - ub <= LCD_BAND_SLACK;
+}
+
+// 加入一个候选脏区，与已有的相交或相邻的合并；列表满时并入最后一个
+static void Band_Dirty_Add(u16 x1, u16 y1, u16 x2, u16 y2)
+{
+    Band_Rect r = { x1, y1, x2, y2 };
+    Band_Rect *d;
+    u8 i;
+
+    for(i = 0; i < band_dirty_n; )
+    {
+        d = &band_dirty[i];
+        if(!Band_Near(d, &r) && band_dirty_n < LCD_BAND_DIRTY)
+        {
+            i++;
+            continue;
+        }
+
+        if(d->x1 < r.x1) r.x1 = d->x1;      // 合并后从头再查，合并的结果可能又与别的相交
+        if(d->y1 < r.y1) r.y1 = d->y1;
+        if(d->x2 > r.x2) r.x2 = d->x2;
+        if(d->y2 > r.y2) r.y2 = d->y2;
+        *d = band_dirty[--band_dirty_n];
+        i = 0;
+    }
+
+    band_dirty[band_dirty_n++] = r;
+}
+
+// 发送本帧：整屏或各脏区中有变化的部分，然后整理场景
+static void Band_Commit(void)
+{
+    Band_Rect all = { 0, 0, LCD_Width - 1, LCD_Height - 1 };
+    Band_Item *it;
+    u16 i, n;
+
+    if(band_full)
+    {
+        Band_Send_Rect(&all);
+        band_stats.pages++;
+    }
+    else
+    {
+        band_dirty_n = 0;
+        for(i = 0, it = band_item; i < band_n; i++, it++)
+            if(it->live == LIVE_OLD || it->live == LIVE_NEW) Band_Dirty_Add(it->x1, it->y1, it->x2, it->y2);
+
+        for(i = 0; i < band_dirty_n; i++)
+        {
+            if(Band_Diff(&band_dirty[i])) Band_Send_Rect(&band_dirty[i]);
+            else band_stats.skips++;
+        }
+    }
+
+    if(band_n > band_stats.items_max) band_stats.items_max = band_n;
+
+    for(i = n = 0; i < band_n; i++)     // 去掉移出场景的项
+    {
+        if(!(band_item[i].live & LIVE_NEW)) continue;
+        band_item[n] = band_item[i];
+        band_item[n++].live = LIVE_OLD | LIVE_NEW;
+    }
+
+    band_n = n;
+    band_full = 0;
+    band_pending = 0;
+    band_stats.frames++;
+}
+
+// 记录一项：盖住的项移出场景；不在Begin/End之间时立即发送
+static u8 Band_Add(u8 type, u16 x1, u16 y1, u16 x2, u16 y2, u16 fg, u16 bg, const u8 *p)
+{
+    Band_Item *it;
+    u16 i;
+
+    if(!band_valid) return 0;
+
+    if(band_n >= LCD_BAND_ITEMS)        // 先发送本帧已记录的部分，整理后仍满则不再记录
+    {
+        band_stats.spills++;
+        Band_Commit();
+
+        if(band_n >= LCD_BAND_ITEMS)
+        {
+            band_valid = 0;
+            band_n = 0;
+            return 0;
+        }
+    }
+
+    for(i = 0, it = band_item; i < band_n; i++, it++)
+        if(it->x1 >= x1 && it->x2 <= x2 && it->y1 >= y1 && it->y2 <= y2) it->live &= ~LIVE_NEW;
+
+    it = &band_item[band_n++];
+    it->type = type;
+    it->live = LIVE_NEW;
+    it->x1 = x1;
+    it->y1 = y1;
+    it->x2 = x2;
+    it->y2 = y2;
+    it->fg = fg;
+    it->bg = bg;
+    it->p = p;
+    it->gseq = band_gseq - LCD_GCACHE_SLOTS;
+    band_pending = 1;
+
+    if(!band_depth) Band_Commit();
+
+    return 1;
+}
+
+/**
+ * @brief	取下一个带缓冲区，等它上一次的发送完成
+ *
+ * @param   void
+ *
+ * @return  缓冲区地址（LCD_BAND_PIXELS个像素）
+ */
+u16 *LCD_Band_Buf(void)
+{
+    if(!SPI1_DMA_Done(band_ticket[band_next]))
+    {
+        band_stats.stalls++;
+        SPI1_DMA_Wait(band_ticket[band_next]);
+    }
+
+    return band_buf[band_next];
+}
+
+/**
+ * @brief	发送LCD_Band_Buf()取得的缓冲区的前pixels个像素（不等待发送完成）
+ *
+ * @param   pixels	像素数
+ *
+ * @return  void
+ */
+void LCD_Band_Send_Buf(u32 pixels)
+{
+    band_ticket[band_next] = SPI1_DMA_Burst((const u8*)band_buf[band_next], pixels * 2, 0, 0);
+    band_next = (band_next + 1) % LCD_BAND_BUFS;
+}
+
+void LCD_Band_Glyph_Row(u16 *dst, const u8 *row, u8 w, u16 fg, u16 bg)
+{
+    u8 x;
+
+    for(x = 0; x < w; x++)
+        dst[x] = (row[x >> 3] & (0x80 >> (x & 7))) ? fg : bg;
+}
+
+/**
+ * @brief	开始一帧（可嵌套）
+ *
+ * @param   void
+ *
+ * @return  void
+ */
+void LCD_Band_Begin(void)
+{
+    band_depth++;
+}
+
+/**
+ * @brief	结束一帧，最外层时发送本帧的变化（不等待发送完成）
+ *
+ * @param   void
+ *
+ * @return  void
+ */
+void LCD_Band_End(void)
+{
+    if(!band_depth) return;
+
+    if(--band_depth == 0 && band_pending) Band_Commit();
+}
+
+void LCD_Band_Get_Stats(LCD_Band_Stats *st)
+{
+    *st = band_stats;
+}
+
+// 清屏：场景清空，此后的绘制都记录，本帧整屏发送
+void LCD_Band_Rec_Clear(u16 color)
+{
+    band_valid = 1;
+    band_n = 0;
+    band_color = color;
+    band_bg = BAND_SWAP(color);
+    band_full = 1;
+    band_pending = 1;
+
+    if(!band_depth) Band_Commit();
+}
+
+u8 LCD_Band_Rec_Fill(u16 x1, u16 y1, u16 x2, u16 y2, u16 color)
+{
+    if(x1 > x2 || y1 > y2 || x1 >= LCD_Width || y1 >= LCD_Height) return band_valid;
+
+    if(x2 >= LCD_Width) x2 = LCD_Width - 1;     // 超出屏幕的部分不可见
+    if(y2 >= LCD_Height) y2 = LCD_Height - 1;
+
+    return Band_Add(BAND_FILL, x1, y1, x2, y2, BAND_SWAP(color), 0, 0);
+}
+
+// 字符：POINT_COLOR/BACK_COLOR在记录时取值
+u8 LCD_Band_Rec_Char(u16 x, u16 y, u8 size, const u8 *glyph)
+{
+    if(!glyph) return 0;
+
+    return Band_Add(BAND_CHAR, x, y, x + size / 2 - 1, y + size - 1,
+                    BAND_SWAP(POINT_COLOR), BAND_SWAP(BACK_COLOR), glyph);
+}
+
+// 图片：数据须在场景中一直有效（Flash中的常量）
+u8 LCD_Band_Rec_Image(u16 x, u16 y, u16 width, u16 height, const u8 *p)
+{
+    return Band_Add(BAND_IMAGE, x, y, x + width - 1, y + height - 1, 0, 0, p);
+}
+
+// 不能记录的绘制：先发送本帧，场景不再与屏幕一致，直到下一次清屏
+void LCD_Band_Sync(void)
+{
+    if(!band_valid || band_sending) return;
+
+    if(band_pending) Band_Commit();
+
+    band_valid = 0;
+    band_n = 0;
+    band_stats.spills++;
+}
@@ -0,0 +1,66 @@
+#ifndef __LCD_BAND_H
+#define __LCD_BAND_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - LCD分带合成与局部刷新头文件
+// 功能说明：LCD_Clear()之后的绘制（清屏、矩形填充、字符、图片）都记录在场景中，不直接发送；
+//          LCD_Band_Begin()/LCD_Band_End()之间为一帧，帧结束时只发送有变化的矩形
+//          （候选脏区合并后逐行比较帧前帧后的合成结果），Begin/End之外的绘制各自为一帧
+// 发送：脏区按LCD_BAND_LINES行（整屏宽）为一块在RAM中合成，LCD_BAND_BUFS个带缓冲区轮流使用，
+//      DMA发送第N块时CPU合成第N+1块；清屏的一帧整屏只发送一遍，时间接近SPI线上时间
+// 说明：Begin/End可以嵌套，最外层End时发送；不能记录的绘制（画点、画线）之前先发送本帧，
+//      之后直到下一次清屏都直接发送；场景满时先发送本帧再整理；只能在主循环中使用；
+//      带缓冲区也供tftlcd.c的文字光栅化使用（LCD_Band_Buf/LCD_Band_Send_Buf）
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+// LCD_BAND_LINES：每块行数（按整屏宽），每个带缓冲区240×行数×2字节
+// LCD_BAND_BUFS： 带缓冲区个数（不少于2）
+// LCD_BAND_ITEMS：场景最多的绘制项数（每个字符一项，含一帧内被盖住待移出的项）
+// LCD_BAND_DIRTY：一帧最多的脏矩形数，满时合并
+// LCD_BAND_SLACK：两个脏矩形合并后多出的像素不超过此值时合并（少设一次窗口）
+#define LCD_BAND_LINES  8
+#define LCD_BAND_BUFS   2
+#define LCD_BAND_ITEMS  320
+#define LCD_BAND_DIRTY  16
+#define LCD_BAND_SLACK  64
+
+#define LCD_BAND_PIXELS (LCD_BAND_LINES*240)                // 一个带缓冲区的像素数
+#define LCD_BAND_SWAP(c) ((u16)(((c)>>8)|((c)<<8)))         // RGB565转为发送顺序（高字节在前）
+
+// 合成统计
+typedef struct
+{
+    u32 frames;         // 发送的帧数
+    u32 pages;          // 整屏发送的帧数（清屏）
+    u32 rects;          // 发送的矩形数
+    u32 pixels;         // 发送的像素数
+    u32 skips;          // 比较后没有变化、不发送的候选脏区数
+    u32 bands;          // 合成发送的块数
+    u32 stalls;         // 合成前等待带缓冲区发送完成的次数
+    u32 spills;         // 因不能记录的绘制或场景满提前发送的次数
+    u16 items_max;      // 场景最多的绘制项数
+} LCD_Band_Stats;
+
+// ==================== 函数声明 ====================
+void LCD_Band_Begin(void);
+void LCD_Band_End(void);
+void LCD_Band_Get_Stats(LCD_Band_Stats *st);
+
+// tftlcd.c调用：清屏开始新的场景；其余返回1表示已记录，调用方不再发送
+void LCD_Band_Rec_Clear(u16 color);
+u8 LCD_Band_Rec_Fill(u16 x1, u16 y1, u16 x2, u16 y2, u16 color);
+u8 LCD_Band_Rec_Char(u16 x, u16 y, u8 size, const u8 *glyph);
+u8 LCD_Band_Rec_Image(u16 x, u16 y, u16 width, u16 height, const u8 *p);
+void LCD_Band_Sync(void);           // 设置显示窗口前调用：不能记录的绘制之前先发送本帧
+
+// 带缓冲区：Buf取下一个缓冲区（等它上一次发送完成），填好后Send_Buf按数据块发送（不等待）
+u16 *LCD_Band_Buf(void);
+void LCD_Band_Send_Buf(u32 pixels);
+// 一行字模展开为像素：row为字模的一行（高位在前），w为字宽，fg/bg为发送顺序的颜色
+void LCD_Band_Glyph_Row(u16 *dst, const u8 *row, u8 w, u16 fg, u16 bg);
+
+#endif
@@ -0,0 +1,135 @@
+#include "lcd_gcache.h"
+#include "lcd_band.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - LCD字形缓存
+// 功能说明：散列表按(字模地址, 字体色, 背景色)查找槽，命中时更新使用时刻；
+//          未命中时取空槽或使用时刻最早的槽（LRU），把字模逐行展开进槽中
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+#define GC_NONE     0xFF                // 空链接
+
+#if LCD_GCACHE_SLOTS > 255
+#error "LCD_GCACHE_SLOTS must be less than 255"
+#endif
+
+// 一个槽的键和链接
+typedef struct
+{
+    const u8 *glyph;                    // 字模地址，0=空槽
+    u16 fg, bg;
+    u32 stamp;                          // 最后使用时刻（LRU）
+    u8  next;                           // 同一桶中的下一个槽
+} GC_Slot;
+
+static u16 gc_pix[LCD_GCACHE_SLOTS][LCD_GCACHE_SLOT / 2];
+static GC_Slot gc_slot[LCD_GCACHE_SLOTS];
+static u8  gc_head[LCD_GCACHE_HASH];    // 各桶的第一个槽
+static u8  gc_init = 0;
+static u32 gc_clock = 0;
+static LCD_GCache_Stats gc_stats;
+
+#define GC_HASH(g, fg, bg)  ((((u32)(uintptr_t)(g) >> 2) ^ (fg) ^ ((u32)(bg) << 3)) & (LCD_GCACHE_HASH - 1))
+
+static void GC_Init(void)
+{
+    u16 i;
+
+    for(i = 0; i < LCD_GCACHE_HASH; i++) gc_head[i] = GC_NONE;
+    for(i = 0; i < LCD_GCACHE_SLOTS; i++) gc_slot[i].glyph = 0;
+
+    gc_stats.slots = LCD_GCACHE_SLOTS;
+    gc_init = 1;
+}
+
+// 从所在桶的链中取下一个槽
+static void GC_Unlink(u8 s)
+{
+    u8 *p = &gc_head[GC_HASH(gc_slot[s].glyph, gc_slot[s].fg, gc_slot[s].bg)];
+
+    while(*p != s) p = &gc_slot[*p].next;
+
+    *p = gc_slot[s].next;
+}
+
+// 取一个槽：空槽，或最久未用的槽
+static u8 GC_Alloc(void)
+{
+    u8 i, v = 0;
+
+    if(gc_stats.used < LCD_GCACHE_SLOTS) return gc_stats.used++;
+
+    for(i = 1; i < LCD_GCACHE_SLOTS; i++)
+        if(gc_clock - gc_slot[i].stamp > gc_clock - gc_slot[v].stamp) v = i;
+
+    GC_Unlink(v);
+    gc_stats.evicts++;
+    return v;
+}
+
+/**
+ * @brief	取展开后的字形像素，未缓存时展开并放入缓存
+ *
+ * @param   glyph	字模地址（逐行、高位在前，每行(size/2+7)/8字节）
+ * @param   size	字号
+ * @param   fg,bg	发送顺序的字体色、背景色
+ *
+ * @return  像素地址（size/2 × size个），字号不缓存时返回0
+ */
+const u16 *LCD_GCache_Get(const u8 *glyph, u8 size, u16 fg, u16 bg)
+{
+    u8 w = size / 2, bpr = (w + 7) / 8;
+    u8 h, s, r;
+    u16 *dst;
+
+    if((u16)w * size * 2 > LCD_GCACHE_SLOT)
+    {
+        gc_stats.bypass++;
+        return 0;
+    }
+
+    if(!gc_init) GC_Init();
+
+    gc_clock++;
+    h = GC_HASH(glyph, fg, bg);
+
+    for(s = gc_head[h]; s != GC_NONE; s = gc_slot[s].next)
+    {
+        if(gc_slot[s].glyph == glyph && gc_slot[s].fg == fg && gc_slot[s].bg == bg)
+        {
+            gc_slot[s].stamp = gc_clock;
+            gc_stats.hits++;
+            return gc_pix[s];
+        }
+    }
+
+    s = GC_Alloc();
+    gc_slot[s].glyph = glyph;
+    gc_slot[s].fg = fg;
+    gc_slot[s].bg = bg;
+    gc_slot[s].stamp = gc_clock;
+    gc_slot[s].next = gc_head[h];
+    gc_head[h] = s;
+
+    for(r = 0, dst = gc_pix[s]; r < size; r++, dst += w)
+        LCD_Band_Glyph_Row(dst, glyph + r * bpr, w, fg, bg);
+
+    gc_stats.misses++;
+    return gc_pix[s];
+}
+
+void LCD_GCache_Get_Stats(LCD_GCache_Stats *st)
+{
+    *st = gc_stats;
+}
+
+// 清除命中计数（缓存内容保留），用于按画面统计命中率
+void LCD_GCache_Reset_Stats(void)
+{
+    gc_stats.hits = 0;
+    gc_stats.misses = 0;
+    gc_stats.evicts = 0;
+    gc_stats.bypass = 0;
+}
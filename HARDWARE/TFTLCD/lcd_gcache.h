@@ -0,0 +1,46 @@
+#ifndef __LCD_GCACHE_H
+#define __LCD_GCACHE_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - LCD字形缓存头文件
+// 功能说明：字模展开后的RGB565像素（发送顺序，高字节在前）按(字号, 字符, 字体色, 背景色)缓存，
+//          分带合成和文字光栅化直接按行复制缓存的像素，不再逐位展开字模
+// 容量：LCD_GCACHE_BYTES固定预算，分为LCD_GCACHE_SLOT字节的槽；一个字形占一个槽，
+//      放不下一个槽的字号（24/32）不缓存；槽满时替换最久未用的字形（LRU）
+// 说明：键中的字符和字号由字模地址表示（tftlcd.c的字库中每个字号、字符的字模地址不同）；
+//      返回的像素在下一次LCD_GCache_Get()之前有效，最近用过的LCD_GCACHE_SLOTS-1个字形不会被替换；
+//      只能在主循环中使用
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+// LCD_GCACHE_BYTES：缓存的RAM预算
+// LCD_GCACHE_SLOT： 每槽字节数（8x16字形256字节，6x12字形144字节）
+// LCD_GCACHE_HASH： 散列表桶数（2的幂）
+#define LCD_GCACHE_BYTES    (12*1024)
+#define LCD_GCACHE_SLOT     256
+#define LCD_GCACHE_HASH     64
+
+#define LCD_GCACHE_SLOTS    (LCD_GCACHE_BYTES/LCD_GCACHE_SLOT)
+
+// 缓存统计：命中率 = hits/(hits+misses)
+typedef struct
+{
+    u32 hits;           // 命中次数
+    u32 misses;         // 未命中（展开字模）次数
+    u32 evicts;         // 替换最久未用字形的次数
+    u32 bypass;         // 字号太大不缓存的次数
+    u16 used;           // 已用槽数
+    u16 slots;          // 总槽数
+} LCD_GCache_Stats;
+
+// ==================== 函数声明 ====================
+// glyph：字模地址；size：字号；fg/bg：发送顺序的颜色
+// 返回：size/2 × size个像素（逐行），字号不缓存时返回0
+const u16 *LCD_GCache_Get(const u8 *glyph, u8 size, u16 fg, u16 bg);
+void LCD_GCache_Get_Stats(LCD_GCache_Stats *st);
+void LCD_GCache_Reset_Stats(void);
+
+#endif
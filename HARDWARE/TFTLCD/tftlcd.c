@@ -3,6 +3,10 @@
 #include "tftlcd.h"
 #include "font.h"
 #include "spi.h"
+#include "spi_dma.h"
+#include "lcd_band.h"
+#include "lcd_gcache.h"
+#include <string.h>
 #include "alientek_log.h"
 
 /*********************************************************************************
@@ -36,6 +40,12 @@ static u8 lcd_buf[LCD_Buf_Size];
 u16	POINT_COLOR = BLACK;	//������ɫ	Ĭ��Ϊ��ɫ
 u16	BACK_COLOR 	= WHITE;	//������ɫ	Ĭ��Ϊ��ɫ
 
+// D/C线控制（SPI1 DMA传输引擎在切换任务时调用）
+static void LCD_DC_Set(u8 level)
+{
+    LCD_WR = level;
+}
+
 /**
  * @brief	LCD���ƽӿڳ�ʼ��
  *
@@ -71,6 +81,7 @@ static void LCD_Gpio_Init(void)
     LCD_RST = 1;
 
     SPI1_Init();	//��ʼ��SPI2�ӿ�
+    SPI1_DMA_Init(LCD_DC_Set);      //SPI1 DMA传输引擎（D/C线由引擎按任务切换）
 
 }
 
@@ -87,6 +98,9 @@ static void LCD_SPI_Send(u8 *data, u16 size)
     SPI1_WriteData(data, size);
 }
 
+// 轮询发送之前：等DMA队列中的任务发送完毕（保证顺序，之后才能改D/C线）
+#define LCD_SPI_Sync()  SPI1_DMA_Flush()
+
 
 /**
  * @brief	д���LCD
@@ -97,6 +111,7 @@ static void LCD_SPI_Send(u8 *data, u16 size)
  */
 static void LCD_Write_Cmd(u8 cmd)
 {
+    LCD_SPI_Sync();
     LCD_WR = 0;
 
     LCD_SPI_Send(&cmd, 1);
@@ -111,6 +126,7 @@ static void LCD_Write_Cmd(u8 cmd)
  */
 static void LCD_Write_Data(u8 data)
 {
+    LCD_SPI_Sync();
     LCD_WR = 1;
 
     LCD_SPI_Send(&data, 1);
@@ -130,6 +146,7 @@ void LCD_Write_HalfWord(const u16 da)
     data[0] = da >> 8;
     data[1] = da;
 
+    LCD_SPI_Sync();
     LCD_WR = 1;
     LCD_SPI_Send(data, 2);
 }
@@ -145,6 +162,29 @@ void LCD_Write_HalfWord(const u16 da)
  */
 void LCD_Address_Set(u16 x1, u16 y1, u16 x2, u16 y2)
 {
+    u8 xa[4], ya[4];
+
+    LCD_Band_Sync();                // 场景中不能记录的绘制：先发送本帧，之后直接发送
+
+    if(SPI1_DMA_Busy())
+    {
+        // DMA队列未空：排在前面的任务之后发送，不等待（引擎空闲时11字节直接轮询更快）
+        xa[0] = x1 >> 8;
+        xa[1] = x1;
+        xa[2] = x2 >> 8;
+        xa[3] = x2;
+        ya[0] = y1 >> 8;
+        ya[1] = y1;
+        ya[2] = y2 >> 8;
+        ya[3] = y2;
+        SPI1_DMA_Cmd(0x2a);
+        SPI1_DMA_Data(xa, 4);
+        SPI1_DMA_Cmd(0x2b);
+        SPI1_DMA_Data(ya, 4);
+        SPI1_DMA_Cmd(0x2C);
+        return;
+    }
+
     LCD_Write_Cmd(0x2a);
     LCD_Write_Data(x1 >> 8);
     LCD_Write_Data(x1);
@@ -192,26 +232,8 @@ void LCD_DisplayOff(void)
  */
 void LCD_Clear(u16 color)
 {
-    u16 i, j;
-    u8 data[2] = {0};
-
-    data[0] = color >> 8;
-    data[1] = color;
-
-    LCD_Address_Set(0, 0, LCD_Width - 1, LCD_Height - 1);
-
-    for(j = 0; j < LCD_Buf_Size / 2; j++)
-    {
-        lcd_buf[j * 2] =  data[0];
-        lcd_buf[j * 2 + 1] =  data[1];
-    }
-
-    LCD_WR = 1;
-
-    for(i = 0; i < (LCD_TOTAL_BUF_SIZE / LCD_Buf_Size); i++)
-    {
-        LCD_SPI_Send(lcd_buf, LCD_Buf_Size);
-    }
+    // 开始新的场景（lcd_band.c），本帧整屏发送：没有其他绘制时为DMA重复填充，CPU不填缓冲区
+    LCD_Band_Rec_Clear(color);
 }
 
 /**
@@ -225,44 +247,15 @@ void LCD_Clear(u16 color)
  */
 void LCD_Fill(u16 x_start, u16 y_start, u16 x_end, u16 y_end, u16 color)
 {
-    u16 i = 0;
-    u32 size = 0, size_remain = 0;
+    u32 size = 0;
 
-    size = (x_end - x_start + 1) * (y_end - y_start + 1) * 2;
+    if(LCD_Band_Rec_Fill(x_start, y_start, x_end, y_end, color)) return;
 
-    if(size > LCD_Buf_Size)
-    {
-        size_remain = size - LCD_Buf_Size;
-        size = LCD_Buf_Size;
-    }
+    size = (x_end - x_start + 1) * (y_end - y_start + 1);
 
+    // DMA重复填充任务，不等待发送完成
     LCD_Address_Set(x_start, y_start, x_end, y_end);
-
-    while(1)
-    {
-        for(i = 0; i < size / 2; i++)
-        {
-            lcd_buf[2 * i] = color >> 8;
-            lcd_buf[2 * i + 1] = color;
-        }
-
-        LCD_WR = 1;
-        LCD_SPI_Send(lcd_buf, size);
-
-        if(size_remain == 0)
-            break;
-
-        if(size_remain > LCD_Buf_Size)
-        {
-            size_remain = size_remain - LCD_Buf_Size;
-        }
-
-        else
-        {
-            size = size_remain;
-            size_remain = 0;
-        }
-    }
+    SPI1_DMA_Fill(color, size, 0, 0);
 }
 
 /**
@@ -317,6 +310,7 @@ void LCD_DrawLine(u16 x1, u16 y1, u16 x2, u16 y2)
             lcd_buf[2 * i + 1] = POINT_COLOR;
         }
 
+        LCD_SPI_Sync();
         LCD_WR = 1;
         LCD_SPI_Send(lcd_buf, (x2 - x1) * 2);
         return;
@@ -427,91 +421,81 @@ void LCD_Draw_Circle(u16 x0, u16 y0, u8 r)
     }
 }
 
-/**
- * @brief	��ʾһ��ASCII���ַ�
- *
- * @param   x,y		��ʾ��ʼ����
- * @param   chr		��Ҫ��ʾ���ַ�
- * @param   size	�����С(֧��16/24/32������)
- *
- * @return  void
- */
-void LCD_ShowChar(u16 x, u16 y, char chr, u8 size)
+// 字模地址（chr为减去' '后的偏移），没有的字号返回0
+static const u8 *LCD_Glyph(u8 chr, u8 size)
 {
-    u8 temp, t1, t;
-    u8 csize;		//�õ�����һ���ַ���Ӧ������ռ���ֽ���
-    u16 colortemp;
-    u8 sta;
-
-    chr = chr - ' '; //�õ�ƫ�ƺ��ֵ��ASCII�ֿ��Ǵӿո�ʼȡģ������-' '���Ƕ�Ӧ�ַ����ֿ⣩
-
-    if((x > (LCD_Width - size / 2)) || (y > (LCD_Height - size)))	return;
-
-    LCD_Address_Set(x, y, x + size / 2 - 1, y + size - 1);//(x,y,x+8-1,y+16-1)
+    if(chr > '~' - ' ') return 0;
 
-    if((size == 16) || (size == 32) )	//16和32字体
+    switch(size)
     {
-        csize = (size / 8 + ((size % 8) ? 1 : 0)) * (size / 2);
+        case 12: return asc2_1206[chr];
+        case 16: return asc2_1608[chr];
+        case 24: return asc2_2412[chr];
+        case 32: return asc2_3216[chr];
+    }
 
-        for(t = 0; t < csize; t++)
-        {
-            if(size == 16)temp = asc2_1608[chr][t];	//调用1608字体
-            else if(size == 32)temp = asc2_3216[chr][t];	//调用3216字体
-            else return;			//没有的字库
+    return 0;
+}
 
-            for(t1 = 0; t1 < 8; t1++)
-            {
-                if(temp & 0x80) colortemp = POINT_COLOR;
-                else colortemp = BACK_COLOR;
+// 同一行的n个字符：一个显示窗口，字模逐行展开到带缓冲区，按块经DMA发送（每块最多LCD_BAND_PIXELS个像素）
+// 场景有效时逐个字符记录（lcd_band.c）；调用方保证字符在屏幕内
+static void LCD_Text(u16 x, u16 y, u8 size, const char *p, u8 n)
+{
+    const u8 *glyph[LCD_Width / 6];
+    const u16 *px[LCD_Width / 6];   //字形缓存中的像素（一行最多40个字符，少于缓存槽数，不会互相替换）
+    u16 fg = LCD_BAND_SWAP(POINT_COLOR), bg = LCD_BAND_SWAP(BACK_COLOR);
+    u16 w = size / 2, lw, rows, r, r_end, k;
+    u16 *dst;
+    u8 bpr = (w + 7) / 8;
+    u8 i, c;
 
-                LCD_Write_HalfWord(colortemp);
-                temp <<= 1;
-            }
-        }
-    }
+    for(i = 0; i < n; i++)
+        if(!(glyph[i] = LCD_Glyph(p[i] - ' ', size))) return;  //没有的字库或非法字符
 
-	else if  (size == 12)	//12������
-	{
-        csize = (size / 8 + ((size % 8) ? 1 : 0)) * (size / 2);
+    for(i = 0; i < n && LCD_Band_Rec_Char(x + i * w, y, size, glyph[i]); i++);
 
-        for(t = 0; t < csize; t++)
-        {
-            temp = asc2_1206[chr][t];
+    if(i == n) return;
 
-            for(t1 = 0; t1 < 6; t1++)
-            {
-                if(temp & 0x80) colortemp = POINT_COLOR;
-                else colortemp = BACK_COLOR;
+    x += i * w;                     //场景不再记录时，余下的字符直接发送
+    lw = (n - i) * w;
+    rows = LCD_BAND_PIXELS / lw;
 
-                LCD_Write_HalfWord(colortemp);
-                temp <<= 1;
-            }
-        }
-    }
-	
-    else if(size == 24)		//24字体
-    {
-        csize = (size * 16) / 8;
+    for(c = i; c < n; c++) px[c] = LCD_GCache_Get(glyph[c], size, fg, bg);
 
-        for(t = 0; t < csize; t++)
-        {
-            temp = asc2_2412[chr][t];
+    LCD_Address_Set(x, y, x + lw - 1, y + size - 1);
 
-            if(t % 2 == 0)sta = 8;
-            else sta = 4;
+    for(r = 0; r < size; r = r_end)
+    {
+        r_end = r + rows < size ? r + rows : size;
+        dst = LCD_Band_Buf();
 
-            for(t1 = 0; t1 < sta; t1++)
+        for(k = r; k < r_end; k++)
+            for(c = i; c < n; c++, dst += w)
             {
-                if(temp & 0x80) colortemp = POINT_COLOR;
-                else colortemp = BACK_COLOR;
-
-                LCD_Write_HalfWord(colortemp);
-                temp <<= 1;
+                if(px[c]) memcpy(dst, px[c] + k * w, w * 2);
+                else LCD_Band_Glyph_Row(dst, glyph[c] + k * bpr, w, fg, bg);
             }
-        }
+
+        LCD_Band_Send_Buf((u32)(r_end - r) * lw);
     }
 }
 
+/**
+ * @brief	��ʾһ��ASCII���ַ�
+ *
+ * @param   x,y		��ʾ��ʼ����
+ * @param   chr		��Ҫ��ʾ���ַ�
+ * @param   size	�����С(֧��16/24/32������)
+ *
+ * @return  void
+ */
+void LCD_ShowChar(u16 x, u16 y, char chr, u8 size)
+{
+    if((x > (LCD_Width - size / 2)) || (y > (LCD_Height - size)))	return;
+
+    LCD_Text(x, y, size, &chr, 1);
+}
+
 /**
  * @brief	m^n����
  *
@@ -617,6 +601,9 @@ void LCD_ShowxNum(u16 x, u16 y, u32 num, u8 len, u8 size, u8 mode)
 void LCD_ShowString(u16 x, u16 y, u16 width, u16 height, u8 size, char *p)
 {
     u8 x0 = x;
+    u16 sx = x, sy = y;     //同一行待发送字符的起点
+    char *s = p;
+    u8 n = 0, in;
     width += x;
     height += y;
 
@@ -630,10 +617,32 @@ void LCD_ShowString(u16 x, u16 y, u16 width, u16 height, u8 size, char *p)
 
         if(y >= height)break; //�˳�
 
-        LCD_ShowChar(x, y, *p, size);
+        //同一行连续的字符攒成一个窗口发送；换行或超出屏幕（LCD_ShowChar不显示）时发送已攒下的
+        in = (x <= (LCD_Width - size / 2)) && (y <= (LCD_Height - size));
+
+        if(n && (!in || y != sy))
+        {
+            LCD_Text(sx, sy, size, s, n);
+            n = 0;
+        }
+
+        if(in)
+        {
+            if(n == 0)
+            {
+                s = p;
+                sx = x;
+                sy = y;
+            }
+
+            n++;
+        }
+
         x += size / 2;
         p++;
     }
+
+    if(n) LCD_Text(sx, sy, size, s, n);
 }
 
 
@@ -656,11 +665,12 @@ void LCD_Show_Image(u16 x, u16 y, u16 width, u16 height, const u8 *p)
         return;
     }
 
-    LCD_Address_Set(x, y, x + width - 1, y + height - 1);
+    if(LCD_Band_Rec_Image(x, y, width, height, p)) return;
 
-    LCD_WR = 1;
+    LCD_Address_Set(x, y, x + width - 1, y + height - 1);
 
-    LCD_SPI_Send((u8 *)p, width * height * 2);
+    // 图片在Flash中，DMA直接按指针发送，不等待发送完成
+    SPI1_DMA_Burst(p, (u32)width * height * 2, 0, 0);
 }
 
 /**
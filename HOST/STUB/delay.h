@@ -0,0 +1,13 @@
+#ifndef __DELAY_H
+#define __DELAY_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机仿真用delay.h替身
+// 说明：仿真中不做忙等，延时通过推进虚拟时间实现（见sim_mcu.h）
+//////////////////////////////////////////////////////////////////////////////////
+
+void delay_init(u8 SYSCLK);
+void delay_ms(u16 nms);
+void delay_us(u32 nus);
+
+#endif
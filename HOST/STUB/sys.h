@@ -0,0 +1,333 @@
+#ifndef __SYS_H
+#define __SYS_H
+#include <stdint.h>
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机仿真用sys.h替身
+// 功能说明：在Linux上编译USER/remote.c和USER/ir_decode.c时代替SYSTEM/sys/sys.h
+//          提供基本类型、TIM1/TIM2/TIM3/DMA/SysTick寄存器模型和用到的HAL库宏与函数声明
+//          寄存器由sim_mcu.c按虚拟时间驱动，GPIO/SPI/UART由sim_board.c模拟，固件源码无需任何修改
+// 说明：只实现红外收发、LED、LCD和主程序用到的部分，新增固件依赖时在这里补充
+//////////////////////////////////////////////////////////////////////////////////
+
+typedef int32_t  s32;
+typedef int16_t  s16;
+typedef int8_t   s8;
+
+typedef uint32_t u32;
+typedef uint16_t u16;
+typedef uint8_t  u8;
+
+typedef volatile uint32_t vu32;
+typedef volatile uint16_t vu16;
+typedef volatile uint8_t  vu8;
+
+// ==================== 寄存器模型 ====================
+typedef struct
+{
+    volatile u32 CR1,SR,DIER,EGR,CCMR1,CCER,CNT,PSC,ARR,RCR;
+    volatile u32 CCR1,CCR2,CCR3,CCR4;
+    volatile u32 BDTR,DCR,DMAR;
+} TIM_TypeDef;
+
+typedef struct
+{
+    volatile u32 CTRL,LOAD,VAL,CALIB;
+} SysTick_Type;
+
+// SPI1：DMA传输引擎（spi_dma.c）只读写CR1/CR2/SR，数据由DMA2_Stream3模型交给sim_board.c
+typedef struct
+{
+    volatile u32 CR1,CR2,SR,DR;
+} SPI_TypeDef;
+
+// DWT周期计数器：每次访问DWT时由Sim_DWT()把CYCCNT更新为主机时钟（ns），
+// 固件中的中断耗时统计在主机上即为主机耗时（ns）
+typedef struct
+{
+    volatile u32 CTRL,CYCCNT;
+} DWT_Type;
+
+typedef struct
+{
+    volatile u32 DEMCR;
+} CoreDebug_Type;
+
+#define DWT_CTRL_CYCCNTENA_Msk          (1U<<0)
+#define CoreDebug_DEMCR_TRCENA_Msk      (1U<<24)
+
+extern TIM_TypeDef  sim_tim1;
+extern TIM_TypeDef  sim_tim2;
+extern TIM_TypeDef  sim_tim3;
+extern SysTick_Type sim_systick;
+extern CoreDebug_Type sim_coredebug;
+extern SPI_TypeDef  sim_spi1;           // sim_board.c
+DWT_Type *Sim_DWT(void);
+extern u8 sim_rdata[4];                 // 各红外接收头输出电平（TIM3_CH1~CH4）
+
+#define TIM1        (&sim_tim1)
+#define TIM2        (&sim_tim2)
+#define SPI1        (&sim_spi1)
+#define TIM3        (&sim_tim3)
+#define SysTick     (&sim_systick)
+#define DWT         (Sim_DWT())
+#define CoreDebug   (&sim_coredebug)
+#define PBin(n)     sim_rdata[2]
+
+// 延迟追踪（lat_trace.h）的时间戳按虚拟时间计（96MHz周期），不用主机时钟的DWT替身
+u32 Sim_Cycles(void);
+#define LAT_CYCLES()    Sim_Cycles()
+
+// SPI1 DMA传输引擎等待任务完成时推进虚拟时间（忙等按主程序CPU时间计）
+void Sim_Cpu(u32 ns);
+#define SPI_DMA_IDLE()  Sim_Cpu(1000)
+
+// GPIO输出位（位带别名）：LCD控制线PA2/3/4/6和LED PC0~7，由sim_board.c观察
+extern u8 sim_gpio_out[3][16];          // [GPIOA/GPIOB/GPIOC][引脚]
+#define PAout(n)    sim_gpio_out[0][n]
+#define PCout(n)    sim_gpio_out[2][n]
+
+// 片内Flash：信号库扇区映射到主机数组（擦除值0xFF，编程只能把1写成0）
+const void *Sim_Flash_Mem(u32 addr);
+#define IR_LIB_FLASH_ADDR   0x08020000UL
+#define IR_LIB_FLASH_SECTOR FLASH_SECTOR_5
+#define IR_LIB_FLASH_SIZE   0x20000UL
+#define IR_LIB_MEM(addr)    Sim_Flash_Mem(addr)
+
+// ==================== HAL库类型 ====================
+typedef struct
+{
+    u32 Prescaler,CounterMode,Period,ClockDivision,RepetitionCounter;
+} TIM_Base_InitTypeDef;
+
+typedef struct
+{
+    u32 ICPolarity,ICSelection,ICPrescaler,ICFilter;
+} TIM_IC_InitTypeDef;
+
+typedef struct
+{
+    u32 OCMode,Pulse,OCPolarity,OCNPolarity,OCFastMode,OCIdleState,OCNIdleState;
+} TIM_OC_InitTypeDef;
+
+typedef struct
+{
+    u32 Channel,Direction,PeriphInc,MemInc,PeriphDataAlignment,MemDataAlignment,Mode,Priority,FIFOMode;
+} DMA_InitTypeDef;
+
+typedef struct __DMA_HandleTypeDef
+{
+    void *Instance;
+    DMA_InitTypeDef Init;
+    void (*XferHalfCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferCpltCallback)(struct __DMA_HandleTypeDef *hdma);
+    void (*XferErrorCallback)(struct __DMA_HandleTypeDef *hdma);
+    void *Parent;
+    u32 SrcAddress;                     // 仿真：源地址（捕获为外设地址，发射为包络表）
+    u32 DstAddress;                     // 仿真：存储器地址（主机上为指针低32位，仅作记录）
+    u16 *Dst;                           // 仿真：目标缓冲区
+    u32 Length;                         // 仿真：传输长度
+    volatile u32 NDTR;                  // 仿真：剩余传输个数
+    volatile u32 Pending;               // 仿真：1=半满，2=全满
+} DMA_HandleTypeDef;
+
+typedef struct
+{
+    u32 dummy;
+} DMA_Stream_TypeDef;
+
+extern DMA_Stream_TypeDef sim_dma2_stream3;
+
+typedef int IRQn_Type;
+
+typedef enum { HAL_OK=0, HAL_ERROR=1 } HAL_StatusTypeDef;
+
+typedef struct
+{
+    u32 TypeErase,Banks,Sector,NbSectors,VoltageRange;
+} FLASH_EraseInitTypeDef;
+
+typedef struct
+{
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+    DMA_HandleTypeDef *hdma[7];
+} TIM_HandleTypeDef;
+
+typedef struct
+{
+    u32 Pin,Mode,Pull,Speed,Alternate;
+} GPIO_InitTypeDef;
+
+typedef enum { GPIO_PIN_RESET=0, GPIO_PIN_SET } GPIO_PinState;
+
+typedef struct
+{
+    void *Instance;
+    DMA_HandleTypeDef *hdmatx;
+} SPI_HandleTypeDef;
+
+typedef struct
+{
+    void *Instance;
+} UART_HandleTypeDef;
+
+// ==================== HAL库常量 ====================
+#define TIM_COUNTERMODE_UP          0
+#define TIM_CLOCKDIVISION_DIV1      0
+#define TIM_ICPOLARITY_RISING       0
+#define TIM_ICPOLARITY_FALLING      2
+#define TIM_ICPOLARITY_BOTHEDGE     10
+#define TIM_ICSELECTION_DIRECTTI    1
+#define TIM_ICPSC_DIV1              0
+#define TIM_CHANNEL_1               0x00
+#define TIM_CHANNEL_2               0x04
+#define TIM_CHANNEL_3               0x08
+#define TIM_CHANNEL_4               0x0C
+#define TIM_DMA_CC1                 (1U<<9)
+#define TIM_DMA_CC2                 (1U<<10)
+#define TIM_DMA_CC3                 (1U<<11)
+#define TIM_DMA_CC4                 (1U<<12)
+#define TIM_DMA_ID_CC1              1
+#define TIM_DMA_ID_CC2              2
+#define TIM_DMA_ID_CC3              3
+#define TIM_DMA_ID_CC4              4
+#define TIM_DMA_ID_UPDATE           0
+#define TIM_FLAG_UPDATE             (1U<<0)
+#define TIM_IT_UPDATE               (1U<<0)
+#define TIM_EVENTSOURCE_UPDATE      (1U<<0)
+#define TIM_OCMODE_PWM1             0x60
+#define TIM_OCPOLARITY_HIGH         0
+#define TIM_OCNPOLARITY_HIGH        0
+#define TIM_OCFAST_DISABLE          0
+#define TIM_OCIDLESTATE_RESET       0
+#define TIM_OCNIDLESTATE_RESET      0
+#define TIM_DMABASE_RCR             0x0C
+#define TIM_DMABURSTLENGTH_2TRANSFERS 0x100
+
+#define TIM_CR1_CEN                 (1U<<0)
+#define TIM_CR1_URS                 (1U<<2)
+#define TIM_DIER_UDE                (1U<<8)
+#define TIM_CCER_CC1E               (1U<<0)
+#define TIM_CCx_ENABLE              1U
+#define TIM_CCx_DISABLE             0U
+#define TIM_BDTR_MOE                (1U<<15)
+
+#define DMA_CHANNEL_3               0
+#define DMA_CHANNEL_5               0
+#define DMA_CHANNEL_6               0
+#define DMA_PERIPH_TO_MEMORY        0
+#define DMA_MEMORY_TO_PERIPH        1
+#define DMA_PINC_DISABLE            0
+#define DMA_MINC_DISABLE            0
+#define DMA_MINC_ENABLE             (1U<<10)
+#define DMA_PDATAALIGN_BYTE         0
+#define DMA_PDATAALIGN_HALFWORD     (1U<<11)
+#define DMA_MDATAALIGN_BYTE         0
+#define DMA_MDATAALIGN_HALFWORD     (1U<<13)
+#define DMA_CIRCULAR                0
+#define DMA_NORMAL                  0
+#define DMA_PRIORITY_HIGH           0
+#define DMA_PRIORITY_MEDIUM         0
+#define DMA_PRIORITY_LOW            0
+#define DMA_FIFOMODE_DISABLE        0
+
+#define SPI_CR1_SPE                 (1U<<6)
+#define SPI_CR1_DFF                 (1U<<11)
+#define SPI_CR2_TXDMAEN             (1U<<1)
+#define SPI_SR_TXE                  (1U<<1)
+#define SPI_SR_BSY                  (1U<<7)
+
+#define GPIO_PIN_0                  (1U<<0)
+#define GPIO_PIN_1                  (1U<<1)
+#define GPIO_PIN_2                  (1U<<2)
+#define GPIO_PIN_3                  (1U<<3)
+#define GPIO_PIN_4                  (1U<<4)
+#define GPIO_PIN_5                  (1U<<5)
+#define GPIO_PIN_6                  (1U<<6)
+#define GPIO_PIN_7                  (1U<<7)
+#define GPIO_PIN_8                  (1U<<8)
+#define GPIO_MODE_AF_PP             0
+#define GPIO_MODE_OUTPUT_PP         1
+#define GPIO_PULLUP                 0
+#define GPIO_PULLDOWN               0
+#define GPIO_SPEED_HIGH             0
+#define GPIO_AF1_TIM1               1
+#define GPIO_AF2_TIM3               2
+
+#define FLASH_TYPEPROGRAM_BYTE      0
+#define FLASH_TYPEPROGRAM_WORD      2
+#define FLASH_TYPEERASE_SECTORS     0
+#define FLASH_SECTOR_5              5
+#define FLASH_VOLTAGE_RANGE_3       2
+
+#define GPIOA                       ((void*)0)      // 端口编号，sim_gpio_out[]的下标
+#define GPIOB                       ((void*)1)
+#define GPIOC                       ((void*)2)
+#define DMA1_Stream2                ((DMA_Stream_TypeDef*)0)
+#define DMA1_Stream4                ((DMA_Stream_TypeDef*)0)
+#define DMA1_Stream5                ((DMA_Stream_TypeDef*)0)
+#define DMA1_Stream7                ((DMA_Stream_TypeDef*)0)
+#define DMA2_Stream5                ((DMA_Stream_TypeDef*)0)
+#define DMA2_Stream3                (&sim_dma2_stream3)     // SPI1_TX：sim_board.c按实例识别
+#define DMA1_Stream2_IRQn           13
+#define DMA1_Stream4_IRQn           15
+#define DMA1_Stream5_IRQn           16
+#define DMA1_Stream7_IRQn           47
+#define DMA2_Stream3_IRQn           59
+#define DMA2_Stream5_IRQn           68
+#define TIM1_UP_TIM10_IRQn          25
+#define TIM2_IRQn                   28
+#define TIM3_IRQn                   29
+#define SysTick_IRQn                (-1)
+#define PendSV_IRQn                 (-2)
+
+// ==================== HAL库宏 ====================
+#define __HAL_RCC_TIM1_CLK_ENABLE()
+#define __HAL_RCC_TIM2_CLK_ENABLE()
+#define __HAL_RCC_TIM3_CLK_ENABLE()
+#define __HAL_RCC_GPIOA_CLK_ENABLE()
+#define __HAL_RCC_GPIOB_CLK_ENABLE()
+#define __HAL_RCC_GPIOC_CLK_ENABLE()
+#define __HAL_RCC_DMA1_CLK_ENABLE()
+#define __HAL_RCC_DMA2_CLK_ENABLE()
+#define __HAL_LINKDMA(h,f,d)            do{(h)->f=&(d);(d).Parent=(h);}while(0)
+#define __HAL_TIM_ENABLE_DMA(h,x)       ((h)->Instance->DIER|=(x))
+#define __HAL_TIM_ENABLE_IT(h,x)        ((h)->Instance->DIER|=(x))
+#define __HAL_TIM_DISABLE_IT(h,x)       ((h)->Instance->DIER&=~(x))
+#define __HAL_TIM_GET_FLAG(h,f)         (((h)->Instance->SR&(f))==(f))
+#define __HAL_TIM_CLEAR_FLAG(h,f)       ((h)->Instance->SR&=~(f))
+#define __HAL_TIM_GET_COUNTER(h)        ((h)->Instance->CNT)
+#define __HAL_DMA_GET_COUNTER(h)        ((h)->NDTR)
+
+#define __DMB()                         __sync_synchronize()
+#define __disable_irq()
+#define __enable_irq()
+
+void HAL_TIM_IC_Init(TIM_HandleTypeDef *htim);
+void HAL_TIM_IC_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim,TIM_IC_InitTypeDef *cfg,u32 channel);
+void HAL_TIM_IC_Start(TIM_HandleTypeDef *htim,u32 channel);
+void TIM_CCxChannelCmd(TIM_TypeDef *tim,u32 channel,u32 state);
+void HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim);
+void HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim,TIM_OC_InitTypeDef *cfg,u32 channel);
+void HAL_TIM_GenerateEvent(TIM_HandleTypeDef *htim,u32 source);
+void HAL_DMA_Init(DMA_HandleTypeDef *hdma);
+void HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma,u32 src,u32 dst,u32 len);
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma);
+void HAL_GPIO_Init(void *port,GPIO_InitTypeDef *init);
+void HAL_GPIO_WritePin(void *port,u32 pin,GPIO_PinState state);
+void HAL_NVIC_SetPriority(IRQn_Type irq,u32 pre,u32 sub);
+void HAL_NVIC_EnableIRQ(IRQn_Type irq);
+u32  HAL_GetTick(void);
+void HAL_Init(void);
+void Stm32_Clock_Init(u32 plln,u32 pllm,u32 pllp,u32 pllq);
+HAL_StatusTypeDef HAL_FLASH_Unlock(void);
+HAL_StatusTypeDef HAL_FLASH_Lock(void);
+HAL_StatusTypeDef HAL_FLASH_Program(u32 type,u32 addr,uint64_t data);
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *init,u32 *err);
+
+#endif
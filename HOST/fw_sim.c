@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <setjmp.h>
+#include "sim_mcu.h"
+#include "sim_board.h"
+#include "remote.h"
+#include "spi_dma.h"
+#include "lcd_band.h"
+#include "lcd_gcache.h"
+#include "ui_widget.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机整机虚拟时间仿真
+// 功能说明：未修改的USER/main.c（编译为fw_main）连同LCD、LED软件PWM、红外收发驱动在sim_mcu.c的
+//          离散事件模型中运行：SysTick/PendSV/TIM2/TIM3/捕获DMA中断按固件设置的NVIC优先级抢占，
+//          串口和SPI轮询发送按波特率占用主程序CPU，SPI1 DMA按SCK速率在后台传输，
+//          虚拟时间只在事件之间跳跃，运行速度远快于实时
+// 激励：REMOTE_ID遥控器的NEC按键（随机按键、随机按住时长，重复码周期108ms），
+//      每次按下应在串口输出一行"Key Value"；按键结束后经串口发送"lat"命令读取延迟追踪统计
+// 输出：虚拟/主机耗时、按键收发数、串口和SPI占用时间、SPI DMA任务统计、分带合成/局部刷新统计、字形缓存命中率、控件重画统计、各中断的延迟、执行时间、抢占次数和CPU负载，
+//      固件打印的按键到显示延迟直方图
+// 用法：fw_sim [-d 虚拟秒数] [-s 随机种子] [-x 中断耗时倍数] [-v]
+//      -x：中断执行时间 = 进入开销 + 主机耗时×倍数（主机比96MHz Cortex-M4快的倍数，0=只计进入开销）
+//      -v：回显固件的串口输出
+// 返回值：有按键没有被主程序处理、串口命令没有响应或SPI DMA传输中有轮询发送时返回1
+//////////////////////////////////////////////////////////////////////////////////
+
+#define SEG_MAX     512
+
+typedef struct
+{
+	u8  mark;           // 1=载波，0=间隔
+	u32 us;
+} Segment;
+
+// 主程序处理的按键（Process_Remote_Key中有功能的按键）
+static const u8 keys[]=
+{
+	KEY_NUM0,KEY_NUM1,KEY_NUM2,KEY_NUM3,KEY_NUM4,KEY_NUM5,KEY_NUM6,KEY_NUM7,KEY_NUM8,KEY_NUM9,
+	KEY_UP,KEY_DOWN,KEY_POWER,KEY_DELETE,
+};
+#define KEYS_N  (sizeof(keys)/sizeof(keys[0]))
+
+static u32 rng_state=1;
+static Segment seg[SEG_MAX];
+static u32 seg_n=0,seg_i=0;
+static unsigned long long src_end=0;    // 不再开始新按键的时刻（us）
+static u32 sent=0,repeats=0,got=0;
+static char lat_out[4096];              // 固件对"lat"命令的输出
+static u32 lat_len=0;
+
+static u32 Rand(void)
+{
+	rng_state^=rng_state<<13;
+	rng_state^=rng_state>>17;
+	rng_state^=rng_state<<5;
+	return rng_state;
+}
+
+static void Seg_Add(u8 mark,u32 us)
+{
+	if(seg_n<SEG_MAX)
+	{
+		seg[seg_n].mark=mark;
+		seg[seg_n].us=us;
+		seg_n++;
+	}
+}
+
+// 一次按键：NEC帧 + rpt个重复码（帧周期108ms），最后松开
+static void Gen_Press(u8 cmd,u32 rpt)
+{
+	u32 data=((u32)REMOTE_ID<<24)|((u32)(u8)~REMOTE_ID<<16)|((u32)cmd<<8)|(u8)~cmd;
+	u32 i,len=0;
+
+	seg_n=seg_i=0;
+	Seg_Add(1,9000);
+	Seg_Add(0,4500);
+	for(i=0;i<32;i++)
+	{
+		Seg_Add(1,560);
+		Seg_Add(0,(data>>(31-i))&1?1690:560);
+	}
+	Seg_Add(1,560);
+	for(i=0;i<seg_n;i++) len+=seg[i].us;
+	for(i=0;i<rpt;i++)
+	{
+		Seg_Add(0,108000-len);
+		Seg_Add(1,9000);
+		Seg_Add(0,2250);
+		Seg_Add(1,560);
+		len=9000+2250+560;
+	}
+	Seg_Add(0,108000-len);
+}
+
+// 按键结束后经串口查询延迟统计
+static void Lat_Query(void)
+{
+	Sim_Uart_Rx("lat");
+}
+
+// 外部激励：每次调用输出一个电平段的起始边沿，并安排下一次调用
+static void Key_Source(void)
+{
+	u32 rpt;
+
+	if(seg_i<seg_n)
+	{
+		Sim_Edge(seg[seg_i].mark?0:1);  // 载波期间接收头输出低电平
+		Sim_Source(Key_Source,Sim_Now()+seg[seg_i].us);
+		seg_i++;
+		return;
+	}
+	if(Sim_Now()>=src_end)
+	{
+		Sim_Source(Lat_Query,Sim_Now()+500000);
+		return;
+	}
+	rpt=(Rand()&3)?Rand()%2:5+Rand()%20;  // 多数为短按，约1/4按住0.5~2.7s
+	Gen_Press(keys[Rand()%KEYS_N],rpt);
+	sent++;
+	repeats+=rpt;
+	Sim_Source(Key_Source,Sim_Now()+300000+Rand()%1200000);   // 松开后间隔300~1500ms
+}
+
+// 串口输出的一行：每次按下输出一行"Key Value: ..."（长按重复行带[Repeat]）
+static void Uart_Line(const char *s)
+{
+	if(!strncmp(s,"Key Value",9)&&!strstr(s,"[Repeat]")) got++;
+	if(!strncmp(s,"[LAT]",5)) lat_len+=snprintf(lat_out+lat_len,sizeof(lat_out)-lat_len,"  %s\n",s+6);
+	if(lat_len>=sizeof(lat_out)) lat_len=sizeof(lat_out)-1;
+}
+
+int fw_main(void);
+
+int main(int argc,char **argv)
+{
+	static jmp_buf jb;
+	u32 secs=30,verbose=0,seed=1;
+	unsigned long long t0,ns,vt;
+	SPI_DMA_Stats dma;
+	LCD_Band_Stats band;
+	LCD_GCache_Stats gc;
+	UI_Stats ui;
+	int i;
+
+	sim_cpu_scale=40;
+	for(i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i],"-d")&&i+1<argc) secs=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-s")&&i+1<argc) seed=(u32)strtoul(argv[++i],0,0);
+		else if(!strcmp(argv[i],"-x")&&i+1<argc) sim_cpu_scale=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-v")) verbose=1;
+		else
+		{
+			fprintf(stderr,"usage: %s [-d seconds] [-s seed] [-x irq_cost_scale] [-v]\n",argv[0]);
+			return 2;
+		}
+	}
+	if(secs<5) secs=5;
+	rng_state=seed|1;
+
+	Sim_Reset();
+	Sim_Board_Reset(Uart_Line,(u8)verbose);
+	src_end=(unsigned long long)secs*1000000-4000000;  // 最后一次按住最长2.7s，之后查询延迟统计
+	Sim_Source(Key_Source,500000);      // 开机画面之后开始按键
+	t0=Sim_Host_Ns();
+	if(!setjmp(jb))
+	{
+		Sim_Stop_At((unsigned long long)secs*1000000,&jb);
+		fw_main();
+	}
+	ns=Sim_Host_Ns()-t0;
+	Sim_Board_Close();
+
+	vt=Sim_Now();
+	printf("fw_sim: %.3f s virtual in %.3f s host (%.0fx real time), seed %u, irq cost = entry + host x %u\n",
+	       vt/1e6,ns/1e9,ns?vt*1e3/ns:0.0,seed,sim_cpu_scale);
+	printf("  keys  : %u presses sent, %u processed, %u repeat frames\n",sent,got,repeats);
+	printf("  uart  : %u chars, %u lines, %.1f ms blocking\n",sim_board.uart_chars,sim_board.uart_lines,sim_board.uart_ns/1e6);
+	printf("  spi   : %u bytes polled, %.1f ms blocking; %u bytes dma, %.1f ms on the wire (%u lcd cmds, %u pixels)\n",
+	       sim_board.spi_bytes,sim_board.spi_ns/1e6,sim_board.spi_dma_bytes,sim_board.spi_dma_ns/1e6,
+	       sim_board.lcd_cmds,sim_board.lcd_pixels);
+	SPI1_DMA_Get_Stats(&dma);
+	printf("  dma   : %u jobs, %u irqs, queue depth max %u, %u full waits, %u errors, %u polled-while-busy\n",
+	       dma.jobs,dma.irqs,dma.depth_max,dma.full_waits,dma.errors,sim_board.spi_collisions);
+	LCD_Band_Get_Stats(&band);
+	printf("  band  : %u frames (%u full), %u rects, %u pixels, %u unchanged skipped, %u bands, %u buffer stalls, %u spills, max %u items\n",
+	       band.frames,band.pages,band.rects,band.pixels,band.skips,band.bands,band.stalls,band.spills,band.items_max);
+	LCD_GCache_Get_Stats(&gc);
+	printf("  glyph : %u hits, %u misses (%.1f%% hit), %u evictions, %u uncached, %u/%u slots\n",
+	       gc.hits,gc.misses,gc.hits+gc.misses?gc.hits*100.0/(gc.hits+gc.misses):0.0,gc.evicts,gc.bypass,gc.used,gc.slots);
+	UI_Get_Stats(&ui);
+	printf("  ui    : %u page shows, %u updates, %u widgets redrawn\n",ui.shows,ui.updates,ui.redraws);
+	Sim_Print_Irq();
+	printf("%s",lat_out);
+	return got!=sent||!lat_len||sim_board.spi_collisions;
+}
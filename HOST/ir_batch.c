@@ -0,0 +1,326 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#if defined(__SSE2__)&&!defined(IR_BATCH_NO_SIMD)
+#include <emmintrin.h>
+#define IR_BATCH_SSE2   1
+#else
+#define IR_BATCH_SSE2   0
+#endif
+#include "remote.h"
+#include "ir_decode.h"
+#include "ir_capture.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机离线批量解码
+// 功能说明：现场采集的边沿时间戳日志直接用固件的ir_decode.c批量解码，输出解码帧、
+//          错误统计和载波/间隔宽度直方图，用于分析现场的遥控器和干扰
+// 文件格式：见ir_capture.h
+//   带文件头：Cap_Header（"IRCP"、版本1、时间戳宽度2或4字节、每计数ns）+ 时间戳
+//   无文件头：u32时间戳，1us/计数；-16表示u16时间戳（直接转存的DMA捕获缓冲区，
+//            超过65.536ms的间隔会回绕，只适合连续的按键波形）
+// 处理流程：文件整体mmap，按块处理：
+//   1. 向量化（SSE2，每次8个边沿）：相邻时间戳相减得到电平段宽度，同时算出直方图分箱号
+//   2. 标量：直方图计数，与remote.c相同的毛刺合并（短于-g us的电平段并入前一段），
+//            送入IR_Decoder_Feed()，长于IR_IDLE_MS的间隔按线路空闲处理
+// 用法：ir_batch [-16] [-g 毛刺us] [-q] [-H] 文件...
+//   -q 不输出逐帧结果，-H 不输出直方图
+//////////////////////////////////////////////////////////////////////////////////
+
+#define CHUNK           4096        // 每块边沿数（8的倍数）
+#define HIST_BIN_US     50          // 直方图分箱宽度
+#define HIST_BINS       200         // 0~10ms，另加一个溢出箱
+
+typedef struct
+{
+	IR_Decoder dec;
+	unsigned long long t;           // 当前边沿的时间（us，64位）
+	unsigned long long pend_t;      // 待定电平段的开始时间
+	u32 pend_dur;                   // 待定电平段宽度（已并入的毛刺和后续部分）
+	u8  pend;                       // 1=有待定电平段
+	u8  pend_mark;
+	u8  cont;                       // 1=下一个电平段是毛刺之后待定段的延续
+	u8  idle;                       // 1=线路空闲（下一个载波前没有待定段）
+	u8  skip;                       // 1=空闲中的孤立脉冲之后的间隔，按空闲时间计入
+	u32 glitch_us;
+	u32 glitches;
+	u32 idle_timeouts;
+	u32 frames[IR_PROTO_COUNT+1][2];// 各协议的首帧/重复帧数
+	unsigned long long edges;
+	unsigned long long hist[2][HIST_BINS+1];  // [0]=间隔，[1]=载波
+} Batch;
+
+static u8 quiet=0;
+
+static unsigned long long Host_Ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (unsigned long long)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+// ==================== 向量化：电平段宽度与分箱 ====================
+// 参数：ts    - 时间戳（第i个电平段为ts[i-1]~ts[i]，ts[-1]必须可读）
+//      width - 时间戳宽度（2/4字节）
+//      n     - 电平段数
+//      dur   - 输出：宽度（计数）
+//      bin   - 输出：直方图分箱号（0~HIST_BINS）
+// 说明：分箱按us计算，scale为每计数的us数
+static void Chunk_Durations(const u8 *ts,u32 width,u32 n,float scale,u32 *dur,u8 *bin)
+{
+	u32 i=0,d;
+#if IR_BATCH_SSE2
+	const __m128 k=_mm_set1_ps(scale/HIST_BIN_US);
+	const __m128 lim=_mm_set1_ps((float)HIST_BINS);
+	const __m128i zero=_mm_setzero_si128();
+	__m128i a,b,d0,d1;
+	__m128 f0,f1;
+
+	for(;i+8<=n;i+=8)
+	{
+		if(width==4)
+		{
+			const u32 *p=(const u32*)ts+i;
+			d0=_mm_sub_epi32(_mm_loadu_si128((const __m128i*)p),_mm_loadu_si128((const __m128i*)(p-1)));
+			d1=_mm_sub_epi32(_mm_loadu_si128((const __m128i*)(p+4)),_mm_loadu_si128((const __m128i*)(p+3)));
+		}
+		else
+		{
+			const u16 *p=(const u16*)ts+i;
+			a=_mm_sub_epi16(_mm_loadu_si128((const __m128i*)p),_mm_loadu_si128((const __m128i*)(p-1)));
+			d0=_mm_unpacklo_epi16(a,zero);      // 回绕差值零扩展为32位
+			d1=_mm_unpackhi_epi16(a,zero);
+		}
+		_mm_storeu_si128((__m128i*)(dur+i),d0);
+		_mm_storeu_si128((__m128i*)(dur+i+4),d1);
+
+		// 分箱：超过2^31的宽度（有符号转换为负数）先改为最大值，再按浮点缩放、截断、限幅
+		f0=_mm_cvtepi32_ps(_mm_andnot_si128(_mm_srai_epi32(d0,31),d0));
+		f1=_mm_cvtepi32_ps(_mm_andnot_si128(_mm_srai_epi32(d1,31),d1));
+		f0=_mm_or_ps(_mm_min_ps(_mm_mul_ps(f0,k),lim),_mm_and_ps(_mm_castsi128_ps(_mm_srai_epi32(d0,31)),lim));
+		f1=_mm_or_ps(_mm_min_ps(_mm_mul_ps(f1,k),lim),_mm_and_ps(_mm_castsi128_ps(_mm_srai_epi32(d1,31)),lim));
+		b=_mm_packs_epi32(_mm_cvttps_epi32(f0),_mm_cvttps_epi32(f1));
+		_mm_storel_epi64((__m128i*)(bin+i),_mm_packus_epi16(b,b));
+	}
+#endif
+	for(;i<n;i++)
+	{
+		if(width==4) d=((const u32*)ts+i)[0]-((const u32*)ts+i)[-1];
+		else d=(u16)(((const u16*)ts+i)[0]-((const u16*)ts+i)[-1]);
+		dur[i]=d;
+		bin[i]=(d>=0x80000000UL||d*scale>=HIST_BINS*HIST_BIN_US)?HIST_BINS:(u8)(u32)(d*scale/HIST_BIN_US);
+	}
+}
+
+// ==================== 标量：毛刺合并与解码 ====================
+static void Batch_Feed(Batch *b,u8 mark,u32 dur,unsigned long long start)
+{
+	IR_Frame f;
+	u8 busy=0,idle;
+
+	idle=(!mark&&dur>IR_IDLE_MS*1000UL);
+	if(idle) busy=IR_Decoder_Busy(&b->dec);
+	if(IR_Decoder_Feed(&b->dec,mark,dur,&f))
+	{
+		b->frames[f.protocol<=IR_PROTO_COUNT?f.protocol:0][f.repeat?1:0]++;
+		if(!quiet) printf("%14llu %-7s %-6s addr=0x%04X cmd=0x%04X bits=%-2u tgl=%u jitter=%u\n",start,IR_Proto_Name(f.protocol),
+		                  f.repeat?"repeat":"frame",f.address,f.command,f.bits,f.toggle,f.jitter);
+	}
+	else if(idle&&busy) b->idle_timeouts++;     // 帧未收完线路就空闲了
+}
+
+static void Batch_Flush(Batch *b)
+{
+	if(!b->pend) return;
+	b->pend=0;
+	Batch_Feed(b,b->pend_mark,b->pend_dur,b->pend_t);
+}
+
+// 一个原始电平段（宽度已换算为us），处理方式与remote.c中的Remote_Rx_Poll()相同：
+// 电平段先作为待定段，后一段不短于毛刺宽度才送入解码器；后一段是毛刺时并入待定段
+static void Batch_Segment(Batch *b,u8 mark,u32 dur)
+{
+	unsigned long long start=b->t;
+
+	b->t+=dur;
+	if(b->cont)                         // 毛刺之后的剩余部分
+	{
+		b->cont=0;
+		b->pend_dur+=dur;
+		return;
+	}
+	if(b->idle)
+	{
+		if(!mark)                       // 空闲中的间隔（含孤立脉冲之后的部分）
+		{
+			if(b->skip) IR_Decoder_Elapse(&b->dec,dur);
+			b->skip=0;
+			return;
+		}
+		if(dur<b->glitch_us)            // 空闲中的孤立脉冲
+		{
+			b->glitches++;
+			b->skip=1;
+			return;
+		}
+		b->idle=0;
+	}
+	else if(dur<b->glitch_us&&b->pend)
+	{
+		b->glitches++;
+		b->pend_dur+=dur;
+		b->cont=1;
+		return;
+	}
+	Batch_Flush(b);
+	if(!mark&&dur>IR_IDLE_MS*1000UL)    // 线路空闲：与固件相同，只送入IR_IDLE_MS的间隔，其余按空闲时间计入
+	{
+		Batch_Feed(b,0,IR_IDLE_MS*1000UL+1,start);
+		IR_Decoder_Elapse(&b->dec,dur-IR_IDLE_MS*1000UL-1);
+		b->idle=1;
+		return;
+	}
+	b->pend=1;
+	b->pend_mark=mark;
+	b->pend_dur=dur;
+	b->pend_t=start;
+}
+
+// ==================== 文件处理 ====================
+static int Batch_File(Batch *b,const char *fn,u32 width)
+{
+	static u32 dur[CHUNK];
+	static u8 bin[CHUNK];
+	const Cap_Header *h;
+	const u8 *map,*ts;
+	struct stat st;
+	size_t len,n,i,k,m;
+	float scale=1.0f;
+	int fd;
+
+	fd=open(fn,O_RDONLY);
+	if(fd<0||fstat(fd,&st))
+	{
+		fprintf(stderr,"cannot open %s\n",fn);
+		return -1;
+	}
+	len=(size_t)st.st_size;
+	if(!len)
+	{
+		close(fd);
+		return 0;
+	}
+	map=mmap(0,len,PROT_READ,MAP_PRIVATE,fd,0);
+	close(fd);
+	if(map==MAP_FAILED)
+	{
+		fprintf(stderr,"cannot map %s\n",fn);
+		return -1;
+	}
+	madvise((void*)map,len,MADV_SEQUENTIAL);
+
+	ts=map;
+	h=(const Cap_Header*)map;
+	if(len>=sizeof(*h)&&!memcmp(h->magic,CAP_MAGIC,4))
+	{
+		if(h->version!=CAP_VERSION||(h->width!=2&&h->width!=4)||!h->tick_ns)
+		{
+			fprintf(stderr,"%s: unsupported header\n",fn);
+			munmap((void*)map,len);
+			return -1;
+		}
+		width=h->width;
+		scale=h->tick_ns/1000.0f;
+		ts+=sizeof(*h);
+		len-=sizeof(*h);
+	}
+	n=len/width;
+	b->edges+=n;
+
+	// 第一个边沿之前是空闲高电平；第i个电平段（i>=1）为第i-1~i个边沿，奇数段为载波
+	for(i=1;i<n;i+=m)
+	{
+		m=n-i;
+		if(m>CHUNK) m=CHUNK;
+		Chunk_Durations(ts+i*width,width,(u32)m,scale,dur,bin);
+		for(k=0;k<m;k++)
+		{
+			b->hist[(i+k)&1][bin[k]]++;
+			Batch_Segment(b,(u8)((i+k)&1),scale==1.0f?dur[k]:(u32)(dur[k]*scale+0.5f));
+		}
+	}
+	munmap((void*)map,len+(size_t)(ts-map));
+
+	// 文件结束：线路回到空闲，以长间隔结尾的协议（SIRC等）此时完成
+	Batch_Flush(b);
+	if(n&&!b->idle) Batch_Feed(b,0,IR_DUR_IDLE,b->t);
+	b->idle=1;
+	b->cont=0;
+	b->skip=0;
+	return 0;
+}
+
+static void Print_Histogram(const Batch *b)
+{
+	u32 i;
+
+	printf("width histogram  : (us)      marks     spaces\n");
+	for(i=0;i<=HIST_BINS;i++)
+	{
+		if(!b->hist[0][i]&&!b->hist[1][i]) continue;
+		if(i<HIST_BINS) printf("  %5u-%-5u %14llu %10llu\n",i*HIST_BIN_US,(i+1)*HIST_BIN_US,b->hist[1][i],b->hist[0][i]);
+		else printf("  >=%-9u %14llu %10llu\n",HIST_BINS*HIST_BIN_US,b->hist[1][i],b->hist[0][i]);
+	}
+}
+
+int main(int argc,char **argv)
+{
+	static Batch b;
+	const IR_Decoder_Stats *s=&b.dec.stats;
+	unsigned long long t0,ns;
+	u32 width=4,files=0,p;
+	u8 hist=1;
+	int i;
+
+	IR_Decoder_Init(&b.dec);
+	b.glitch_us=IR_GLITCH_US;
+	b.idle=1;
+	setvbuf(stdout,0,_IOFBF,1<<20);
+	t0=Host_Ns();
+	for(i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i],"-16")) width=2;
+		else if(!strcmp(argv[i],"-g")&&i+1<argc) b.glitch_us=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-q")) quiet=1;
+		else if(!strcmp(argv[i],"-H")) hist=0;
+		else if(argv[i][0]=='-')
+		{
+			fprintf(stderr,"usage: %s [-16] [-g glitch_us] [-q] [-H] capture...\n",argv[0]);
+			return 2;
+		}
+		else if(Batch_File(&b,argv[i],width)) return 2;
+		else files++;
+	}
+	if(!files)
+	{
+		fprintf(stderr,"usage: %s [-16] [-g glitch_us] [-q] [-H] capture...\n",argv[0]);
+		return 2;
+	}
+	ns=Host_Ns()-t0;
+	if(!ns) ns=1;
+
+	printf("captures         : %u file(s), %llu edges, %.1f s of signal (%s)\n",files,b.edges,b.t/1e6,IR_BATCH_SSE2?"SSE2":"scalar");
+	printf("throughput       : %.3f s host, %.1f Medges/s, %.0f MB/s\n",ns/1e9,b.edges*1e3/ns,b.edges*width*1e3/ns);
+	printf("decoder          : leader=%u frame=%u repeat=%u chk_fail=%u bad_pulse=%u\n",
+	       s->leaders,s->frames,s->repeats,s->check_fail,s->bad_pulse);
+	printf("line             : glitch=%u (<%uus) idle_to=%u\n",b.glitches,b.glitch_us,b.idle_timeouts);
+	for(p=1;p<=IR_PROTO_COUNT;p++)
+		if(b.frames[p][0]||b.frames[p][1]) printf("  %-8s %10u frames %10u repeats\n",IR_Proto_Name((u8)p),b.frames[p][0],b.frames[p][1]);
+	if(hist) Print_Histogram(&b);
+	return 0;
+}
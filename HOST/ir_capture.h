@@ -0,0 +1,22 @@
+#ifndef __IR_CAPTURE_H
+#define __IR_CAPTURE_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机边沿捕获文件格式
+// 功能说明：ir_replay -o 写出、ir_batch 读入的二进制边沿日志
+// 文件格式：Cap_Header + 小端序边沿时间戳（width字节/个）
+//          线路以空闲高电平开始，第一个边沿为载波开始（下降沿），之后交替
+//////////////////////////////////////////////////////////////////////////////////
+
+#define CAP_MAGIC       "IRCP"
+#define CAP_VERSION     1
+
+typedef struct
+{
+	char magic[4];      // "IRCP"
+	u16  version;       // CAP_VERSION
+	u16  width;         // 时间戳宽度（2或4字节）
+	u32  tick_ns;       // 每个计数的ns数（1000=1us）
+} Cap_Header;
+
+#endif
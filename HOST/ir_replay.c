@@ -0,0 +1,797 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "sim_mcu.h"
+#include "remote.h"
+#include "ir_decode.h"
+#include "ir_tx.h"
+#include "ir_capture.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机红外波形回放与解码性能测试
+// 功能说明：把合成或录制的红外波形按虚拟时间回放给未修改的remote.c/ir_decode.c，
+//          统计解码帧率、错误率和每个边沿的解码开销，用于在烧录前发现解码回归、
+//          比较不同解码实现
+// 波形来源：
+//   合成（默认）：NEC/扩展NEC/Samsung/SIRC/RC5/RC6按键（含重复码/重复帧）、
+//                 噪声脉冲串、截断帧，时序加随机抖动，并记录期望结果
+//                 可模拟偏离标称时序的遥控器（-k 时钟偏差%）和拉长载波的接收头（-m 载波展宽us）
+//                 -g 在电平段中间插入短于IR_GLITCH_US的毛刺（荧光灯/阳光干扰），并加入持续的边沿风暴
+//                 各协议的地址取自site_addr[]允许列表，约1/8为列表外的遥控器（不应产生事件）
+//                 约1/8的按键来自协议表之外的遥控器（JVC/Kaseikyo/Sharp），回放前先走一遍学习流程，
+//                 之后应按信号库匹配产生LEARNED事件
+//   多接收头（-r）：同一波形送给前N个接收头，后面的接收头延迟更大、抖动更大，
+//                 每次发射仍应只产生一个事件（需以多通道IR_RX_CH_MASK编译，见Makefile）
+//   发射回环（-t）：回放结束后用IR_Tx_Send()发送N个按键（协议表中的协议和学习的信号），
+//                 TIM1的输出回环到接收头，应解出同样的按键
+//   录制（-f）  ：LIRC mode2格式（"pulse 560"/"space 1690"），或每行一个带符号整数
+//                 （正数=载波us，负数=间隔us）；录制波形没有期望结果，只统计解码数量
+//   导出（-o）  ：波形另存为ir_capture.h格式的边沿日志（u32 us时间戳），交给ir_batch离线解码
+// 用法：ir_replay [-n 按键数] [-s 随机种子] [-j 抖动%] [-k 时钟偏差%] [-m 载波展宽us] [-g 毛刺%]
+//                 [-r 接收头数] [-t 发射按键数] [-l 主循环间隔ms] [-b 基准轮数] [-f 文件] [-o 文件] [-v]
+// 返回值：合成波形存在解码错误时返回1
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 波形与期望结果 ====================
+typedef struct
+{
+	u8  mark;           // 1=载波，0=间隔
+	u32 us;             // 持续时间
+} Segment;
+
+typedef struct
+{
+	u8  type;           // IR_EVT_PRESS/IR_EVT_REPEAT
+	u8  protocol;
+	u16 address;
+	u16 command;
+} Expect;
+
+static Segment *seg=0;
+static u32 seg_n=0,seg_cap=0;
+static Expect *exp_buf=0;
+static u32 exp_n=0,exp_cap=0;
+
+static u32 rng_state=1;
+static u8  jitter_pct=8;
+static s32 skew_pct=0;      // 遥控器时钟偏差：所有时序乘以(100+skew_pct)%
+static s32 stretch_us=0;    // 接收头载波展宽：载波加长、间隔缩短同样的us数
+static u8  glitch_pct=0;    // 电平段中间出现毛刺的概率（%），非0时还加入边沿风暴
+static u8  rx_n=1;          // 收到信号的接收头个数
+static u8  rx_ch[IR_RX_MAX];// 第k个接收头的TIM3通道号（IR_RX_CH_MASK中第k个通道）
+
+// 现场的遥控器地址（多款遥控器），合成波形回放前装入地址允许列表
+static const IR_Addr site_addr[]=
+{
+	{IR_PROTO_NEC,REMOTE_ID},{IR_PROTO_NEC,0x40},{IR_PROTO_NEC,0x86},
+	{IR_PROTO_NECX,0x00BF},{IR_PROTO_NECX,0x04FA},{IR_PROTO_NECX,0x10E7},{IR_PROTO_NECX,0x2D02},
+	{IR_PROTO_NECX,0x40BE},{IR_PROTO_NECX,0x5583},{IR_PROTO_NECX,0x6A19},{IR_PROTO_NECX,0x8876},
+	{IR_PROTO_NECX,0x9C11},{IR_PROTO_NECX,0xB24C},{IR_PROTO_NECX,0xC739},{IR_PROTO_NECX,0xE0E0},
+	{IR_PROTO_SAMSUNG,0x07},{IR_PROTO_SAMSUNG,0x0E},
+	{IR_PROTO_SIRC,0x01},{IR_PROTO_SIRC,0x1A},{IR_PROTO_SIRC,0x97},{IR_PROTO_SIRC,0x10A4},
+	{IR_PROTO_RC5,0x00},{IR_PROTO_RC5,0x05},{IR_PROTO_RC5,0x14},
+	{IR_PROTO_RC6,0x00},{IR_PROTO_RC6,0x04},{IR_PROTO_RC6,0x26},
+};
+#define SITE_ADDR_N  (sizeof(site_addr)/sizeof(site_addr[0]))
+
+static u32 Rand(void)
+{
+	rng_state^=rng_state<<13;
+	rng_state^=rng_state>>17;
+	rng_state^=rng_state<<5;
+	return rng_state;
+}
+
+// 追加一个电平段，相邻同电平段合并
+static void Seg_Add(u8 mark,u32 us)
+{
+	if(seg_n&&seg[seg_n-1].mark==mark)
+	{
+		seg[seg_n-1].us+=us;
+		return;
+	}
+	if(seg_n==seg_cap)
+	{
+		seg_cap=seg_cap?seg_cap*2:4096;
+		seg=realloc(seg,seg_cap*sizeof(Segment));
+		if(!seg) exit(2);
+	}
+	seg[seg_n].mark=mark;
+	seg[seg_n].us=us;
+	seg_n++;
+}
+
+// 追加带抖动的电平段（先按时钟偏差缩放，再加载波展宽）
+// 有毛刺时在段中间插入一个反向的短脉冲，两侧各留出不短于IR_GLITCH_US的部分
+static void Seg_J(u8 mark,u32 us)
+{
+	s32 j=0;
+	u32 a,g;
+	
+	us=(u32)((s32)us*(100+skew_pct)/100);
+	if(jitter_pct) j=(s32)(Rand()%(2*us*jitter_pct/100+1))-(s32)(us*jitter_pct/100);
+	j+=mark?stretch_us:-stretch_us;
+	if((s32)us+j<50) j=50-(s32)us;
+	us=(u32)((s32)us+j);
+	if(glitch_pct&&us>=3*IR_GLITCH_US&&Rand()%100<glitch_pct)
+	{
+		g=10+Rand()%(IR_GLITCH_US-20);
+		a=IR_GLITCH_US+Rand()%(us-2*IR_GLITCH_US-g+1);
+		Seg_Add(mark,a);
+		Seg_Add(!mark,g);
+		Seg_Add(mark,us-a-g);
+		return;
+	}
+	Seg_Add(mark,us);
+}
+
+static void Expect_Add(u8 type,u8 protocol,u16 address,u16 command)
+{
+	if(exp_n==exp_cap)
+	{
+		exp_cap=exp_cap?exp_cap*2:1024;
+		exp_buf=realloc(exp_buf,exp_cap*sizeof(Expect));
+		if(!exp_buf) exit(2);
+	}
+	exp_buf[exp_n].type=type;
+	exp_buf[exp_n].protocol=protocol;
+	exp_buf[exp_n].address=address;
+	exp_buf[exp_n].command=command;
+	exp_n++;
+}
+
+// ==================== 协议波形合成 ====================
+// 间隔宽度编码的数据位（不含结束载波），高位先发
+static void Gen_Space_Bits(u32 mark,u32 zero,u32 one,u32 data,u32 nbits)
+{
+	u32 i;
+	
+	for(i=0;i<nbits;i++)
+	{
+		Seg_J(1,mark);
+		Seg_J(0,(data>>(nbits-1-i))&1?one:zero);
+	}
+}
+
+// 间隔宽度编码：hdr_mark/hdr_space引导，32位高位先发，结束载波
+static void Gen_Pulse_Distance(u32 hdr_mark,u32 data,u32 nbits)
+{
+	u32 i;
+	
+	Seg_J(1,hdr_mark);
+	Seg_J(0,4500);
+	for(i=0;i<nbits;i++)
+	{
+		Seg_J(1,560);
+		Seg_J(0,(data>>(nbits-1-i))&1?1690:560);
+	}
+	Seg_J(1,560);
+}
+
+// NEC重复码：9ms载波 + 2.25ms间隔 + 560us载波
+static void Gen_NEC_Repeat(void)
+{
+	Seg_J(1,9000);
+	Seg_J(0,2250);
+	Seg_J(1,560);
+}
+
+// Sony SIRC：2.4ms引导，低位先发，600us间隔 + 600/1200us载波
+static void Gen_SIRC(u32 data,u32 nbits)
+{
+	u32 i;
+	
+	Seg_J(1,2400);
+	for(i=0;i<nbits;i++)
+	{
+		Seg_J(0,600);
+		Seg_J(1,(data>>i)&1?1200:600);
+	}
+}
+
+// 曼彻斯特半位序列：levels[i]为第i个T单位的电平（1=载波）
+static void Gen_Manchester(const u8 *levels,u32 n,u32 t)
+{
+	u32 i=0,j;
+	
+	while(i<n)
+	{
+		j=i;
+		while(j<n&&levels[j]==levels[i]) j++;
+		Seg_J(levels[i],(j-i)*t);
+		i=j;
+	}
+}
+
+// RC5：14位，"1"=间隔后载波，T=889us
+static void Gen_RC5(u32 data)
+{
+	u8 lv[28];
+	u32 i,b;
+	
+	for(i=0;i<14;i++)
+	{
+		b=(data>>(13-i))&1;
+		lv[2*i]=!b;
+		lv[2*i+1]=(u8)b;
+	}
+	Gen_Manchester(lv,28,889);
+}
+
+// RC6模式0：6T引导载波 + 2T间隔，21位，"1"=载波后间隔，第5位（翻转位）为双倍宽度，T=444us
+static void Gen_RC6(u32 data)
+{
+	u8 lv[64];
+	u32 n=0,i,k,b,w;
+	
+	for(i=0;i<6;i++) lv[n++]=1;
+	lv[n++]=0;
+	lv[n++]=0;
+	for(i=0;i<21;i++)
+	{
+		b=(data>>(20-i))&1;
+		w=(i==4)?2:1;
+		for(k=0;k<w;k++) lv[n++]=(u8)b;
+		for(k=0;k<w;k++) lv[n++]=!b;
+	}
+	Gen_Manchester(lv,n,444);
+}
+
+// （协议，地址）是否在site_addr[]中
+static u8 Site_Has(u8 proto,u16 addr)
+{
+	u32 i;
+	
+	for(i=0;i<SITE_ADDR_N;i++)
+		if(site_addr[i].protocol==proto&&site_addr[i].address==addr) return 1;
+	return 0;
+}
+
+// 允许列表中该协议的一个地址
+static u16 Site_Addr(u8 proto)
+{
+	u32 i;
+	
+	do i=Rand()%SITE_ADDR_N;
+	while(site_addr[i].protocol!=proto);
+	return site_addr[i].address;
+}
+
+// 按键地址：多数取自允许列表，约1/8为列表外的遥控器（地址在mask范围内随机）
+static u16 Gen_Addr(u8 proto,u16 mask,u8 *foreign)
+{
+	u16 addr;
+	
+	*foreign=(Rand()&7)==0;
+	for(;;)
+	{
+		addr=*foreign?(u16)(Rand()&mask):Site_Addr(proto);
+		if(proto==IR_PROTO_NECX&&(addr>>8)==(u8)~(addr&0xFF)) continue;   // 这是标准NEC帧
+		if(Site_Has(proto,addr)!=*foreign) return addr;
+	}
+}
+
+// ==================== 学习的遥控器 ====================
+// 协议表之外的遥控器的LEARN_N个按键：JVC（16位，引导码与NEC相同但位数不足）、
+// Kaseikyo（48位）、Sharp（15位，无引导码）。第k个按键学习时绑定命令LEARN_CMD+k，
+// 信号库开始为空，所以它的信号库下标（事件的address）就是k
+// 抖动超过LEARN_MAX_JITTER%时Kaseikyo的1296us和1728us间隔互相重叠，聚类无法区分，不生成学习按键
+#define LEARN_N     6
+#define LEARN_MAX_JITTER 10
+#define LEARN_CMD   0xA0
+static u32 lrn_data[LEARN_N];
+static u8  learn_on=0;          // 1=合成波形，回放前学习
+static u8  trace_file=0;        // 1=录制波形（-f），地址不过滤
+static u32 learn_ok=0;          // 学习成功的按键数
+
+// 第k个学习按键的一帧，返回帧周期（us）
+static u32 Gen_Learned(u32 k)
+{
+	u32 d=lrn_data[k];
+	
+	switch(k%3)
+	{
+		case 0:
+			Seg_J(1,8400);
+			Seg_J(0,4200);
+			Gen_Space_Bits(526,526,1574,d&0xFFFF,16);
+			Seg_J(1,526);
+			return 60000;
+		case 1:
+			Seg_J(1,3456);
+			Seg_J(0,1728);
+			Gen_Space_Bits(432,432,1296,0x4004,16);
+			Gen_Space_Bits(432,432,1296,d,32);
+			Seg_J(1,432);
+			return 130000;
+		default:
+			Gen_Space_Bits(264,792,1848,d&0x7FFF,15);
+			Seg_J(1,264);
+			return 67000;
+	}
+}
+
+// 学习按键的一次按下：首帧 + rpt次同码重复帧
+static void Gen_Learned_Press(u32 rpt)
+{
+	u32 k=Rand()%LEARN_N,i,j,len,period;
+	
+	for(i=0;i<=rpt;i++)
+	{
+		j=seg_n;
+		len=0;
+		period=Gen_Learned(k);
+		Expect_Add(i?IR_EVT_REPEAT:IR_EVT_PRESS,IR_PROTO_LEARNED,(u16)k,LEARN_CMD+k);
+		for(;j<seg_n;j++) len+=seg[j].us;
+		Seg_Add(0,period>len?period-len:10000);
+	}
+	Seg_Add(0,150000+Rand()%150000);
+}
+
+// 一次按键：首帧 + rpt次重复，之后留出足够长的松开间隔
+static void Gen_Press(u32 rpt)
+{
+	static u8 rc_toggle=0;
+	u8 proto=1+Rand()%IR_PROTO_COUNT,foreign=0;
+	u16 addr=0,cmd;
+	u32 data=0,nbits=0,period=0,i;
+	
+	if(learn_on&&(Rand()&7)==0)
+	{
+		Gen_Learned_Press(rpt);
+		return;
+	}
+	
+	switch(proto)
+	{
+		case IR_PROTO_NEC:
+			addr=Gen_Addr(proto,0xFF,&foreign);
+			cmd=Rand()&0xFF;
+			data=((u32)addr<<24)|((u32)(u8)~addr<<16)|((u32)cmd<<8)|(u8)~cmd;
+			period=108000;
+			break;
+		case IR_PROTO_NECX:
+			addr=Gen_Addr(proto,0xFFFF,&foreign);
+			cmd=Rand()&0xFF;
+			data=((u32)addr<<16)|((u32)cmd<<8)|(u8)~cmd;
+			period=108000;
+			break;
+		case IR_PROTO_SAMSUNG:
+			addr=Gen_Addr(proto,0xFF,&foreign);
+			cmd=Rand()&0xFF;
+			data=((u32)addr<<24)|((u32)addr<<16)|((u32)cmd<<8)|(u8)~cmd;
+			period=108000;
+			break;
+		case IR_PROTO_SIRC:
+			nbits=(Rand()%3==0)?12:((Rand()&1)?15:20);
+			cmd=Rand()&0x7F;
+			addr=Gen_Addr(proto,(1U<<(nbits-7))-1,&foreign);
+			if(addr>=0x100) nbits=20;                 // 列表中的地址超出该位数时加长帧
+			else if(addr>=0x20&&nbits==12) nbits=15;
+			data=cmd|((u32)addr<<7);
+			period=45000;
+			break;
+		case IR_PROTO_RC5:
+			addr=Gen_Addr(proto,0x1F,&foreign);
+			cmd=Rand()&0x7F;
+			rc_toggle^=1;
+			data=(1U<<13)|((cmd&0x40)?0:(1U<<12))|((u32)rc_toggle<<11)|((u32)addr<<6)|(cmd&0x3F);
+			period=113778;
+			break;
+		default:
+			addr=Gen_Addr(proto,0xFF,&foreign);
+			cmd=Rand()&0xFF;
+			rc_toggle^=1;
+			data=(1U<<20)|((u32)rc_toggle<<16)|((u32)addr<<8)|cmd;
+			period=107000;
+			break;
+	}
+	
+	for(i=0;i<=rpt;i++)
+	{
+		u32 len=0,k=seg_n;
+		
+		if(i>0&&(proto==IR_PROTO_NEC||proto==IR_PROTO_NECX)) Gen_NEC_Repeat();
+		else if(proto==IR_PROTO_NEC||proto==IR_PROTO_NECX) Gen_Pulse_Distance(9000,data,32);
+		else if(proto==IR_PROTO_SAMSUNG) Gen_Pulse_Distance(4500,data,32);
+		else if(proto==IR_PROTO_SIRC) Gen_SIRC(data,nbits);
+		else if(proto==IR_PROTO_RC5) Gen_RC5(data);
+		else Gen_RC6(data);
+		if(!foreign) Expect_Add(i?IR_EVT_REPEAT:IR_EVT_PRESS,proto,addr,cmd);
+		
+		for(;k<seg_n;k++) len+=seg[k].us;
+		Seg_Add(0,period>len?period-len:10000);       // 补足到帧周期
+	}
+	Seg_Add(0,150000+Rand()%150000);                  // 松开
+}
+
+// 噪声脉冲串：若干50~300us的短载波/短间隔（荧光灯、阳光干扰）
+static void Gen_Noise(void)
+{
+	u32 n=5+Rand()%40,i;
+	
+	for(i=0;i<n;i++)
+	{
+		Seg_Add(1,50+Rand()%250);
+		Seg_Add(0,50+Rand()%400);
+	}
+	Seg_Add(0,150000);
+}
+
+// 边沿风暴：30~200ms的5~60us短脉冲（调光灯具、强光直射），之后留出足够长的安静间隔
+static void Gen_Flood(void)
+{
+	u32 end=30000+Rand()%170000,t=0,us;
+	
+	while(t<end)
+	{
+		us=5+Rand()%56;
+		Seg_Add(1,us);
+		Seg_Add(0,5+Rand()%56);
+		t+=us+seg[seg_n-1].us;
+	}
+	Seg_Add(0,150000);
+}
+
+// 截断帧：NEC帧在随机位置中断（遥控器移出接收范围）
+static void Gen_Truncated(void)
+{
+	u32 keep=2+Rand()%60,start=seg_n;
+	
+	Gen_Pulse_Distance(9000,0x00FF00FF|((Rand()&0xFF)<<8),32);
+	if(seg_n-start>keep) seg_n=start+keep;
+	if(seg_n&&seg[seg_n-1].mark==0) seg_n--;
+	Seg_Add(0,150000);
+}
+
+static void Gen_Trace(u32 presses)
+{
+	u32 i,r;
+	
+	Seg_Add(0,200000);
+	for(i=0;i<presses;i++)
+	{
+		r=Rand()%10;
+		if(r==0) Gen_Noise();
+		else if(r==1) Gen_Truncated();
+		else if(r==2&&glitch_pct) Gen_Flood();
+		Gen_Press(Rand()%4);
+	}
+}
+
+// ==================== 录制波形读取 ====================
+static int Load_Trace(const char *fn)
+{
+	FILE *fp=fopen(fn,"r");
+	char line[128],word[32];
+	long v;
+	
+	if(!fp) return -1;
+	Seg_Add(0,200000);
+	while(fgets(line,sizeof(line),fp))
+	{
+		if(sscanf(line,"%31s %ld",word,&v)==2)
+		{
+			if(!strcmp(word,"pulse")) Seg_Add(1,(u32)v);
+			else if(!strcmp(word,"space")||!strcmp(word,"timeout")) Seg_Add(0,(u32)v);
+		}
+		else if(sscanf(line,"%ld",&v)==1&&v)
+		{
+			if(v>0) Seg_Add(1,(u32)v);
+			else Seg_Add(0,(u32)-v);
+		}
+	}
+	fclose(fp);
+	Seg_Add(0,300000);
+	return 0;
+}
+
+// 导出边沿日志：跳过开头的空闲间隔，之后每个电平段的开始为一个边沿
+static int Save_Capture(const char *fn)
+{
+	FILE *fp=fopen(fn,"wb");
+	Cap_Header h={CAP_MAGIC,CAP_VERSION,4,1000};
+	u32 i,t=0;
+	
+	if(!fp) return -1;
+	fwrite(&h,sizeof(h),1,fp);
+	for(i=0;i<seg_n;i++)
+	{
+		if(i||seg[i].mark) fwrite(&t,4,1,fp);
+		t+=seg[i].us;
+	}
+	return fclose(fp)?-1:0;
+}
+
+// ==================== 回放与结果比对 ====================
+static u32 got_press=0,got_repeat=0,got_release=0;
+static u32 exp_pos=0,ok_n=0,miss_n=0,bad_n=0;
+static u8  verbose=0;
+
+static u8 Expect_Match(const Expect *e,const IR_Event *ev)
+{
+	return e->type==ev->type&&e->protocol==ev->protocol&&e->address==ev->address&&e->command==ev->command;
+}
+
+// 逐个比对事件：匹配则前进；与后面第k个期望匹配说明漏了k帧；都不匹配记为错误帧
+#define MATCH_AHEAD 32
+static void Check_Event(const IR_Event *ev)
+{
+	u32 k;
+	
+	if(ev->type==IR_EVT_PRESS) got_press++;
+	else if(ev->type==IR_EVT_REPEAT) got_repeat++;
+	else
+	{
+		got_release++;
+		return;
+	}
+	if(verbose) printf("%10lluus %-7s %-7s addr=0x%04X cmd=0x%02X rpt=%u ch%u/%X\n",Sim_Now(),IR_Proto_Name(ev->protocol),
+	                   ev->type==IR_EVT_PRESS?"PRESS":"REPEAT",ev->address,ev->command,ev->repeat,ev->rx+1,ev->rx_mask);
+	if(!exp_n) return;
+	
+	for(k=0;k<MATCH_AHEAD&&exp_pos+k<exp_n;k++)
+	{
+		if(Expect_Match(&exp_buf[exp_pos+k],ev))
+		{
+			miss_n+=k;
+			ok_n++;
+			exp_pos+=k+1;
+			return;
+		}
+	}
+	bad_n++;
+}
+
+// 输出一个电平段：第k个接收头的边沿延迟k*3us，再叠加0~k*RX_NOISE_US的随机抖动
+// （越靠后的接收头信号越差，合并时应选中第一个接收头）
+#define RX_NOISE_US 25
+static void Replay_Segment(u8 mark,u32 us)
+{
+	u32 off[IR_RX_MAX],t=0;
+	u8 idx[IR_RX_MAX],k,j,tmp;
+	
+	for(k=0;k<rx_n;k++)
+	{
+		off[k]=k*3+(k?Rand()%(k*RX_NOISE_US+1):0);
+		if(off[k]>us/2) off[k]=us/2;
+		idx[k]=k;
+	}
+	for(k=1;k<rx_n;k++)         // 按到达时间排序
+		for(j=k;j>0&&off[idx[j]]<off[idx[j-1]];j--)
+		{
+			tmp=idx[j];
+			idx[j]=idx[j-1];
+			idx[j-1]=tmp;
+		}
+	for(k=0;k<rx_n;k++)
+	{
+		Sim_Advance(off[idx[k]]-t);
+		t=off[idx[k]];
+		Sim_Edge_Rx(rx_ch[idx[k]],mark?0:1);   // 载波期间接收头输出低电平
+	}
+	Sim_Advance(us-t);
+}
+
+// 学习流程：每个学习按键Remote_Learn_Start()后发射3次，主循环中Remote_Learn_Poll()保存
+// 波形临时追加在seg[]末尾，播放后截掉；学习期间的事件丢弃
+static void Learn_Remotes(void)
+{
+	IR_Event ev;
+	u32 k,i,start;
+	u8 st,done;
+	
+	for(k=0;k<LEARN_N;k++)
+	{
+		Remote_Learn_Start(LEARN_CMD+k);
+		start=seg_n;
+		for(i=0;i<3;i++)
+		{
+			Gen_Learned(k);
+			Seg_Add(0,100000);
+		}
+		for(i=start,done=0;i<seg_n;i++)
+		{
+			Replay_Segment(seg[i].mark,seg[i].us);
+			st=Remote_Learn_Poll();
+			if(st==IR_LEARN_SAVED) learn_ok++;
+			if(st==IR_LEARN_SAVED||st==IR_LEARN_FAIL) done=1;
+		}
+		if(!done) Remote_Learn_Cancel();
+		seg_n=start;
+	}
+	Sim_Advance(300000);
+	while(Remote_Get_Event(&ev));
+}
+
+// 主循环模型：每loop_ms取一次事件（模拟主循环被LCD刷新等阻塞）
+static void Replay(u32 loop_ms)
+{
+	IR_Event ev;
+	unsigned long long next_drain;
+	u32 i;
+	
+	Sim_Reset();
+	Remote_Init();
+	IR_Tx_Init();
+	if(!trace_file&&Remote_Addr_Load(site_addr,SITE_ADDR_N)!=SITE_ADDR_N) printf("address list overflow\n");
+	for(i=1;trace_file&&i<=IR_PROTO_COUNT;i++) Remote_Addr_Allow_Any((u8)i);   // 录制波形的遥控器地址未知
+	if(learn_on) Learn_Remotes();
+	next_drain=Sim_Now()+loop_ms*1000ULL;
+	for(i=0;i<seg_n;i++)
+	{
+		Replay_Segment(seg[i].mark,seg[i].us);
+		if(Sim_Now()>=next_drain)
+		{
+			while(Remote_Get_Event(&ev)) Check_Event(&ev);
+			next_drain=Sim_Now()+loop_ms*1000ULL;
+		}
+	}
+	Sim_Advance(300000);
+	while(Remote_Get_Event(&ev)) Check_Event(&ev);
+}
+
+// ==================== 发射回环 ====================
+// 随机选一个接收方应接受的按键：地址取自允许列表，学习的信号按信号库下标发送
+static void Tx_Key(Expect *k)
+{
+	u32 i;
+	
+	if(learn_on&&learn_ok==LEARN_N&&(Rand()&7)==0)
+	{
+		i=Rand()%LEARN_N;
+		k->protocol=IR_PROTO_LEARNED;
+		k->address=(u16)i;
+		k->command=LEARN_CMD+i;
+		return;
+	}
+	k->protocol=1+Rand()%IR_PROTO_COUNT;
+	k->address=Site_Addr(k->protocol);
+	k->command=Rand()&0xFF;
+	if(k->protocol==IR_PROTO_SIRC||k->protocol==IR_PROTO_RC5) k->command&=0x7F;
+}
+
+// 每次排队1~3个按键（测试发送队列），同一批中相邻按键不同（否则接收方把后一个当作重复），
+// 发送完毕后留出松开间隔
+static void Tx_Loopback(u32 n)
+{
+	IR_Event ev;
+	Expect k,prev;
+	u32 i=0,b,r;
+	
+	while(i<n)
+	{
+		memset(&prev,0,sizeof(prev));
+		for(b=1+Rand()%3;b&&i<n;b--,i++)
+		{
+			do Tx_Key(&k);
+			while(k.protocol==prev.protocol&&k.address==prev.address&&k.command==prev.command);
+			r=Rand()%3;
+			if(!IR_Tx_Send(k.protocol,k.address,k.command,(u8)r)) break;
+			Expect_Add(IR_EVT_PRESS,k.protocol,k.address,k.command);
+			while(r--) Expect_Add(IR_EVT_REPEAT,k.protocol,k.address,k.command);
+			prev=k;
+		}
+		while(IR_Tx_Busy())
+		{
+			Sim_Advance(10000);
+			while(Remote_Get_Event(&ev)) Check_Event(&ev);
+		}
+		Sim_Advance(250000+Rand()%100000);
+		while(Remote_Get_Event(&ev)) Check_Event(&ev);
+	}
+}
+
+// 纯解码器基准：同一波形反复送入IR_Decoder_Feed，测量每个电平段的开销
+static void Bench_Decoder(u32 rounds)
+{
+	IR_Decoder dec;
+	IR_Frame f;
+	unsigned long long t0,ns;
+	u32 r,i,frames=0;
+	
+	IR_Decoder_Init(&dec);
+	t0=Sim_Host_Ns();
+	for(r=0;r<rounds;r++)
+		for(i=0;i<seg_n;i++)
+			frames+=IR_Decoder_Feed(&dec,seg[i].mark,seg[i].us,&f);
+	ns=Sim_Host_Ns()-t0;
+	if(!ns) ns=1;
+	printf("decoder only     : %u rounds, %llu segments, %u frames\n",rounds,(unsigned long long)rounds*seg_n,frames);
+	printf("  per segment    : %.1f ns\n",(double)ns/((double)rounds*seg_n));
+	printf("  throughput     : %.0f frames/s, %.2f Msegments/s\n",frames*1e9/ns,rounds*(double)seg_n*1e3/ns);
+}
+
+int main(int argc,char **argv)
+{
+	u32 presses=2000,loop_ms=10,rounds=20,tx_keys=0;
+	const char *file=0,*out=0;
+	unsigned long long t0,ns,vt;
+	u32 frames,total;
+	IR_Tx_Stats txs;
+	int i;
+	
+	for(i=1;i<argc;i++)
+	{
+		if(!strcmp(argv[i],"-n")&&i+1<argc) presses=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-s")&&i+1<argc) rng_state=(u32)strtoul(argv[++i],0,0)|1;
+		else if(!strcmp(argv[i],"-j")&&i+1<argc) jitter_pct=(u8)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-k")&&i+1<argc) skew_pct=atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-m")&&i+1<argc) stretch_us=atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-g")&&i+1<argc) glitch_pct=(u8)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-r")&&i+1<argc) rx_n=(u8)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-t")&&i+1<argc) tx_keys=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-l")&&i+1<argc) loop_ms=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-b")&&i+1<argc) rounds=(u32)atoi(argv[++i]);
+		else if(!strcmp(argv[i],"-f")&&i+1<argc) file=argv[++i];
+		else if(!strcmp(argv[i],"-o")&&i+1<argc) out=argv[++i];
+		else if(!strcmp(argv[i],"-v")) verbose=1;
+		else
+		{
+			fprintf(stderr,"usage: %s [-n presses] [-s seed] [-j jitter%%] [-k skew%%] [-m stretch_us] [-g glitch%%] [-r receivers] [-t tx_keys] [-l loop_ms] [-b rounds] [-f mode2file] [-o capture] [-v]\n",argv[0]);
+			return 2;
+		}
+	}
+	if(!loop_ms) loop_ms=1;
+	if(rx_n<1||rx_n>IR_RX_COUNT)
+	{
+		fprintf(stderr,"-r: this build has %u receiver(s) (IR_RX_CH_MASK=0x%X)\n",IR_RX_COUNT,IR_RX_CH_MASK);
+		return 2;
+	}
+	for(i=0,total=0;i<IR_RX_MAX;i++)
+		if(IR_RX_CH_MASK&(1<<i)) rx_ch[total++]=(u8)i;
+	
+	if(file)
+	{
+		trace_file=1;
+		if(Load_Trace(file))
+		{
+			fprintf(stderr,"cannot open %s\n",file);
+			return 2;
+		}
+	}
+	else
+	{
+		learn_on=(jitter_pct<=LEARN_MAX_JITTER);
+		for(i=0;i<LEARN_N;i++) lrn_data[i]=Rand();
+		Gen_Trace(presses);
+	}
+	if(out&&Save_Capture(out))
+	{
+		fprintf(stderr,"cannot write %s\n",out);
+		return 2;
+	}
+	
+	t0=Sim_Host_Ns();
+	Replay(loop_ms);
+	ns=Sim_Host_Ns()-t0;
+	if(!ns) ns=1;
+	vt=Sim_Now();
+	frames=got_press+got_repeat;
+	if(tx_keys) Tx_Loopback(tx_keys);
+	if(exp_n) miss_n+=exp_n-exp_pos;
+	
+	printf("trace            : %s, %u segments, %.1f s virtual\n",file?file:"synthetic",seg_n,vt/1e6);
+	printf("replay           : %.3f s host, %.0fx real time\n",ns/1e9,vt*1e3/ns);
+	printf("events           : %u press, %u repeat, %u release, %u dropped\n",got_press,got_repeat,got_release,Remote_Dropped_Events());
+	printf("decoded frames/s : %.0f (host time)\n",frames*1e9/ns);
+	printf("Remote_Poll      : %u calls, %.1f ns/edge, %.1f ns/call\n",sim_poll_calls,
+	       seg_n?(double)sim_poll_ns/seg_n:0.0,sim_poll_calls?(double)sim_poll_ns/sim_poll_calls:0.0);
+	printf("receiver stats   : (cyc = host ns)\n");
+	Remote_Print_Stats();
+	if(learn_on) printf("learned signals  : %u/%u\n",learn_ok,LEARN_N);
+	IR_Tx_Get_Stats(&txs);
+	if(tx_keys)
+	{
+		printf("transmitted      : %u keys, %u frames, %u rejected, %u encode failures\n",
+		       txs.jobs,txs.frames,txs.rejected,txs.encode_fail);
+	}
+	if(exp_n)
+	{
+		total=exp_n+bad_n;
+		printf("expected frames  : %u, ok %u, missed %u, wrong %u\n",exp_n,ok_n,miss_n,bad_n);
+		printf("error rate       : %.4f%%\n",total?(miss_n+bad_n)*100.0/total:0.0);
+	}
+	if(rounds) Bench_Decoder(rounds);
+	
+	return ((exp_n&&(miss_n||bad_n))||(learn_on&&learn_ok!=LEARN_N)||txs.encode_fail)?1:0;
+}
@@ -0,0 +1,325 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include "sim_board.h"
+#include "sim_mcu.h"
+#include "usart.h"
+#include "spi.h"
+#include "irda.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机开发板模型实现
+// 模型说明：
+//   时钟  ：Stm32_Clock_Init()只按sys.c设置SysTick优先级，虚拟时钟固定96MHz
+//   串口  ：stdout换成fopencookie流，固件printf的每个字符按10位/波特率占用主程序CPU（阻塞发送）
+//   SPI1  ：SPI1_WriteData()每字节按8个SCK周期占用主程序CPU（APB2 96MHz/分频，SPI1_Init为2分频），
+//           LCD_CS=0时按LCD_WR（D/C）把字节送给ST7789模型：0x2A/0x2B设置窗口，0x2C之后的数据写显存
+//   SPI1 DMA：DMA2_Stream3启动时按字节数×8个SCK周期安排传输完成事件（不占用CPU），完成时按启动时的
+//           D/C电平把数据送给ST7789模型（16位数据宽度为一帧两字节、高字节先发），置完成标志请求中断；
+//           传输进行中又有轮询发送时计为冲突（固件须先SPI1_DMA_Flush()）
+//   IrDA  ：没有对端，发送丢弃，接收为空
+// 说明：结束检查只在忙等延时中进行（sim_mcu.c），串口和SPI的CPU占用不会在stdio内部longjmp
+//////////////////////////////////////////////////////////////////////////////////
+
+#define SIM_SYSCLK_MHZ  96
+
+u8 sim_gpio_out[3][16];
+u16 sim_lcd_fb[SIM_LCD_H][SIM_LCD_W];
+Sim_Board_Stats sim_board;
+
+static u32 sim_uart_baud=115200;
+static u8  sim_uart_echo=0;
+static void (*sim_uart_line)(const char *s)=0;
+static char sim_line[256];
+static u32 sim_line_n=0;
+static FILE *sim_host_stdout=0;
+
+static u32 sim_spi_div=2;               // SPI1波特率分频
+SPI_TypeDef sim_spi1={0,0,SPI_SR_TXE,0};// TXE=1、BSY=0：DMA完成事件在最后一位发出的时刻
+static DMA_HandleTypeDef *sim_spi_dma=0;// 进行中的SPI1 DMA传输（0=空闲）
+static u8  sim_spi_dc=0;                // DMA传输启动时的D/C电平
+
+// ST7789模型
+static u8  lcd_cmd=0;                   // 当前命令
+static u8  lcd_arg[4];                  // 0x2A/0x2B的参数
+static u8  lcd_argn=0;
+static u16 lcd_x0,lcd_x1,lcd_y0,lcd_y1; // 显存窗口
+static u16 lcd_x,lcd_y;                 // 写入位置
+static u8  lcd_hi,lcd_half=0;           // 像素高字节
+
+// ==================== 时钟/GPIO ====================
+void HAL_Init(void)
+{
+}
+
+void Stm32_Clock_Init(u32 plln,u32 pllm,u32 pllp,u32 pllq)
+{
+	(void)plln;(void)pllm;(void)pllp;(void)pllq;
+	HAL_NVIC_SetPriority(SysTick_IRQn,0,0);     // 与sys.c一致
+}
+
+void delay_init(u8 SYSCLK)
+{
+	(void)SYSCLK;
+}
+
+void HAL_GPIO_WritePin(void *port,u32 pin,GPIO_PinState state)
+{
+	u32 i;
+
+	for(i=0;i<16;i++)
+		if(pin&(1U<<i)) sim_gpio_out[(uintptr_t)port][i]=(u8)state;
+}
+
+// ==================== 串口 ====================
+u8  USART_RX_BUF[USART_REC_LEN];
+u16 USART_RX_STA=0;
+UART_HandleTypeDef UART1_Handler;
+u8  aRxBuffer[RXBUFFERSIZE];
+
+// 固件printf输出：按行交给回调，按字符数占用主程序CPU
+static ssize_t Sim_Uart_Write(void *cookie,const char *buf,size_t n)
+{
+	size_t i;
+	u32 ns;
+
+	(void)cookie;
+	if(!sim_host_stdout) return (ssize_t)n;     // 已关闭：丢弃
+	if(sim_uart_echo) fwrite(buf,1,n,sim_host_stdout);
+	for(i=0;i<n;i++)
+	{
+		if(buf[i]=='\n')
+		{
+			sim_line[sim_line_n]=0;
+			sim_board.uart_lines++;
+			if(sim_uart_line) sim_uart_line(sim_line);
+			sim_line_n=0;
+		}
+		else if(buf[i]!='\r'&&sim_line_n<sizeof(sim_line)-1) sim_line[sim_line_n++]=buf[i];
+	}
+	ns=(u32)(n*10*1000000000ULL/sim_uart_baud);
+	sim_board.uart_chars+=(u32)n;
+	sim_board.uart_ns+=ns;
+	Sim_Cpu(ns);
+	return (ssize_t)n;
+}
+
+void uart_init(u32 bound)
+{
+	static const cookie_io_functions_t io={0,Sim_Uart_Write,0,0};
+	FILE *f;
+
+	sim_uart_baud=bound?bound:115200;
+	if(sim_host_stdout) return;
+	f=fopencookie(0,"w",io);
+	if(!f) return;
+	setvbuf(f,0,_IOLBF,256);            // 按行输出，字符时间在换行时计入
+	fflush(stdout);
+	sim_host_stdout=stdout;
+	stdout=f;
+}
+
+// 串口接收：与usart.c的接收中断相同，一行收完后置USART_RX_STA的bit15，上一行未处理时丢弃
+void Sim_Uart_Rx(const char *line)
+{
+	u32 n=strlen(line);
+
+	if(USART_RX_STA&0x8000) return;
+	if(n>USART_REC_LEN-1) n=USART_REC_LEN-1;
+	memcpy(USART_RX_BUF,line,n);
+	USART_RX_STA=(u16)(n|0x8000);
+}
+
+// ==================== SPI1 / ST7789 ====================
+SPI_HandleTypeDef SPI1_Handler;
+
+// dc：LCD_WR（D/C）电平
+static void Sim_Lcd_Byte(u8 dc,u8 b)
+{
+	if(PAout(6)) return;                // LCD_CS=1：未选中
+	if(!dc)                             // D/C=0：命令
+	{
+		lcd_cmd=b;
+		lcd_argn=0;
+		lcd_half=0;
+		sim_board.lcd_cmds++;
+		if(b==0x2C)
+		{
+			lcd_x=lcd_x0;
+			lcd_y=lcd_y0;
+		}
+		return;
+	}
+	switch(lcd_cmd)
+	{
+		case 0x2A:
+		case 0x2B:
+			if(lcd_argn<4) lcd_arg[lcd_argn++]=b;
+			if(lcd_argn==4)
+			{
+				if(lcd_cmd==0x2A)
+				{
+					lcd_x0=(u16)(lcd_arg[0]<<8|lcd_arg[1]);
+					lcd_x1=(u16)(lcd_arg[2]<<8|lcd_arg[3]);
+				}
+				else
+				{
+					lcd_y0=(u16)(lcd_arg[0]<<8|lcd_arg[1]);
+					lcd_y1=(u16)(lcd_arg[2]<<8|lcd_arg[3]);
+				}
+			}
+			break;
+		case 0x2C:
+			if(!lcd_half)
+			{
+				lcd_hi=b;
+				lcd_half=1;
+				break;
+			}
+			lcd_half=0;
+			if(lcd_x<SIM_LCD_W&&lcd_y<SIM_LCD_H) sim_lcd_fb[lcd_y][lcd_x]=(u16)(lcd_hi<<8|b);
+			sim_board.lcd_pixels++;
+			if(lcd_x++>=lcd_x1)         // 窗口内从左到右、从上到下
+			{
+				lcd_x=lcd_x0;
+				if(lcd_y++>=lcd_y1) lcd_y=lcd_y0;
+			}
+			break;
+	}
+}
+
+void SPI1_Init(void)
+{
+	sim_spi_div=2;
+	SPI1_ReadWriteByte(0xFF);           // 启动传输
+}
+
+// 参数：SPI_BAUDRATEPRESCALER_x（CR1的BR[2:0]位，分频=2^(BR+1)）
+void SPI1_SetSpeed(u8 SPI_BaudRatePrescaler)
+{
+	sim_spi_div=2U<<((SPI_BaudRatePrescaler>>3)&7);
+}
+
+u8 SPI1_WriteData(u8 *data,u16 size)
+{
+	u32 i,ns;
+
+	if(sim_spi_dma) sim_board.spi_collisions++;
+	for(i=0;i<size;i++) Sim_Lcd_Byte(PAout(4),data[i]);
+	ns=size*8*sim_spi_div*1000/SIM_SYSCLK_MHZ;
+	sim_board.spi_bytes+=size;
+	sim_board.spi_ns+=ns;
+	Sim_Cpu(ns);
+	return 1;
+}
+
+u8 SPI1_ReadWriteByte(u8 TxData)
+{
+	SPI1_WriteData(&TxData,1);
+	return 0xFF;                        // MISO未接
+}
+
+// SPI1 DMA传输完成：把数据送给ST7789模型，置完成标志
+static void Sim_Spi_Dma_Done(void)
+{
+	DMA_HandleTypeDef *h=sim_spi_dma;
+	const u8 *p=(const u8*)(uintptr_t)h->SrcAddress;
+	u8 half=(h->Init.PeriphDataAlignment==DMA_PDATAALIGN_HALFWORD);
+	u8 inc=(h->Init.MemInc==DMA_MINC_ENABLE);
+	u32 i;
+	
+	for(i=0;i<h->Length;i++)
+	{
+		if(half)
+		{
+			u16 v=*(const u16*)p;
+			
+			Sim_Lcd_Byte(sim_spi_dc,(u8)(v>>8));
+			Sim_Lcd_Byte(sim_spi_dc,(u8)v);
+		}
+		else Sim_Lcd_Byte(sim_spi_dc,*p);
+		if(inc) p+=half?2:1;
+	}
+	sim_spi_dma=0;
+	h->NDTR=0;
+	h->Pending|=2;
+}
+
+// HAL_DMA_Start_IT()替身的回调：DMA2_Stream3为SPI1_TX，按SCK速率安排传输完成
+void Sim_Dma_Started(DMA_HandleTypeDef *hdma)
+{
+	u32 bytes,ns;
+	
+	if(hdma->Instance!=DMA2_Stream3) return;
+	bytes=hdma->Length*((hdma->Init.PeriphDataAlignment==DMA_PDATAALIGN_HALFWORD)?2:1);
+	ns=(u32)((unsigned long long)bytes*8*sim_spi_div*1000/SIM_SYSCLK_MHZ);
+	sim_spi_dma=hdma;
+	sim_spi_dc=PAout(4);
+	sim_board.spi_dma_bytes+=bytes;
+	sim_board.spi_dma_ns+=ns;
+	Sim_After(Sim_Spi_Dma_Done,ns);
+}
+
+// ==================== IrDA（无对端） ====================
+static IrDA_Stats sim_irda;
+
+void IrDA_Init(u32 baud)
+{
+	(void)baud;
+	memset(&sim_irda,0,sizeof(sim_irda));
+}
+
+u8 IrDA_Write(const u8 *data,u16 len)
+{
+	(void)data;
+	sim_irda.tx_bytes+=len;
+	return 1;
+}
+
+u16 IrDA_Tx_Free(void)
+{
+	return IRDA_TX_BUF_LEN-1;
+}
+
+u8 IrDA_Tx_Busy(void)
+{
+	return 0;
+}
+
+u16 IrDA_Read(u8 *buf,u16 max)
+{
+	(void)buf;(void)max;
+	return 0;
+}
+
+void IrDA_Get_Stats(IrDA_Stats *st)
+{
+	*st=sim_irda;
+}
+
+// ==================== 复位 ====================
+void Sim_Board_Reset(void (*line)(const char *s),u8 echo)
+{
+	memset(sim_gpio_out,1,sizeof(sim_gpio_out));
+	memset(sim_lcd_fb,0,sizeof(sim_lcd_fb));
+	memset(&sim_board,0,sizeof(sim_board));
+	sim_uart_line=line;
+	sim_uart_echo=echo;
+	sim_line_n=0;
+	sim_spi_dma=0;
+	lcd_cmd=0;
+	lcd_argn=0;
+	lcd_half=0;
+	lcd_x0=lcd_y0=0;
+	lcd_x1=SIM_LCD_W-1;
+	lcd_y1=SIM_LCD_H-1;
+}
+
+void Sim_Board_Close(void)
+{
+	FILE *f=stdout;
+
+	if(!sim_host_stdout) return;
+	stdout=sim_host_stdout;
+	sim_host_stdout=0;
+	fclose(f);                          // 缓冲区中未换行的输出丢弃
+}
@@ -0,0 +1,36 @@
+#ifndef __SIM_BOARD_H
+#define __SIM_BOARD_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机开发板模型
+// 功能说明：代替SYSTEM/和HARDWARE/中直接操作外设的驱动（时钟、串口、SPI、IrDA），
+//          让未修改的USER/main.c在sim_mcu.c的虚拟时间中运行：
+//          串口printf按115200bps阻塞发送占用主程序CPU，SPI轮询发送按SCK速率占用CPU，
+//          SPI1 DMA（DMA2_Stream3）按SCK速率在后台传输，两者都驱动ST7789显存模型
+//////////////////////////////////////////////////////////////////////////////////
+
+#define SIM_LCD_W   240
+#define SIM_LCD_H   240
+
+typedef struct
+{
+	u32 uart_chars;                     // 串口发送的字符数
+	u32 uart_lines;                     // 串口发送的行数
+	u32 spi_bytes;                      // SPI1轮询发送的字节数
+	u32 spi_dma_bytes;                  // SPI1 DMA发送的字节数
+	u32 spi_collisions;                 // DMA传输进行中的轮询发送（顺序错误）
+	u32 lcd_cmds;                       // LCD命令字节数
+	u32 lcd_pixels;                     // 写入显存的像素数
+	unsigned long long uart_ns;         // 串口发送占用的时间
+	unsigned long long spi_ns;          // SPI轮询发送占用的时间
+	unsigned long long spi_dma_ns;      // SPI DMA传输时间（不占用CPU）
+} Sim_Board_Stats;
+
+extern Sim_Board_Stats sim_board;
+extern u16 sim_lcd_fb[SIM_LCD_H][SIM_LCD_W];    // LCD显存（RGB565）
+
+void Sim_Board_Reset(void (*line)(const char *s),u8 echo);  // line：串口每输出一行调用一次（不含\r\n）
+void Sim_Uart_Rx(const char *line);     // 串口收到一行（加回车换行，主循环的Process_Uart_Command()处理）
+void Sim_Board_Close(void);             // 恢复主机stdout（之后的printf不再经过串口模型）
+
+#endif
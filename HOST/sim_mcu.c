@@ -0,0 +1,743 @@
+#include <stdio.h>
+#include <time.h>
+#include <stdint.h>
+#include <string.h>
+#include "sim_mcu.h"
+#include "remote.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机虚拟MCU实现
+// 模型说明：
+//   时间   ：离散事件，虚拟时间分辨率1ns，只在下一个硬件事件或中断返回时刻推进
+//   TIM3   ：1MHz自由计数，ARR=0xFFFF，回绕时置更新标志（TIM3_IRQHandler）
+//   捕获DMA：接收头每个边沿把CNT写入该通道CCRx和DMA目标缓冲区，NDTR递减，半满/全满时请求
+//            该通道的DMA中断（CH1~CH4 = DMA1_Stream4/5/7/2，由HAL_DMA_IRQHandler替身调用固件回调）
+//   SysTick：每1ms请求一次，处理函数累加HAL节拍并挂起PendSV（与stm32f4xx_it.c一致）
+//   PendSV ：处理函数调用Remote_Poll()，优先级由Remote_Init()设为最低
+//   TIM2   ：(PSC+1)*(ARR+1)个96MHz周期一次更新事件（软件PWM，TIM2_IRQHandler）
+//   TIM1   ：96MHz计数，每RCR+1个载波周期一次更新事件：预装载的RCR/CCR1生效，
+//            TIM1_UP DMA（DMA2_Stream5）按突发写入下一项，置更新标志（TIM1_UP_TIM10_IRQHandler）
+//            输出回环到全部接收头（CCR1非0的段为载波），用于发射路径的端到端测试
+//   外设事件：Sim_After()安排的一次性事件，开发板模型用于DMA2_Stream3（SPI1_TX）的传输完成
+//   NVIC   ：优先级取自固件的HAL_NVIC_SetPriority()（HAL默认分组4，只有抢占优先级），
+//            抢占优先级更高的请求立即抢占，其余等当前中断返回后按优先级、IRQn顺序执行；
+//            处理函数在进入时刻一次执行完，之后按执行时间占用CPU，期间主程序和低优先级中断停顿
+//   主程序 ：Sim_Advance()为忙等延时（按经过的时间计），Sim_Cpu()为占用CPU的工作（被中断时推后完成）
+// 限制：中断处理函数的效果在进入时刻一次生效；不模拟输入滤波（ICFilter）
+//////////////////////////////////////////////////////////////////////////////////
+
+TIM_TypeDef  sim_tim1;
+TIM_TypeDef  sim_tim2;
+TIM_TypeDef  sim_tim3;
+SysTick_Type sim_systick;
+CoreDebug_Type sim_coredebug;
+DMA_Stream_TypeDef sim_dma2_stream3;
+static DWT_Type sim_dwt;
+u8 sim_rdata[4]={1,1,1,1};              // 接收头空闲输出高电平
+
+u32 sim_poll_calls=0;
+unsigned long long sim_poll_ns=0;
+
+extern TIM_HandleTypeDef TIM1_Handler;
+extern TIM_HandleTypeDef TIM3_Handler;
+void TIM3_IRQHandler(void);
+void TIM1_UP_TIM10_IRQHandler(void);
+void DMA2_Stream5_IRQHandler(void);
+void TIM2_IRQHandler(void) __attribute__((weak));            // 软件PWM（USER/pwm.c，只有fw_sim链接）
+void HAL_TIM_Base_MspInit(TIM_HandleTypeDef *htim) __attribute__((weak));
+// 只有接了接收头的通道（IR_RX_CH_MASK）在固件中定义了DMA中断服务函数
+void DMA1_Stream4_IRQHandler(void) __attribute__((weak));
+void DMA1_Stream5_IRQHandler(void) __attribute__((weak));
+void DMA1_Stream7_IRQHandler(void) __attribute__((weak));
+void DMA1_Stream2_IRQHandler(void) __attribute__((weak));
+void DMA2_Stream3_IRQHandler(void) __attribute__((weak));             // SPI1 DMA传输引擎（只有fw_sim链接）
+void Sim_Dma_Started(DMA_HandleTypeDef *hdma) __attribute__((weak));  // 开发板模型：外设DMA启动
+
+#define SIM_TICK_NS     1000000ULL      // SysTick周期
+#define SIM_TIM_MHZ     96              // TIM1/TIM2计数时钟（APB1定时器时钟倍频后同为96MHz）
+#define SIM_IRQ_ENTRY_NS 230            // 异常进入12周期+退出10周期（96MHz）
+
+static unsigned long long sim_now=0;    // 虚拟时间（ns）
+static unsigned long long sim_next_tick=SIM_TICK_NS;
+static u32 sim_tick=0;                  // HAL_GetTick()节拍（ms）
+
+// 外部激励和结束时刻
+static void (*sim_src)(void)=0;
+static unsigned long long sim_src_at=0xFFFFFFFFFFFFFFFFULL;
+static unsigned long long sim_stop_at=0;
+static jmp_buf *sim_stop_jb=0;
+
+// 外设事件（开发板模型）
+static void (*sim_dev)(void)=0;
+static unsigned long long sim_dev_at=0xFFFFFFFFFFFFFFFFULL;
+static DMA_HandleTypeDef *sim_dma2_s3=0;  // 最近一次在DMA2_Stream3上启动的句柄（NVIC模型查询Pending）
+
+// TIM2软件PWM定时器
+static u8  sim_tim2_run=0;
+static unsigned long long sim_tim2_next=0;
+#define Sim_Tim2_Period()   ((unsigned long long)(sim_tim2.PSC+1)*(sim_tim2.ARR+1)*1000/SIM_TIM_MHZ)
+
+// TIM1发射模型
+#define SIM_TIM1_PER_US SIM_TIM_MHZ     // TIM1时钟周期/us
+static u8  sim_tx_run=0;                // 1=计数器运行中
+static u32 sim_tx_rcr=0,sim_tx_ccr=0;   // 重复计数器和比较值的影子寄存器
+static unsigned long long sim_tx_uev=0; // 下一次更新事件时刻（TIM1时钟周期）
+static u8  sim_tx_out=0;                // 发射管输出（1=载波）
+
+unsigned long long Sim_Host_Ns(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_MONOTONIC,&ts);
+	return (unsigned long long)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+// 本线程占用的主机CPU时间（ns）：中断执行时间按它折算，不计主机调度让出CPU的时间
+static unsigned long long Sim_Thread_Ns(void)
+{
+	struct timespec ts;
+	
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID,&ts);
+	return (unsigned long long)ts.tv_sec*1000000000ULL+ts.tv_nsec;
+}
+
+// DWT周期计数器替身：返回前把CYCCNT更新为主机时钟低32位（ns）
+DWT_Type *Sim_DWT(void)
+{
+	sim_dwt.CYCCNT=(u32)Sim_Host_Ns();
+	return &sim_dwt;
+}
+
+// ==================== HAL库替身 ====================
+void HAL_TIM_IC_Init(TIM_HandleTypeDef *htim)
+{
+	htim->Instance->ARR=htim->Init.Period;
+	HAL_TIM_IC_MspInit(htim);           // 与HAL库一致：由Init调用MspInit
+}
+
+void HAL_TIM_IC_ConfigChannel(TIM_HandleTypeDef *htim,TIM_IC_InitTypeDef *cfg,u32 channel)
+{
+	(void)htim;(void)cfg;(void)channel;
+}
+
+void HAL_TIM_IC_Start(TIM_HandleTypeDef *htim,u32 channel)
+{
+	TIM_CCxChannelCmd(htim->Instance,channel,TIM_CCx_ENABLE);
+	htim->Instance->CR1|=1;
+}
+
+// 通道捕获使能（CCxE）：关闭的通道不捕获边沿，也不产生DMA请求
+void TIM_CCxChannelCmd(TIM_TypeDef *tim,u32 channel,u32 state)
+{
+	tim->CCER&=~(TIM_CCER_CC1E<<channel);
+	tim->CCER|=state<<channel;
+}
+
+void HAL_TIM_PWM_Init(TIM_HandleTypeDef *htim)
+{
+	htim->Instance->ARR=htim->Init.Period;
+	htim->Instance->RCR=htim->Init.RepetitionCounter;
+	HAL_TIM_PWM_MspInit(htim);          // 与HAL库一致：由Init调用MspInit
+}
+
+void HAL_TIM_PWM_ConfigChannel(TIM_HandleTypeDef *htim,TIM_OC_InitTypeDef *cfg,u32 channel)
+{
+	(void)channel;
+	htim->Instance->CCR1=cfg->Pulse;
+}
+
+// 软件更新事件：预装载值装入影子寄存器，计数器清零（发射模型在下一次推进时间时按CEN重新起步）
+void HAL_TIM_GenerateEvent(TIM_HandleTypeDef *htim,u32 source)
+{
+	if(htim->Instance!=&sim_tim1||!(source&TIM_EVENTSOURCE_UPDATE)) return;
+	sim_tim1.CNT=0;
+	sim_tx_rcr=sim_tim1.RCR;
+	sim_tx_ccr=sim_tim1.CCR1;
+	sim_tx_run=0;
+}
+
+void HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+	htim->Instance->ARR=htim->Init.Period;
+	htim->Instance->PSC=htim->Init.Prescaler;
+	if(HAL_TIM_Base_MspInit) HAL_TIM_Base_MspInit(htim);   // 与HAL库一致：由Init调用MspInit
+}
+
+void HAL_TIM_Base_Start_IT(TIM_HandleTypeDef *htim)
+{
+	htim->Instance->DIER|=TIM_IT_UPDATE;
+	htim->Instance->CR1|=TIM_CR1_CEN;
+}
+
+void HAL_DMA_Init(DMA_HandleTypeDef *hdma)
+{
+	hdma->NDTR=0;
+	hdma->Pending=0;
+}
+
+// 目标地址为u32：仿真程序以-no-pie链接，静态变量地址在低4GB内，转换无损
+void HAL_DMA_Start_IT(DMA_HandleTypeDef *hdma,u32 src,u32 dst,u32 len)
+{
+	hdma->SrcAddress=src;
+	hdma->DstAddress=dst;
+	hdma->Dst=(u16*)(uintptr_t)dst;
+	hdma->Length=len;
+	hdma->NDTR=len;
+	hdma->Pending=0;
+	if(hdma->Instance==DMA2_Stream3) sim_dma2_s3=hdma;
+	if(Sim_Dma_Started) Sim_Dma_Started(hdma);
+}
+
+void HAL_DMA_IRQHandler(DMA_HandleTypeDef *hdma)
+{
+	u32 p=hdma->Pending;
+	
+	hdma->Pending=0;
+	if((p&1)&&hdma->XferHalfCpltCallback) hdma->XferHalfCpltCallback(hdma);
+	if((p&2)&&hdma->XferCpltCallback) hdma->XferCpltCallback(hdma);
+}
+
+void HAL_GPIO_Init(void *port,GPIO_InitTypeDef *init)
+{
+	(void)port;(void)init;
+}
+
+u32 HAL_GetTick(void)
+{
+	return sim_tick;
+}
+
+// ==================== 片内Flash ====================
+static u8 sim_flash[IR_LIB_FLASH_SIZE];
+static u8 sim_flash_ready=0;
+static u8 sim_flash_unlocked=0;
+u32 sim_flash_erases=0;
+
+static u8 *Sim_Flash_Ptr(u32 addr,u32 len)
+{
+	if(!sim_flash_ready)
+	{
+		memset(sim_flash,0xFF,sizeof(sim_flash));   // 出厂为擦除状态
+		sim_flash_ready=1;
+	}
+	if(addr<IR_LIB_FLASH_ADDR||addr+len>IR_LIB_FLASH_ADDR+IR_LIB_FLASH_SIZE) return 0;
+	return sim_flash+(addr-IR_LIB_FLASH_ADDR);
+}
+
+const void *Sim_Flash_Mem(u32 addr)
+{
+	return Sim_Flash_Ptr(addr,0);
+}
+
+HAL_StatusTypeDef HAL_FLASH_Unlock(void)
+{
+	sim_flash_unlocked=1;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Lock(void)
+{
+	sim_flash_unlocked=0;
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASH_Program(u32 type,u32 addr,uint64_t data)
+{
+	u32 len=(type==FLASH_TYPEPROGRAM_WORD)?4:1,i;
+	u8 *p=Sim_Flash_Ptr(addr,len);
+	
+	if(!p||!sim_flash_unlocked||(addr&(len-1))) return HAL_ERROR;
+	for(i=0;i<len;i++) p[i]&=(u8)(data>>(i*8));       // 编程只能清零位
+	return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_FLASHEx_Erase(FLASH_EraseInitTypeDef *init,u32 *err)
+{
+	u8 *p=Sim_Flash_Ptr(IR_LIB_FLASH_ADDR,0);
+	
+	if(!sim_flash_unlocked||init->Sector!=IR_LIB_FLASH_SECTOR||init->NbSectors!=1) return HAL_ERROR;
+	memset(p,0xFF,IR_LIB_FLASH_SIZE);
+	sim_flash_erases++;
+	*err=0xFFFFFFFFUL;
+	return HAL_OK;
+}
+
+void delay_ms(u16 nms)
+{
+	Sim_Advance((u32)nms*1000);
+}
+
+void delay_us(u32 nus)
+{
+	Sim_Advance(nus);
+}
+
+// ==================== NVIC模型 ====================
+// 中断请求线按电平判断（定时器为SR&DIER，DMA为传输完成标志，SysTick/PendSV为挂起位），
+// 处理函数没有清除请求时退出后再次进入，与硬件一致
+#define SIM_IRQ_NONE    0xFFFFFFFFFFFFFFFFULL
+#define SIM_STACK_MAX   16
+
+typedef struct
+{
+	const char *name;
+	IRQn_Type irqn;
+	void (*handler)(void);
+	TIM_TypeDef *tim;                   // 定时器更新中断：SR&DIER&UIF
+	DMA_HandleTypeDef **dma;            // DMA中断：句柄的Pending
+	u8  enabled;                        // HAL_NVIC_EnableIRQ()
+	u8  prio;                           // 抢占优先级（HAL默认NVIC_PRIORITYGROUP_4，子优先级不起作用）
+	unsigned long long raise;           // 请求有效的时刻（ns），SIM_IRQ_NONE=无请求
+	unsigned long long host_sum;        // 处理函数累计主机耗时（去掉离群值）
+	Sim_Irq_Stats st;
+} Sim_Irq;
+
+static u8 sim_systick_pend=0;
+static u8 sim_pendsv_pend=0;
+static void Sim_SysTick_Handler(void);
+static void Sim_PendSV_Handler(void);
+
+// 按IRQn排序：抢占优先级相同时IRQn小的先执行（PendSV为-2，SysTick为-1，最先）
+static Sim_Irq sim_irq[]=
+{
+	{"PendSV",      PendSV_IRQn,        Sim_PendSV_Handler,      0,         0,  1,  0},  // 始终使能，优先级由Remote_Init()设置
+	{"SysTick",     SysTick_IRQn,       Sim_SysTick_Handler,     0,         0,  1,  0},  // 始终使能，优先级0（sys.c）
+	{"DMA1_S2/CH4", DMA1_Stream2_IRQn,  DMA1_Stream2_IRQHandler, 0,         &TIM3_Handler.hdma[TIM_DMA_ID_CC4]},
+	{"DMA1_S4/CH1", DMA1_Stream4_IRQn,  DMA1_Stream4_IRQHandler, 0,         &TIM3_Handler.hdma[TIM_DMA_ID_CC1]},
+	{"DMA1_S5/CH2", DMA1_Stream5_IRQn,  DMA1_Stream5_IRQHandler, 0,         &TIM3_Handler.hdma[TIM_DMA_ID_CC2]},
+	{"TIM1_UP",     TIM1_UP_TIM10_IRQn, TIM1_UP_TIM10_IRQHandler,&sim_tim1, 0},
+	{"TIM2",        TIM2_IRQn,          TIM2_IRQHandler,         &sim_tim2, 0},
+	{"TIM3",        TIM3_IRQn,          TIM3_IRQHandler,         &sim_tim3, 0},
+	{"DMA1_S7/CH3", DMA1_Stream7_IRQn,  DMA1_Stream7_IRQHandler, 0,         &TIM3_Handler.hdma[TIM_DMA_ID_CC3]},
+	{"DMA2_S3/SPI1",DMA2_Stream3_IRQn,  DMA2_Stream3_IRQHandler, 0,         &sim_dma2_s3},
+	{"DMA2_S5/TX",  DMA2_Stream5_IRQn,  DMA2_Stream5_IRQHandler, 0,         &TIM1_Handler.hdma[TIM_DMA_ID_UPDATE]},
+};
+#define SIM_IRQ_N   (sizeof(sim_irq)/sizeof(sim_irq[0]))
+
+// 正在执行的中断（栈顶为当前执行的中断，下面是被抢占的）
+static struct
+{
+	u8  irq;                            // sim_irq[]下标
+	u32 left;                           // 剩余执行时间（ns）
+} sim_stack[SIM_STACK_MAX];
+static u8 sim_depth=0;
+
+u32 sim_cpu_scale=0;
+static u32 sim_host_overhead=0;         // 两次读主机时钟本身的耗时（ns）
+static u32 sim_host_glitches=0;         // 按离群值处理的次数
+#define SIM_HOST_GLITCH_NS  20000       // 处理函数的主机耗时超过该值视为主机被打断（虚拟机调度、缺页），按平均值计
+static unsigned long long sim_irq_ns=0; // 中断累计执行时间
+static unsigned long long sim_main_ns=0;// 主程序（Sim_Cpu）累计执行时间
+
+static Sim_Irq *Sim_Irq_Find(IRQn_Type irq)
+{
+	u32 i;
+	
+	for(i=0;i<SIM_IRQ_N;i++)
+		if(sim_irq[i].irqn==irq) return &sim_irq[i];
+	return 0;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type irq,u32 pre,u32 sub)
+{
+	Sim_Irq *q=Sim_Irq_Find(irq);
+	
+	(void)sub;
+	if(q) q->prio=(u8)pre;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type irq)
+{
+	Sim_Irq *q=Sim_Irq_Find(irq);
+	
+	if(q) q->enabled=1;
+}
+
+static u8 Sim_Irq_Active(const Sim_Irq *q)
+{
+	if(q->tim) return (q->tim->SR&q->tim->DIER&TIM_FLAG_UPDATE)!=0;
+	if(q->dma) return (*q->dma)&&(*q->dma)->Pending;
+	return (q->irqn==PendSV_IRQn)?sim_pendsv_pend:sim_systick_pend;
+}
+
+// 进入一个中断：处理函数在进入时刻一次执行完，之后按执行时间占用CPU
+// 执行时间 = 异常进入/退出开销 + 主机耗时×sim_cpu_scale（0=只计开销，结果与主机无关）
+static void Sim_Irq_Enter(u8 i)
+{
+	Sim_Irq *q=&sim_irq[i];
+	unsigned long long t0,host;
+	u32 lat,cost;
+	
+	lat=(u32)(sim_now-q->raise);
+	q->raise=SIM_IRQ_NONE;
+	q->st.count++;
+	q->st.lat_sum+=lat;
+	if(lat>q->st.lat_max) q->st.lat_max=lat;
+	if(sim_depth)
+	{
+		q->st.preempts++;
+		sim_irq[sim_stack[sim_depth-1].irq].st.preempted++;
+	}
+	
+	t0=Sim_Thread_Ns();
+	q->handler();
+	host=Sim_Thread_Ns()-t0;
+	host=(host>sim_host_overhead)?host-sim_host_overhead:0;
+	if(sim_cpu_scale&&host>SIM_HOST_GLITCH_NS)
+	{
+		host=q->host_sum/q->st.count;
+		sim_host_glitches++;
+	}
+	q->host_sum+=host;
+	cost=SIM_IRQ_ENTRY_NS+(u32)(host*sim_cpu_scale);
+	if(cost>q->st.cost_max) q->st.cost_max=cost;
+	
+	if(sim_depth>=SIM_STACK_MAX) return;    // 优先级只有16级，不会发生
+	sim_stack[sim_depth].irq=i;
+	sim_stack[sim_depth].left=cost;
+	sim_depth++;
+}
+
+// 执行全部可以抢占当前执行级别的中断请求
+static void Sim_Dispatch(void)
+{
+	u32 i,cur;
+	int best;
+	
+	for(;;)
+	{
+		cur=sim_depth?sim_irq[sim_stack[sim_depth-1].irq].prio:0x100;
+		best=-1;
+		for(i=0;i<SIM_IRQ_N;i++)
+		{
+			Sim_Irq *q=&sim_irq[i];
+			
+			if(!q->handler||!q->enabled) continue;
+			if(!Sim_Irq_Active(q))
+			{
+				q->raise=SIM_IRQ_NONE;
+				continue;
+			}
+			if(q->raise==SIM_IRQ_NONE) q->raise=sim_now;
+			if(q->prio<cur&&(best<0||q->prio<sim_irq[best].prio)) best=(int)i;
+		}
+		if(best<0) return;
+		Sim_Irq_Enter((u8)best);
+	}
+}
+
+// SysTick：HAL节拍加1并挂起PendSV（与stm32f4xx_it.c一致）
+static void Sim_SysTick_Handler(void)
+{
+	sim_systick_pend=0;
+	sim_tick++;
+	sim_systick.VAL=sim_systick.LOAD;
+	sim_pendsv_pend=1;
+}
+
+// PendSV：调用Remote_Poll()（与stm32f4xx_it.c一致）
+static void Sim_PendSV_Handler(void)
+{
+	unsigned long long t0;
+	
+	sim_pendsv_pend=0;
+	t0=Sim_Host_Ns();
+	Remote_Poll();
+	sim_poll_ns+=Sim_Host_Ns()-t0;
+	sim_poll_calls++;
+}
+
+// ==================== 虚拟时间 ====================
+void Sim_Reset(void)
+{
+	unsigned long long t0;
+	u32 i;
+	
+	sim_now=0;
+	sim_next_tick=SIM_TICK_NS;
+	sim_tick=0;
+	sim_tim3.CNT=0;
+	sim_tim3.SR=0;
+	sim_tim3.CCER=0;
+	memset(&sim_tim1,0,sizeof(sim_tim1));
+	memset(&sim_tim2,0,sizeof(sim_tim2));
+	sim_tx_run=0;
+	sim_tx_out=0;
+	sim_tim2_run=0;
+	sim_dev=0;
+	sim_dev_at=SIM_IRQ_NONE;
+	sim_dma2_s3=0;
+	memset(sim_rdata,1,sizeof(sim_rdata));
+	sim_poll_calls=0;
+	sim_poll_ns=0;
+	
+	sim_systick_pend=0;
+	sim_pendsv_pend=0;
+	sim_depth=0;
+	sim_irq_ns=0;
+	sim_main_ns=0;
+	sim_host_glitches=0;
+	for(i=0;i<SIM_IRQ_N;i++)
+	{
+		sim_irq[i].raise=SIM_IRQ_NONE;
+		sim_irq[i].host_sum=0;
+		memset(&sim_irq[i].st,0,sizeof(sim_irq[i].st));
+	}
+	sim_host_overhead=0xFFFFFFFF;
+	for(i=0;i<16;i++)
+	{
+		t0=Sim_Thread_Ns();
+		t0=Sim_Thread_Ns()-t0;
+		if(t0<sim_host_overhead) sim_host_overhead=(u32)t0;
+	}
+}
+
+unsigned long long Sim_Now(void)
+{
+	return sim_now/1000;
+}
+
+u32 Sim_Cycles(void)
+{
+	return (u32)(sim_now*SIM_TIM_MHZ/1000);
+}
+
+void Sim_Source(void (*fn)(void),unsigned long long at_us)
+{
+	sim_src=fn;
+	sim_src_at=at_us*1000;
+}
+
+void Sim_Stop_At(unsigned long long us,jmp_buf *jb)
+{
+	sim_stop_at=us*1000;
+	sim_stop_jb=jb;
+}
+
+void Sim_After(void (*fn)(void),u32 ns)
+{
+	sim_dev=fn;
+	sim_dev_at=sim_now+ns;
+}
+
+// ==================== TIM1发射模型 ====================
+static void Sim_Tx_Output(u8 mark)
+{
+	if(mark==sim_tx_out) return;
+	sim_tx_out=mark;
+	Sim_Edge(mark?0:1);                 // 回环：全部接收头看到发射的载波
+}
+
+// 计数器启停：固件直接写CR1，每次推进时间前同步
+static void Sim_Tx_Sync(void)
+{
+	if((sim_tim1.CR1&TIM_CR1_CEN)&&!sim_tx_run)
+	{
+		sim_tx_run=1;
+		sim_tx_uev=Sim_Now()*SIM_TIM1_PER_US+(unsigned long long)(sim_tx_rcr+1)*(sim_tim1.ARR+1);
+		Sim_Tx_Output(sim_tx_ccr!=0);
+	}
+	else if(!(sim_tim1.CR1&TIM_CR1_CEN)&&sim_tx_run)
+	{
+		sim_tx_run=0;
+		Sim_Tx_Output(0);
+	}
+}
+
+// 更新事件：置更新标志，预装载值生效，DMA突发写入下一项（DCR：从RCR开始的2个寄存器）
+// 最后一项传输完成时置DMA完成标志；两个中断按NVIC优先级执行
+static void Sim_Tx_Update(void)
+{
+	DMA_HandleTypeDef *h=TIM1_Handler.hdma[TIM_DMA_ID_UPDATE];
+	const u16 *src;
+	u32 pos;
+	
+	sim_tim1.SR|=TIM_FLAG_UPDATE;
+	sim_tx_rcr=sim_tim1.RCR;
+	sim_tx_ccr=sim_tim1.CCR1;
+	sim_tx_uev+=(unsigned long long)(sim_tx_rcr+1)*(sim_tim1.ARR+1);
+	Sim_Tx_Output(sim_tx_ccr!=0);
+	if((sim_tim1.DIER&TIM_DIER_UDE)&&h&&h->NDTR>=2)
+	{
+		src=(const u16*)(uintptr_t)h->SrcAddress;
+		pos=h->Length-h->NDTR;
+		sim_tim1.RCR=src[pos];
+		sim_tim1.CCR1=src[pos+1];
+		h->NDTR-=2;
+		if(!h->NDTR) h->Pending|=2;
+	}
+}
+
+// TIM2：HAL_TIM_Base_Start_IT()后按(PSC+1)*(ARR+1)个96MHz时钟周期一次更新事件
+static void Sim_Tim2_Sync(void)
+{
+	if((sim_tim2.CR1&TIM_CR1_CEN)&&!sim_tim2_run)
+	{
+		sim_tim2_run=1;
+		sim_tim2_next=sim_now+Sim_Tim2_Period();
+	}
+	else if(!(sim_tim2.CR1&TIM_CR1_CEN)) sim_tim2_run=0;
+}
+
+// 推进到下一个事件（不超过limit）并执行期间到期的硬件事件和中断
+// 返回值：这段时间中主程序得到的CPU时间（ns，有中断在执行时为0）
+static unsigned long long Sim_Step(unsigned long long limit)
+{
+	unsigned long long wrap,next,uev=0,dt;
+	
+	Sim_Tx_Sync();
+	Sim_Tim2_Sync();
+	Sim_Dispatch();
+	
+	wrap=((sim_now/1000)|0xFFFFULL)+1;  // 下一次TIM3回绕时刻
+	wrap*=1000;
+	next=limit;
+	if(wrap<next) next=wrap;
+	if(sim_next_tick<next) next=sim_next_tick;
+	if(sim_tim2_run&&sim_tim2_next<next) next=sim_tim2_next;
+	if(sim_src&&sim_src_at<next) next=sim_src_at;
+	if(sim_dev&&sim_dev_at<next) next=sim_dev_at;
+	if(sim_tx_run)
+	{
+		uev=(sim_tx_uev+SIM_TIM1_PER_US-1)/SIM_TIM1_PER_US*1000;
+		if(uev<next) next=uev;
+	}
+	if(sim_depth&&sim_now+sim_stack[sim_depth-1].left<next) next=sim_now+sim_stack[sim_depth-1].left;
+	if(next<sim_now) next=sim_now;
+	
+	dt=next-sim_now;
+	sim_now=next;
+	sim_tim3.CNT=(u16)(sim_now/1000);
+	if(sim_depth)
+	{
+		sim_stack[sim_depth-1].left-=(u32)dt;
+		sim_irq[sim_stack[sim_depth-1].irq].st.busy+=dt;
+		sim_irq_ns+=dt;
+		if(!sim_stack[sim_depth-1].left) sim_depth--;   // 中断返回（被抢占的中断继续执行）
+		dt=0;
+	}
+	
+	if(sim_now==wrap) sim_tim3.SR|=TIM_FLAG_UPDATE;
+	if(sim_now==sim_next_tick)
+	{
+		sim_next_tick+=SIM_TICK_NS;
+		sim_systick_pend=1;
+	}
+	if(sim_tim2_run&&sim_now==sim_tim2_next)
+	{
+		sim_tim2_next+=Sim_Tim2_Period();
+		sim_tim2.SR|=TIM_FLAG_UPDATE;
+	}
+	if(sim_tx_run&&sim_now==uev) Sim_Tx_Update();
+	if(sim_dev&&sim_now==sim_dev_at)
+	{
+		void (*fn)(void)=sim_dev;
+		
+		sim_dev=0;
+		sim_dev_at=SIM_IRQ_NONE;
+		fn();                           // 外设事件：置DMA完成标志等（可在其中安排下一次）
+	}
+	if(sim_src&&sim_now==sim_src_at)
+	{
+		sim_src_at=SIM_IRQ_NONE;
+		sim_src();                      // 外部激励：输出边沿并设置下一次的时刻
+	}
+	Sim_Tx_Sync();
+	Sim_Tim2_Sync();
+	Sim_Dispatch();
+	return dt;
+}
+
+// 主程序中调用：到达结束时刻时返回到Sim_Stop_At()的调用者
+static void Sim_Check_Stop(void)
+{
+	if(sim_stop_jb&&sim_now>=sim_stop_at) longjmp(*sim_stop_jb,1);
+}
+
+// 推进虚拟时间（主程序的忙等延时：按实际经过的时间计，期间的中断不延长）
+void Sim_Advance(u32 us)
+{
+	unsigned long long t=sim_now+(unsigned long long)us*1000;
+	
+	do Sim_Step(t);
+	while(sim_now<t);
+	Sim_Check_Stop();
+}
+
+// 主程序执行ns的CPU时间：期间执行的中断把完成时刻相应推后
+// 不检查结束时刻：调用者可能在stdio内部（串口模型），结束只发生在忙等延时中
+void Sim_Cpu(u32 ns)
+{
+	unsigned long long left=ns;
+	
+	sim_main_ns+=ns;
+	while(left) left-=Sim_Step(sim_now+left);
+}
+
+// 边沿：双边沿捕获，CNT写入CCRx并由该通道的DMA搬运到环形缓冲区，半满/全满时请求DMA中断
+void Sim_Edge_Rx(u8 ch,u8 level)
+{
+	static volatile u32 *const ccr[4]={&sim_tim3.CCR1,&sim_tim3.CCR2,&sim_tim3.CCR3,&sim_tim3.CCR4};
+	DMA_HandleTypeDef *h=TIM3_Handler.hdma[TIM_DMA_ID_CC1+ch];
+	u32 pos;
+	
+	if(level==sim_rdata[ch]) return;
+	sim_rdata[ch]=level;
+	if(!(sim_tim3.CCER&(TIM_CCER_CC1E<<(4*ch)))) return;      // 捕获未使能（含边沿风暴屏蔽期间）
+	*ccr[ch]=sim_tim3.CNT;
+	if(!h||!h->Dst||!(sim_tim3.DIER&(TIM_DMA_CC1<<ch))) return;   // 该通道未接接收头或DMA未启动
+	
+	pos=h->Length-h->NDTR;
+	h->Dst[pos]=(u16)*ccr[ch];
+	h->NDTR--;
+	if(h->NDTR==h->Length/2) h->Pending|=1;
+	if(h->NDTR==0)
+	{
+		h->NDTR=h->Length;              // 循环模式
+		h->Pending|=2;
+	}
+	if(h->Pending) Sim_Dispatch();
+}
+
+// 全部接收头同时看到同一个边沿
+void Sim_Edge(u8 level)
+{
+	u8 ch;
+	
+	for(ch=0;ch<4;ch++) Sim_Edge_Rx(ch,level);
+}
+
+void Sim_Segment(u8 mark,u32 us)
+{
+	Sim_Edge(mark?0:1);                 // 载波期间接收头输出低电平
+	Sim_Advance(us);
+}
+
+// ==================== 中断统计 ====================
+const Sim_Irq_Stats *Sim_Irq_Get(u32 i,const char **name,u8 *prio)
+{
+	if(i>=SIM_IRQ_N||!sim_irq[i].handler||!sim_irq[i].enabled) return 0;
+	*name=sim_irq[i].name;
+	*prio=sim_irq[i].prio;
+	return &sim_irq[i].st;
+}
+
+void Sim_Print_Irq(void)
+{
+	unsigned long long t=sim_now?sim_now:1;
+	const Sim_Irq_Stats *s;
+	const char *name;
+	u8 prio;
+	u32 i;
+	
+	printf("  %-12s %4s %9s %9s %9s %9s %9s %7s %8s %9s\n","irq","prio","count","lat avg","lat max",
+	       "cost avg","cost max","load","preempt","preempted");
+	for(i=0;i<SIM_IRQ_N;i++)
+	{
+		if(!(s=Sim_Irq_Get(i,&name,&prio))||!s->count) continue;
+		printf("  %-12s %4u %9u %7.2fus %7.2fus %7.2fus %7.2fus %6.3f%% %8u %9u\n",name,prio,s->count,
+		       s->lat_sum/1e3/s->count,s->lat_max/1e3,s->busy/1e3/s->count,s->cost_max/1e3,
+		       s->busy*100.0/t,s->preempts,s->preempted);
+	}
+	printf("  cpu load %.3f%% in interrupts, %.3f%% main program, %.3f%% idle/delay (cost = %uns entry + host ns x %u, %u host outliers)\n",
+	       sim_irq_ns*100.0/t,sim_main_ns*100.0/t,(t-sim_irq_ns-sim_main_ns)*100.0/t,SIM_IRQ_ENTRY_NS,sim_cpu_scale,sim_host_glitches);
+}
@@ -0,0 +1,43 @@
+#ifndef __SIM_MCU_H
+#define __SIM_MCU_H
+#include <setjmp.h>
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 主机虚拟MCU
+// 功能说明：按虚拟时间驱动TIM3计数器、TIM3_CH1~CH4双边沿捕获DMA、1ms SysTick（挂起PendSV解码）和TIM2，
+//          经NVIC模型（抢占优先级、等待、嵌套）调用固件的中断服务函数并统计中断延迟、抢占和CPU负载
+//          TIM1发射（更新事件DMA改写RCR/CCR1）的输出回环到全部接收头
+// 说明：虚拟时间推进与主机实际耗时无关，回放速度只受主机CPU限制
+//////////////////////////////////////////////////////////////////////////////////
+
+extern u32 sim_poll_calls;              // Remote_Poll()调用次数
+extern unsigned long long sim_poll_ns;  // Remote_Poll()累计主机耗时（ns）
+extern u32 sim_cpu_scale;               // 中断执行时间 = 进入开销 + 主机耗时×sim_cpu_scale（0=只计进入开销）
+
+// 单个中断的统计（时间单位ns）
+typedef struct
+{
+	u32 count;                          // 执行次数
+	u32 preempts;                       // 抢占了其他中断的次数
+	u32 preempted;                      // 被其他中断抢占的次数
+	u32 lat_max;                        // 最大延迟（请求到进入）
+	u32 cost_max;                       // 最长执行时间
+	unsigned long long lat_sum;         // 延迟累计
+	unsigned long long busy;            // 执行时间累计（占用CPU的时间）
+} Sim_Irq_Stats;
+
+void Sim_Reset(void);
+unsigned long long Sim_Now(void);       // 当前虚拟时间（us，64位）
+void Sim_Advance(u32 us);               // 推进虚拟时间（忙等延时），期间执行到期的中断
+void Sim_Cpu(u32 ns);                   // 主程序占用ns的CPU时间（被中断抢占时推后完成）
+void Sim_Source(void (*fn)(void),unsigned long long at_us);  // 在at_us时刻调用fn（外部激励，fn中再次调用以安排下一次）
+void Sim_Stop_At(unsigned long long us,jmp_buf *jb);         // 主程序延时（Sim_Advance）到达us时longjmp(*jb,1)
+void Sim_After(void (*fn)(void),u32 ns); // ns之后调用fn（开发板模型的外设事件，只有一个，再次调用时取代）
+void Sim_Edge(u8 level);                // 当前时刻全部接收头输出变为level（电平不变则忽略）
+void Sim_Edge_Rx(u8 ch,u8 level);       // 当前时刻TIM3通道ch（0~3）的接收头输出变为level
+void Sim_Segment(u8 mark,u32 us);       // 输出一个电平段：mark=1载波（低电平），0间隔（高电平）
+unsigned long long Sim_Host_Ns(void);   // 主机单调时钟（ns），用于统计耗时
+const Sim_Irq_Stats *Sim_Irq_Get(u32 i,const char **name,u8 *prio);   // 第i个中断的统计，NULL=不存在或未使能
+void Sim_Print_Irq(void);               // 输出中断延迟、执行时间、抢占次数和CPU负载
+
+#endif
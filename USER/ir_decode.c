@@ -0,0 +1,709 @@
+#include "ir_decode.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 多协议红外解码引擎
+// 功能说明：把"载波/间隔 + 持续时间"序列解码为协议帧（协议、地址、命令、重复标志）
+// 解码原理：协议表ir_protocols[]描述每种协议的时序，按编码方式分为三类状态机：
+//          间隔宽度编码（NEC/Samsung）、脉冲宽度编码（SIRC）、曼彻斯特编码（RC5/RC6）
+//          每个电平段依次送给所有已使能的协议，最先完成且校验通过的协议胜出
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 协议时序表 ====================
+// 注意：NEC在扩展NEC之前，校验更严格的协议优先匹配
+const IR_Protocol ir_protocols[IR_PROTO_COUNT]=
+{
+    // 名称      编号              编码方式                  校验方式          标志                 引导载波 引导间隔 重复间隔 0载波 0间隔 1载波 1间隔 最少 最多 尾标位 容差
+    {"NEC",     IR_PROTO_NEC,     IR_CODING_PULSE_DISTANCE, IR_CHECK_NEC,     0,                  9000,   4500,   2250,    560,  560,  560,  1690, 32,  32,  0xFF,  30},
+    {"NEC-EXT", IR_PROTO_NECX,    IR_CODING_PULSE_DISTANCE, IR_CHECK_NECX,    0,                  9000,   4500,   2250,    560,  560,  560,  1690, 32,  32,  0xFF,  30},
+    {"SAMSUNG", IR_PROTO_SAMSUNG, IR_CODING_PULSE_DISTANCE, IR_CHECK_SAMSUNG, 0,                  4500,   4500,   0,       560,  560,  560,  1690, 32,  32,  0xFF,  30},
+    {"SIRC",    IR_PROTO_SIRC,    IR_CODING_PULSE_WIDTH,    IR_CHECK_SIRC,    IR_FLAG_LSB_FIRST,  2400,   600,    0,       600,  600,  1200, 600,  12,  20,  0xFF,  30},
+    {"RC5",     IR_PROTO_RC5,     IR_CODING_MANCHESTER,     IR_CHECK_RC5,     0,                  0,      0,      0,       889,  889,  889,  889,  14,  14,  0xFF,  30},
+    {"RC6",     IR_PROTO_RC6,     IR_CODING_MANCHESTER,     IR_CHECK_RC6,     IR_FLAG_MARK_FIRST, 2666,   889,    0,       444,  444,  444,  444,  21,  21,  4,     30},
+};
+
+// 状态机公共状态（三种编码方式共用编号）
+#define IR_ST_IDLE          0   // 等待引导码载波（无引导码协议：等待第一个载波）
+#define IR_ST_HDR_SPACE     1   // 等待引导码间隔
+#define IR_ST_BIT_MARK      2   // 等待数据位载波
+#define IR_ST_BIT_SPACE     3   // 等待数据位间隔
+#define IR_ST_RPT_MARK      4   // 等待重复码结束载波（NEC）
+#define IR_ST_MANCHESTER    5   // 曼彻斯特数据接收中
+
+// 单步处理结果
+#define IR_STEP_NONE        0   // 继续接收
+#define IR_STEP_FRAME       1   // 收到完整数据，待校验
+#define IR_STEP_REPEAT      2   // 收到重复码
+
+#define IR_GAP_US           8000    // 超过该宽度的间隔视为帧间空闲（允许RC5开始新帧）
+
+// 判断实测宽度是否在参考宽度的容差范围内
+static u8 IR_Match(u32 dur,u32 ref,u8 tol)
+{
+	u32 d=ref*tol/100;
+
+	if(dur>ref) return (dur-ref)<=d;
+	return (ref-dur)<=d;
+}
+
+// 按本帧锁定的时钟比例和载波展宽，把标称宽度换算为期望的实测宽度
+static u32 IR_Ref(const IR_ProtoState *s,u32 nom,u8 mark)
+{
+	s32 r=(s32)((nom*s->scale)>>10)+(mark?s->bias:-s->bias);
+
+	return r>0?(u32)r:1;
+}
+
+// 锁定后的期望宽度更准确，使用较窄的容差，避免与时序成比例的其他协议混淆
+#define IR_TOL_LOCKED(p)    ((p)->tolerance*2/3)
+
+// 按锁定时序或标称时序匹配：锁定窗口跟随遥控器移动且更窄，标称窗口始终保留，
+// 引导码估计偏差较大时不会比固定窗口更差
+static u8 IR_Match_Adapt(const IR_Protocol *p,const IR_ProtoState *s,u32 dur,u16 nom,u8 mark)
+{
+	return IR_Match(dur,IR_Ref(s,nom,mark),IR_TOL_LOCKED(p))||IR_Match(dur,nom,p->tolerance);
+}
+
+// 限制时钟比例和载波展宽的范围（展宽不超过数据载波的1/3，防止噪声把参数带偏）
+static void IR_Clamp(const IR_Protocol *p,IR_ProtoState *s,s32 scale,s32 bias)
+{
+	s32 bmax=p->zero_mark/3;
+
+	if(scale<IR_SCALE_MIN) scale=IR_SCALE_MIN;
+	if(scale>IR_SCALE_MAX) scale=IR_SCALE_MAX;
+	if(bias>bmax) bias=bmax;
+	if(bias<-bmax) bias=-bmax;
+	s->scale=(u16)scale;
+	s->bias=(s16)bias;
+}
+
+// 设置本帧的锁定值，跟踪从锁定值开始
+// 锁定值接近标称时本帧只用标称窗口（与固定窗口解码完全一致，抖动大时不受锁定误差影响）
+static void IR_Set_Lock(const IR_Protocol *p,IR_ProtoState *s,s32 scale,s32 bias)
+{
+	s32 d;
+
+	IR_Clamp(p,s,scale,bias);
+	s->lock=s->scale;
+	s->nerr=0;
+	s->err_sum=0;
+	d=(s32)s->scale-IR_SCALE_ONE;
+	s->adapt=(d>(IR_SCALE_ONE>>IR_NOMINAL_SHIFT)||d<-(IR_SCALE_ONE>>IR_NOMINAL_SHIFT)||
+	          s->bias*8>p->zero_mark||-s->bias*8>p->zero_mark);
+}
+
+// 引导码结束：用引导码载波+间隔的总宽度估计时钟比例（载波展宽在总宽度中抵消）
+// 单帧无法区分引导码抖动和晶振偏差，锁定值只从学习值向实测值移动1/3，
+// 偏差持续存在时由逐帧学习收敛；展宽从学习值开始，由数据位载波跟踪
+static void IR_Lock(const IR_Protocol *p,IR_ProtoState *s,u16 nom_space,u32 space)
+{
+	s32 k=(s32)(((u32)s->lead+space)*IR_SCALE_ONE/(p->hdr_mark+nom_space));
+
+	IR_Set_Lock(p,s,s->cal_scale+(k-s->cal_scale)/3,s->cal_bias);
+}
+
+// 接收过程中跟踪：err为实测宽度与期望宽度之差
+// 时钟偏差使载波和间隔同向偏离，载波展宽使二者反向偏离，交替的载波/间隔把两者分开
+// 时钟比例只在锁定值附近跟踪，防止时序成比例的其他协议（SIRC约为RC5的2/3）被逐步"拉"过去
+static void IR_Track(const IR_Protocol *p,IR_ProtoState *s,u8 mark,s32 err,u32 nom)
+{
+	s32 scale=s->scale+err*IR_SCALE_ONE/(s32)nom/8;
+	s32 range=s->lock>>IR_TRACK_SHIFT;
+
+	s->err_sum+=(err<0)?-err:err;   // 信号质量统计
+	s->nerr++;
+	if(scale>s->lock+range) scale=s->lock+range;
+	if(scale<s->lock-range) scale=s->lock-range;
+	IR_Clamp(p,s,scale,s->bias+(mark?err:-err)/8);
+}
+
+// 数据位分类：实测宽度在"0"和"1"期望宽度的中点以上为1，超出两端容差返回0xFF
+// 锁定值接近标称时先按标称窗口判定，不符再按锁定窗口；偏离标称时窗口取二者并集
+static u8 IR_Classify(const IR_Protocol *p,IR_ProtoState *s,u8 mark,u32 dur,u16 nom0,u16 nom1)
+{
+	u32 r0=IR_Ref(s,nom0,mark),r1=IR_Ref(s,nom1,mark);
+	u32 lo=r0-r0*IR_TOL_LOCKED(p)/100,hi=r1+r1*IR_TOL_LOCKED(p)/100;
+	u32 nlo=nom0-(u32)nom0*p->tolerance/100,nhi=nom1+(u32)nom1*p->tolerance/100;
+	u8 bit;
+
+	if(!s->adapt&&IR_Match(dur,nom0,p->tolerance)) bit=0;
+	else if(!s->adapt&&IR_Match(dur,nom1,p->tolerance)) bit=1;
+	else
+	{
+		if(s->adapt&&nlo<lo) lo=nlo;
+		if(s->adapt&&nhi>hi) hi=nhi;
+		if(dur<lo||dur>hi) return 0xFF;
+		bit=(2*dur>=r0+r1);
+	}
+	IR_Track(p,s,mark,(s32)dur-(s32)(bit?r1:r0),bit?nom1:nom0);
+	return bit;
+}
+
+// 把一个数据位写入接收数据
+static void IR_Push_Bit(const IR_Protocol *p,IR_ProtoState *s,u8 bit)
+{
+	if(p->flags&IR_FLAG_LSB_FIRST) s->data|=(u32)bit<<s->nbits;  // 低位先发
+	else s->data=(s->data<<1)|bit;                                 // 按接收顺序高位在前
+	s->nbits++;
+}
+
+// 状态机复位；若当前电平段本身就是引导码载波，直接进入等待引导码间隔状态
+// 引导码按标称宽度或该协议学习到的宽度匹配（窗口大小不变，只是中心随学习值移动）
+// 先按载波宽度粗略估计时钟比例，引导码间隔到达后由IR_Lock重新锁定
+static u8 IR_Restart(const IR_Protocol *p,IR_ProtoState *s,u8 mark,u32 dur)
+{
+	s->state=IR_ST_IDLE;
+	s->nbits=0;
+	s->data=0;
+	if(p->hdr_mark&&mark&&(IR_Match(dur,p->hdr_mark,p->tolerance)||
+	   IR_Match(dur,(((u32)p->hdr_mark*s->cal_scale)>>10)+s->cal_bias,p->tolerance)))
+	{
+		s->lead=(u16)dur;
+		IR_Set_Lock(p,s,(s32)((dur-s->cal_bias)*IR_SCALE_ONE/p->hdr_mark),s->cal_bias);
+		s->state=IR_ST_HDR_SPACE;
+	}
+	return IR_STEP_NONE;
+}
+
+// ==================== 间隔宽度编码（NEC/扩展NEC/Samsung） ====================
+// 帧结构：引导载波 + 引导间隔 + N×(固定载波 + 0/1间隔) + 结束载波
+// 重复码（NEC）：引导载波 + 重复间隔 + 结束载波
+static u8 IR_Feed_PulseDistance(const IR_Protocol *p,IR_ProtoState *s,u8 mark,u32 dur)
+{
+	u32 ref;
+	u8 bit;
+
+	switch(s->state)
+	{
+		case IR_ST_HDR_SPACE:
+			if(mark) break;
+			if(IR_Match_Adapt(p,s,dur,p->hdr_space,0))
+			{
+				IR_Lock(p,s,p->hdr_space,dur);
+				s->state=IR_ST_BIT_MARK;
+				return IR_STEP_NONE;
+			}
+			if(p->rpt_space&&IR_Match_Adapt(p,s,dur,p->rpt_space,0))
+			{
+				IR_Lock(p,s,p->rpt_space,dur);
+				s->state=IR_ST_RPT_MARK;
+				return IR_STEP_NONE;
+			}
+			break;
+
+		case IR_ST_BIT_MARK:
+			if(!mark) break;
+			ref=IR_Ref(s,p->zero_mark,1);
+			if(IR_Match_Adapt(p,s,dur,p->zero_mark,1))
+			{
+				IR_Track(p,s,1,(s32)dur-(s32)ref,p->zero_mark);
+				s->state=IR_ST_BIT_SPACE;
+				return IR_STEP_NONE;
+			}
+			break;
+
+		case IR_ST_BIT_SPACE:
+			if(mark) break;
+			bit=IR_Classify(p,s,0,dur,p->zero_space,p->one_space);
+			if(bit==0xFF) break;
+			IR_Push_Bit(p,s,bit);
+			if(s->nbits>=p->max_bits)
+			{
+				s->state=IR_ST_IDLE;
+				return IR_STEP_FRAME;
+			}
+			s->state=IR_ST_BIT_MARK;
+			return IR_STEP_NONE;
+
+		case IR_ST_RPT_MARK:
+			if(mark&&IR_Match_Adapt(p,s,dur,p->zero_mark,1))
+			{
+				s->state=IR_ST_IDLE;
+				return IR_STEP_REPEAT;
+			}
+			break;
+	}
+	return IR_Restart(p,s,mark,dur);
+}
+
+// ==================== 脉冲宽度编码（Sony SIRC） ====================
+// 帧结构：引导载波 + N×(固定间隔 + 0/1载波)，帧以长间隔结束，位数可变（12/15/20）
+static u8 IR_Feed_PulseWidth(const IR_Protocol *p,IR_ProtoState *s,u8 mark,u32 dur)
+{
+	u32 ref;
+	u8 bit;
+
+	switch(s->state)
+	{
+		case IR_ST_HDR_SPACE:
+		case IR_ST_BIT_SPACE:
+			if(mark) break;
+			ref=IR_Ref(s,p->zero_space,0);
+			if(IR_Match_Adapt(p,s,dur,p->zero_space,0)&&s->nbits<p->max_bits)
+			{
+				if(s->state==IR_ST_HDR_SPACE) IR_Lock(p,s,p->hdr_space,dur);
+				else IR_Track(p,s,0,(s32)dur-(s32)ref,p->zero_space);
+				s->state=IR_ST_BIT_MARK;
+				return IR_STEP_NONE;
+			}
+			if(s->state==IR_ST_BIT_SPACE&&dur>ref&&s->nbits>=p->min_bits)
+			{
+				s->state=IR_ST_IDLE;   // 长间隔：帧结束
+				return IR_STEP_FRAME;
+			}
+			break;
+
+		case IR_ST_BIT_MARK:
+			if(!mark) break;
+			bit=IR_Classify(p,s,1,dur,p->zero_mark,p->one_mark);
+			if(bit==0xFF) break;
+			IR_Push_Bit(p,s,bit);
+			s->state=IR_ST_BIT_SPACE;
+			return IR_STEP_NONE;
+	}
+	return IR_Restart(p,s,mark,dur);
+}
+
+// ==================== 曼彻斯特编码（RC5/RC6） ====================
+// 以半位宽度T为单位处理：每个电平段折算为1~3个T单位，逐单位送入位解析
+// RC6的尾标位（trailer_bit）每个半位占2T
+
+// 计算电平段包含的T单位数（取最接近的整数），不在容差范围内返回0
+// near=1：最接近的整数超出容差时再试相邻的另一个整数。容差按比例计算，nT的窗口随n变宽，
+//        例如2T短25%时为1.5T，舍入成1T超出容差，而2T在容差内
+static u8 IR_Units(u32 dur,u32 t,u8 tol,u8 max_units,u8 near)
+{
+	u32 n;
+
+	if(dur>(u32)t*(max_units+1)) return 0;
+	n=(dur+t/2)/t;
+	if(n>=1&&n<=max_units&&IR_Match(dur,n*t,tol)) return (u8)n;
+	if(!near) return 0;
+	n=(n*t>dur)?n-1:n+1;
+	if(n>=1&&n<=max_units&&IR_Match(dur,n*t,tol)) return (u8)n;
+	return 0;
+}
+
+// 开始接收曼彻斯特数据
+static void IR_Manchester_Start(IR_ProtoState *s)
+{
+	s->state=IR_ST_MANCHESTER;
+	s->nbits=0;
+	s->data=0;
+	s->half=0;
+	s->units=0;
+}
+
+// 处理一个T单位，返回0表示电平序列不符合曼彻斯特规则
+static u8 IR_Manchester_Unit(const IR_Protocol *p,IR_ProtoState *s,u8 mark)
+{
+	u8 width=(s->nbits==p->trailer_bit)?2:1;  // 当前半位的宽度（T单位数）
+
+	if(s->units==0)
+	{
+		if(s->half==0) s->first=mark;              // 前半位开始
+		else if(mark==s->first) return 0;          // 后半位必须与前半位电平相反
+	}
+	else if(mark!=(s->half?!s->first:s->first)) return 0;  // 双倍宽度半位内电平必须一致
+
+	s->units++;
+	if(s->units>=width)
+	{
+		s->units=0;
+		if(s->half==0) s->half=1;
+		else
+		{
+			s->half=0;
+			IR_Push_Bit(p,s,(p->flags&IR_FLAG_MARK_FIRST)?s->first:!s->first);
+		}
+	}
+	return 1;
+}
+
+static u8 IR_Feed_Manchester(const IR_Protocol *p,IR_ProtoState *s,u8 mark,u32 dur,u8 gap)
+{
+	u8 n,i,max;
+	u32 t;
+	s32 adj;
+
+	switch(s->state)
+	{
+		case IR_ST_IDLE:
+			if(p->hdr_mark) return IR_Restart(p,s,mark,dur);
+			if(!mark||!gap) return IR_STEP_NONE;
+			// 无引导码（RC5）：没有可锁定的引导码，从学习值开始，接收过程中跟踪
+			// 起始位S1=1的前半位间隔与帧前空闲合并，这里补上
+			IR_Set_Lock(p,s,s->cal_scale,s->cal_bias);
+			IR_Manchester_Start(s);
+			IR_Manchester_Unit(p,s,0);
+			break;
+
+		case IR_ST_HDR_SPACE:
+			if(!mark&&IR_Match_Adapt(p,s,dur,p->hdr_space,0))
+			{
+				IR_Lock(p,s,p->hdr_space,dur);
+				IR_Manchester_Start(s);
+				return IR_STEP_NONE;
+			}
+			return IR_Restart(p,s,mark,dur);
+	}
+
+	// 折算单位数：锁定时序去掉载波展宽后按锁定的半位宽度T折算，标称时序按标称T折算
+	// 与IR_Classify相同，锁定值接近标称时标称优先，偏离标称时锁定优先；
+	// 都不符时再按标称T试相邻的单位数（时钟偏差大、RC5没有引导码可锁定时）
+	max=(p->trailer_bit!=0xFF)?3:2;
+	t=((u32)p->zero_mark*s->scale)>>10;
+	adj=(s32)dur-(mark?s->bias:-s->bias);
+	n=(s->adapt&&adj>0)?IR_Units((u32)adj,t,IR_TOL_LOCKED(p),max,0):0;
+	if(n==0) n=IR_Units(dur,p->zero_mark,p->tolerance,max,0);
+	if(n==0&&!s->adapt&&adj>0) n=IR_Units((u32)adj,t,IR_TOL_LOCKED(p),max,0);
+	if(n==0) n=IR_Units(dur,p->zero_mark,p->tolerance,max,1);
+	if(n==0) return IR_Restart(p,s,mark,dur);
+	IR_Track(p,s,mark,adj-(s32)(n*t),(u32)n*p->zero_mark);
+	for(i=0;i<n;i++)
+	{
+		if(s->nbits>=p->max_bits||!IR_Manchester_Unit(p,s,mark))
+			return IR_Restart(p,s,mark,dur);
+	}
+
+	if(s->nbits>=p->max_bits)
+	{
+		s->state=IR_ST_IDLE;
+		return IR_STEP_FRAME;
+	}
+	// 最后一位的后半位若为间隔，会与帧后空闲合并，载波结束时即可判定完成
+	if(mark&&s->nbits==p->max_bits-1&&s->half==1&&s->units==0)
+	{
+		IR_Push_Bit(p,s,(p->flags&IR_FLAG_MARK_FIRST)?1:0);
+		s->state=IR_ST_IDLE;
+		return IR_STEP_FRAME;
+	}
+	return IR_STEP_NONE;
+}
+
+// ==================== 帧校验与字段提取 ====================
+// 返回值：1=校验通过，f中填入协议字段；0=校验失败
+static u8 IR_Check(const IR_Protocol *p,const IR_ProtoState *s,IR_Frame *f)
+{
+	u32 d=s->data;
+	u8 a,an,c,cn;
+
+	f->protocol=p->id;
+	f->bits=s->nbits;
+	f->raw=d;
+	f->repeat=0;
+	f->toggle=0;
+
+	switch(p->check)
+	{
+		case IR_CHECK_NEC:
+		case IR_CHECK_NECX:
+		case IR_CHECK_SAMSUNG:
+			// 数据格式：[地址码8位][地址反码8位][命令码8位][命令反码8位]
+			a=d>>24;
+			an=d>>16;
+			c=d>>8;
+			cn=d;
+			if(c!=(u8)~cn) return 0;                           // 命令码 = ~命令反码
+			f->command=c;
+			if(p->check==IR_CHECK_NEC)
+			{
+				if(a!=(u8)~an) return 0;                       // 地址码 = ~地址反码
+				f->address=a;
+			}
+			else if(p->check==IR_CHECK_NECX)
+			{
+				if(a==(u8)~an) return 0;                       // 标准NEC帧已由NEC处理
+				f->address=(u16)(d>>16);                       // 16位地址
+			}
+			else
+			{
+				if(a!=an) return 0;                            // Samsung：地址码重复两次
+				f->address=a;
+			}
+			return 1;
+
+		case IR_CHECK_RC5:
+			// 数据格式：[S1][S2][T][地址5位][命令6位]，S2取反作为命令第7位（RC5X）
+			if(!(d&0x2000)) return 0;
+			f->toggle=(d>>11)&1;
+			f->address=(d>>6)&0x1F;
+			f->command=(d&0x3F)|((d&0x1000)?0:0x40);
+			return 1;
+
+		case IR_CHECK_RC6:
+			// 数据格式：[起始位][模式3位][尾标位T][地址8位][命令8位]
+			if(!(d&0x100000)||((d>>17)&0x07)!=0) return 0;
+			f->toggle=(d>>16)&1;
+			f->address=(d>>8)&0xFF;
+			f->command=d&0xFF;
+			return 1;
+
+		case IR_CHECK_SIRC:
+			// 数据格式（低位先发）：[命令7位][地址5/8/13位]
+			if(s->nbits!=12&&s->nbits!=15&&s->nbits!=20) return 0;
+			f->command=d&0x7F;
+			f->address=(u16)(d>>7);
+			return 1;
+	}
+	return 0;
+}
+
+// ==================== 解码器接口 ====================
+
+// 解码器初始化：使能全部协议
+void IR_Decoder_Init(IR_Decoder *dec)
+{
+	u8 i;
+
+	dec->enable=IR_PROTO_ALL;
+	dec->since_us=0xFFFFFFFF;
+	dec->has_last=0;
+	memset(&dec->stats,0,sizeof(dec->stats));
+	for(i=0;i<IR_PROTO_COUNT;i++)
+	{
+		dec->st[i].cal_scale=IR_SCALE_ONE;   // 学习值从标称时序开始
+		dec->st[i].cal_bias=0;
+	}
+	IR_Decoder_Reset(dec);
+}
+
+// 复位所有协议状态机（不清除上一帧记录）
+// 调用：线路失步（缓冲区溢出等）时
+void IR_Decoder_Reset(IR_Decoder *dec)
+{
+	u8 i;
+
+	for(i=0;i<IR_PROTO_COUNT;i++) dec->st[i].state=IR_ST_IDLE;
+	dec->gap=1;
+}
+
+// 设置协议使能掩码，例如 IR_PROTO_MASK(IR_PROTO_NEC)|IR_PROTO_MASK(IR_PROTO_RC5)
+void IR_Decoder_Enable(IR_Decoder *dec,u32 mask)
+{
+	dec->enable=mask;
+	IR_Decoder_Reset(dec);
+}
+
+// 送入一个电平段
+// 参数：mark - 1=载波（接收头输出低电平），0=间隔（接收头输出高电平）
+//      dur  - 持续时间（us），线路空闲时可传入实际空闲时长或IR_DUR_IDLE
+//      out  - 解码完成时写入帧数据
+// 返回值：1=解码出一帧（含重复帧），0=无
+u8 IR_Decoder_Feed(IR_Decoder *dec,u8 mark,u32 dur,IR_Frame *out)
+{
+	const IR_Protocol *p;
+	IR_ProtoState *s;
+	u8 i,r,prev,done=0;
+	u8 leader=0,bad_check=0,aborted=0,alive=0;   // 本电平段的统计标志
+
+	if(dec->since_us+dur<dec->since_us) dec->since_us=0xFFFFFFFF;  // 饱和累加
+	else dec->since_us+=dur;
+
+	for(i=0;i<IR_PROTO_COUNT&&!done;i++)
+	{
+		p=&ir_protocols[i];
+		s=&dec->st[i];
+		if(!(dec->enable&IR_PROTO_MASK(p->id))) continue;
+
+		prev=s->state;
+		if(p->coding==IR_CODING_PULSE_DISTANCE) r=IR_Feed_PulseDistance(p,s,mark,dur);
+		else if(p->coding==IR_CODING_PULSE_WIDTH) r=IR_Feed_PulseWidth(p,s,mark,dur);
+		else r=IR_Feed_Manchester(p,s,mark,dur,dec->gap);
+		
+		// 统计：引导码载波只能由复位进入（IDLE/HDR_SPACE），中途复位说明该电平段不在时序窗口内
+		//      引导码间隔也匹配后才计为一个引导码，避免数据位载波偶然落入其他协议的引导码窗口
+		if(prev!=IR_ST_IDLE&&r==IR_STEP_NONE)
+		{
+			if(s->state==IR_ST_IDLE||s->state==IR_ST_HDR_SPACE) aborted=1;
+			else
+			{
+				alive=1;
+				if(prev==IR_ST_HDR_SPACE) leader=1;
+			}
+		}
+
+		if(r==IR_STEP_FRAME&&IR_Check(p,s,out))
+		{
+			// 同一按键在重复窗口内再次到达（同码连发或RC5/RC6翻转位未变）视为重复帧
+			if(dec->has_last&&dec->since_us<=IR_REPEAT_WINDOW_US&&dec->last.protocol==out->protocol&&
+			   dec->last.address==out->address&&dec->last.command==out->command&&dec->last.toggle==out->toggle)
+				out->repeat=1;
+			dec->last=*out;
+			dec->has_last=1;
+			done=1;
+		}
+		else if(r==IR_STEP_FRAME) bad_check=1;
+		else if(r==IR_STEP_REPEAT&&dec->has_last&&dec->since_us<=IR_REPEAT_WINDOW_US&&
+		        (dec->last.protocol==IR_PROTO_NEC||dec->last.protocol==IR_PROTO_NECX))
+		{
+			*out=dec->last;   // NEC重复码不携带数据，沿用上一帧
+			out->repeat=1;
+			done=1;
+		}
+	}
+
+	if(leader) dec->stats.leaders++;
+	if(done)
+	{
+		if(out->repeat) dec->stats.repeats++;
+		else dec->stats.frames++;
+		out->jitter=s->nerr?(u16)(s->err_sum/s->nerr):0;
+		// 学习：胜出协议本帧的时序参数累积到学习值（各占一半，两三帧即可跟上新遥控器）
+		s->cal_scale=(u16)(s->cal_scale+((s32)s->scale-s->cal_scale)/2);
+		s->cal_bias=(s16)(s->cal_bias+(s->bias-s->cal_bias)/2);
+		IR_Decoder_Reset(dec);   // 胜出后其他协议的部分结果作废
+		dec->since_us=0;
+	}
+	else if(bad_check) dec->stats.check_fail++;
+	else if(aborted&&!alive) dec->stats.bad_pulse++;
+	dec->gap=(!mark&&dur>=IR_GAP_US);
+	return done;
+}
+
+// 线路空闲期间经过的时间：只累加"距上一帧"计时，不改变各协议状态机
+// 调用：空闲超时时已用IR_Decoder_Feed()送入了部分空闲间隔，下一个边沿到来时补上剩余部分，
+//      使重复码/重复帧的时间窗判断不受空闲检测时刻影响
+void IR_Decoder_Elapse(IR_Decoder *dec,u32 us)
+{
+	if(dec->since_us+us<dec->since_us) dec->since_us=0xFFFFFFFF;  // 饱和累加
+	else dec->since_us+=us;
+}
+
+// 是否有协议正在接收帧（用于区分帧间空闲和帧中途超时）
+u8 IR_Decoder_Busy(const IR_Decoder *dec)
+{
+	u8 i;
+
+	for(i=0;i<IR_PROTO_COUNT;i++)
+		if((dec->enable&IR_PROTO_MASK(ir_protocols[i].id))&&dec->st[i].state!=IR_ST_IDLE) return 1;
+	return 0;
+}
+
+// ==================== 帧编码（发射用） ====================
+// 与解码使用同一张协议时序表，编码结果按标称时序，解码器按表中的窗口一定能解出
+
+// 编码输出：相邻同电平合并，帧从载波开始
+typedef struct
+{
+	u16 *seg;           // 电平段宽度（us），偶数下标为载波
+	u16 max;            // seg容量
+	u16 n;              // 已输出段数
+	u8  full;           // 1=超出容量
+} IR_Enc;
+
+static void IR_Enc_Put(IR_Enc *e,u8 mark,u32 us)
+{
+	if(!e->n&&!mark) return;                        // 开头的间隔并入帧前空闲（RC5起始位）
+	if(e->n&&((e->n-1)&1)==!mark)                  // 与上一段同电平：合并
+	{
+		e->seg[e->n-1]+=us;
+		return;
+	}
+	if(e->n>=e->max)
+	{
+		e->full=1;
+		return;
+	}
+	e->seg[e->n++]=(u16)us;
+}
+
+// 把地址和命令编码为电平段序列（IR_Check的逆过程）
+// 参数：protocol - 协议编号（协议表中的协议）
+//      address/command - 与解码结果IR_Frame的字段含义相同
+//      toggle  - RC5/RC6翻转位（新按键取反，重复帧不变）
+//      repeat  - 1=重复帧：有独立重复码的协议（NEC/扩展NEC）输出重复码，其他协议输出同一帧
+//      seg     - 输出的电平段宽度（us），从载波开始载波/间隔交替，不含帧后间隔
+//      max     - seg容量
+// 返回值：电平段个数，0=协议不支持或容量不足
+u16 IR_Encode(u8 protocol,u16 address,u16 command,u8 toggle,u8 repeat,u16 *seg,u16 max)
+{
+	const IR_Protocol *p=0;
+	IR_Enc e;
+	u32 d,b;
+	u8 i,n,w,first;
+
+	for(i=0;i<IR_PROTO_COUNT;i++)
+		if(ir_protocols[i].id==protocol) p=&ir_protocols[i];
+	if(!p) return 0;
+
+	e.seg=seg;
+	e.max=max;
+	e.n=0;
+	e.full=0;
+	n=p->max_bits;
+	switch(p->check)
+	{
+		case IR_CHECK_NEC:
+			d=((u32)(u8)address<<24)|((u32)(u8)~address<<16);
+			break;
+		case IR_CHECK_NECX:
+			d=(u32)address<<16;
+			break;
+		case IR_CHECK_SAMSUNG:
+			d=((u32)(u8)address<<24)|((u32)(u8)address<<16);
+			break;
+		case IR_CHECK_RC5:
+			d=(1UL<<13)|((command&0x40)?0:(1UL<<12))|((u32)(toggle&1)<<11)|((u32)(address&0x1F)<<6)|(command&0x3F);
+			break;
+		case IR_CHECK_RC6:
+			d=(1UL<<20)|((u32)(toggle&1)<<16)|((u32)(address&0xFF)<<8)|(command&0xFF);
+			break;
+		default:    // SIRC：地址宽度决定位数（5/8/13位地址 = 12/15/20位）
+			n=(address<0x20)?12:((address<0x100)?15:20);
+			d=(command&0x7F)|((u32)(address&0x1FFF)<<7);
+			break;
+	}
+	if(p->check<=IR_CHECK_SAMSUNG) d|=((u32)(u8)command<<8)|(u8)~command;
+
+	if(repeat&&p->rpt_space)                        // NEC重复码：引导载波 + 重复间隔 + 结束载波
+	{
+		IR_Enc_Put(&e,1,p->hdr_mark);
+		IR_Enc_Put(&e,0,p->rpt_space);
+		IR_Enc_Put(&e,1,p->zero_mark);
+		return e.full?0:e.n;
+	}
+
+	if(p->hdr_mark)
+	{
+		IR_Enc_Put(&e,1,p->hdr_mark);
+		IR_Enc_Put(&e,0,p->hdr_space);
+	}
+	for(i=0;i<n;i++)
+	{
+		b=(p->flags&IR_FLAG_LSB_FIRST)?(d>>i)&1:(d>>(n-1-i))&1;
+		if(p->coding==IR_CODING_PULSE_DISTANCE)
+		{
+			IR_Enc_Put(&e,1,b?p->one_mark:p->zero_mark);
+			IR_Enc_Put(&e,0,b?p->one_space:p->zero_space);
+		}
+		else if(p->coding==IR_CODING_PULSE_WIDTH)
+		{
+			if(i) IR_Enc_Put(&e,0,b?p->one_space:p->zero_space);   // 第一位的间隔是引导间隔
+			IR_Enc_Put(&e,1,b?p->one_mark:p->zero_mark);
+		}
+		else
+		{
+			w=(i==p->trailer_bit)?2:1;
+			first=(p->flags&IR_FLAG_MARK_FIRST)?(u8)b:(u8)!b;
+			IR_Enc_Put(&e,first,(u32)w*p->zero_mark);
+			IR_Enc_Put(&e,!first,(u32)w*p->zero_mark);
+		}
+	}
+	if(p->coding==IR_CODING_PULSE_DISTANCE) IR_Enc_Put(&e,1,p->zero_mark);   // 结束载波
+	if(e.n&&!(e.n&1)) e.n--;                        // 结尾的间隔并入帧后间隔
+	return e.full?0:e.n;
+}
+
+// 获取协议名称
+const char *IR_Proto_Name(u8 id)
+{
+	u8 i;
+
+	for(i=0;i<IR_PROTO_COUNT;i++)
+		if(ir_protocols[i].id==id) return ir_protocols[i].name;
+	if(id==IR_PROTO_LEARNED) return "LEARNED";
+	return "NONE";
+}
@@ -0,0 +1,147 @@
+#ifndef __IR_DECODE_H
+#define __IR_DECODE_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 多协议红外解码引擎头文件
+// 功能说明：表驱动的红外协议解码器，支持NEC、扩展NEC、RC5、RC6、Sony SIRC、Samsung
+// 设计思路：每种协议用一个常量时序描述符 + 一个小状态机表示
+//          所有协议并行接收同一个"电平+持续时间"序列，最先完成的协议胜出
+//          每个边沿对每个协议的处理量固定，解码开销有上界
+// 依赖说明：本模块不访问任何硬件寄存器，只依赖sys.h中的基本类型
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 协议编号 ====================
+#define IR_PROTO_NONE       0
+#define IR_PROTO_NEC        1   // 标准NEC（8位地址+地址反码）
+#define IR_PROTO_NECX       2   // 扩展NEC（16位地址）
+#define IR_PROTO_RC5        3   // Philips RC5（含RC5X扩展命令位）
+#define IR_PROTO_RC6        4   // Philips RC6 模式0
+#define IR_PROTO_SIRC       5   // Sony SIRC（12/15/20位）
+#define IR_PROTO_SAMSUNG    6   // Samsung 32位
+#define IR_PROTO_COUNT      6   // 协议表中的协议个数
+#define IR_PROTO_LEARNED    7   // 学习的原始波形（不在协议表中，由ir_learn.c的信号库匹配）
+
+#define IR_PROTO_MASK(id)   (1UL<<(id))               // 协议使能掩码
+#define IR_PROTO_ALL        0xFFFFFFFFUL              // 使能全部协议
+
+// ==================== 编码方式 ====================
+#define IR_CODING_PULSE_DISTANCE  0   // 间隔宽度编码：载波宽度固定，间隔宽度区分0/1（NEC/Samsung）
+#define IR_CODING_PULSE_WIDTH     1   // 脉冲宽度编码：载波宽度区分0/1（Sony SIRC）
+#define IR_CODING_MANCHESTER      2   // 双相编码：每位中间跳变（RC5/RC6）
+
+// ==================== 帧校验方式 ====================
+#define IR_CHECK_NEC        0   // 地址=~地址反码 且 命令=~命令反码
+#define IR_CHECK_NECX       1   // 命令=~命令反码，地址为16位
+#define IR_CHECK_SAMSUNG    2   // 地址重复两次 且 命令=~命令反码
+#define IR_CHECK_RC5        3   // 起始位S1=1
+#define IR_CHECK_RC6        4   // 起始位=1 且 模式=0
+#define IR_CHECK_SIRC       5   // 位数为12/15/20
+
+// ==================== 协议标志 ====================
+#define IR_FLAG_LSB_FIRST   0x01  // 数据低位先发（否则按接收顺序高位在前，与原驱动按键值一致）
+#define IR_FLAG_MARK_FIRST  0x02  // 曼彻斯特：先载波后间隔表示"1"（RC6），否则先间隔后载波表示"1"（RC5）
+
+#define IR_DUR_IDLE         0xFFFFFFFFUL  // 表示线路空闲的"无限长"间隔
+#define IR_REPEAT_WINDOW_US 200000UL      // 该时间内的同码帧/重复码认为是按住不放
+
+// 协议时序描述符（全部时间单位为us）
+typedef struct
+{
+    const char *name;   // 协议名称
+    u8  id;             // 协议编号（IR_PROTO_xxx）
+    u8  coding;         // 编码方式（IR_CODING_xxx）
+    u8  check;          // 帧校验方式（IR_CHECK_xxx）
+    u8  flags;          // 协议标志（IR_FLAG_xxx）
+    u16 hdr_mark;       // 引导码载波宽度（0=无引导码）
+    u16 hdr_space;      // 引导码间隔宽度
+    u16 rpt_space;      // 重复码间隔宽度（0=无独立重复码）
+    u16 zero_mark;      // 数据"0"载波宽度（曼彻斯特编码时为半位宽度T）
+    u16 zero_space;     // 数据"0"间隔宽度
+    u16 one_mark;       // 数据"1"载波宽度
+    u16 one_space;      // 数据"1"间隔宽度
+    u8  min_bits;       // 最少数据位数
+    u8  max_bits;       // 最多数据位数
+    u8  trailer_bit;    // 双倍宽度位的序号（RC6尾标位，0xFF=无）
+    u8  tolerance;      // 时间容差（百分比）
+} IR_Protocol;
+
+// ==================== 自适应时序 ====================
+// 遥控器晶振偏差使所有宽度按同一比例伸缩（scale），接收头在强光下会把载波拉长、间隔缩短
+// 同样的us数（bias）。每帧在引导码后锁定这两个参数，数据位相对锁定后的宽度分类，
+// 接收过程中按实测误差继续跟踪；解码成功的帧参数累积为该协议的学习值，用于下一帧
+#define IR_SCALE_ONE        1024    // scale的1.0（Q10定点）
+#define IR_SCALE_MIN        666     // 最小时钟比例0.65
+#define IR_SCALE_MAX        1382    // 最大时钟比例1.35
+#define IR_TRACK_SHIFT      4       // 接收过程中时钟比例只能在锁定值±1/16内跟踪
+#define IR_NOMINAL_SHIFT    5       // 锁定值与标称相差不超过1/32（展宽不超过载波1/8）时按标称窗口解码
+
+// 单个协议的解码状态
+typedef struct
+{
+    u8  state;          // 状态机状态
+    u8  nbits;          // 已接收数据位数
+    u8  half;           // 曼彻斯特：0=前半位，1=后半位
+    u8  units;          // 曼彻斯特：当前半位已收到的T单位数
+    u8  first;          // 曼彻斯特：前半位电平（1=载波）
+    u8  adapt;          // 本帧按锁定时序解码（0=锁定值接近标称，只用标称窗口）
+    u16 lead;           // 实测引导码载波宽度（us）
+    u16 lock;           // 本帧锁定的时钟比例（Q10，IR_SCALE_ONE=标称）
+    u16 scale;          // 当前跟踪的时钟比例（在lock附近）
+    s16 bias;           // 本帧锁定的载波展宽（us，载波加长、间隔缩短）
+    u16 cal_scale;      // 学习到的时钟比例（解码成功的帧累积，复位不清除）
+    s16 cal_bias;       // 学习到的载波展宽
+    u16 nerr;           // 本帧参与跟踪的电平段数
+    u32 err_sum;        // 本帧各电平段与期望宽度之差的绝对值累加（us）
+    u32 data;           // 已接收数据
+} IR_ProtoState;
+
+// 解码结果
+typedef struct
+{
+    u8  protocol;       // 协议编号（IR_PROTO_xxx）
+    u8  bits;           // 数据位数
+    u8  repeat;         // 1=重复帧（NEC重复码、RC5/RC6翻转位未变、同码连发）
+    u8  toggle;         // RC5/RC6翻转位
+    u16 address;        // 地址（NEC为8位，扩展NEC为16位）
+    u16 command;        // 命令
+    u32 raw;            // 原始数据
+    u16 jitter;         // 信号质量：数据位实测宽度与期望宽度的平均偏差（us，越小越好，重复码为0）
+} IR_Frame;
+
+// 解码统计（按电平段计数，多个协议同时响应同一电平段时只计一次）
+typedef struct
+{
+    u32 leaders;        // 识别到的引导码载波
+    u32 frames;         // 校验通过的完整帧（不含重复码）
+    u32 repeats;        // 重复码/重复帧
+    u32 check_fail;     // 位数收齐但校验失败（地址/命令反码不符等），且没有其他协议接受
+    u32 bad_pulse;      // 帧接收中途出现不在任何时序窗口内的电平段，接收中断（含空闲超时）
+} IR_Decoder_Stats;
+
+// 解码器实例（每个红外接收头一个）
+typedef struct
+{
+    IR_ProtoState st[IR_PROTO_COUNT]; // 各协议的状态机
+    u32 enable;                       // 协议使能掩码
+    u32 since_us;                     // 距上一帧完成的时间（用于判断重复）
+    u8  gap;                          // 1=上一个间隔足够长，可以开始无引导码的帧（RC5）
+    u8  has_last;                     // 1=last有效
+    IR_Frame last;                    // 上一帧（用于重复码和翻转位判断）
+    IR_Decoder_Stats stats;           // 解码统计
+} IR_Decoder;
+
+extern const IR_Protocol ir_protocols[IR_PROTO_COUNT];
+
+void IR_Decoder_Init(IR_Decoder *dec);
+void IR_Decoder_Reset(IR_Decoder *dec);
+void IR_Decoder_Enable(IR_Decoder *dec, u32 mask);
+u8 IR_Decoder_Feed(IR_Decoder *dec, u8 mark, u32 dur, IR_Frame *out);
+void IR_Decoder_Elapse(IR_Decoder *dec, u32 us);
+u8 IR_Decoder_Busy(const IR_Decoder *dec);
+u16 IR_Encode(u8 protocol, u16 address, u16 command, u8 toggle, u8 repeat, u16 *seg, u16 max);
+const char *IR_Proto_Name(u8 id);
+
+#endif
@@ -0,0 +1,396 @@
+#include "ir_learn.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 红外学习与信号库
+// 功能说明：原始波形的压缩（符号聚类+游程码）、比较、还原，以及Flash信号库的增删和匹配
+// 调用关系：remote.c在PendSV中对未解码的发射调用IR_Signal_Encode()和IR_Lib_Match()，
+//          IR_Lib_Add()/IR_Lib_Delete()/IR_Lib_Clear()写Flash，只能在主循环中调用
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 信号压缩 ====================
+// 宽度d与符号宽度ref相差不超过tol%
+static u8 IR_Learn_Near(u32 d,u32 ref,u32 tol,u32 *diff)
+{
+	*diff=(d>ref)?d-ref:ref-d;
+	return (*diff)*100<=ref*tol;
+}
+
+// 向码流追加一个4位码，码流已满返回0
+static u8 IR_Learn_Put(IR_Signal *sig,u8 c)
+{
+	if(sig->ncode>=IR_LEARN_CODE_LEN*2) return 0;
+	sig->code[sig->ncode>>1]|=(sig->ncode&1)?(c<<4):c;
+	sig->ncode++;
+	return 1;
+}
+
+// 取码流中的第i个4位码
+static u8 IR_Learn_Get(const IR_Signal *sig,u16 i)
+{
+	return (sig->code[i>>1]>>((i&1)*4))&0x0F;
+}
+
+// 散列：FNV-1a，覆盖电平段数、符号数和码流（不含符号宽度，宽度在匹配时按容差比较）
+static u16 IR_Learn_Hash(const IR_Signal *sig)
+{
+	u32 h=2166136261UL;
+	u8 i;
+	
+	h=(h^sig->nseg)*16777619UL;
+	h=(h^sig->nsym)*16777619UL;
+	for(i=0;i<(sig->ncode+1)/2;i++) h=(h^sig->code[i])*16777619UL;
+	return (u16)(h^(h>>16));
+}
+
+// 压缩一次发射
+// 参数：seg - 电平段宽度（us），从载波开始，载波/间隔交替；n - 电平段个数
+//      sig - 压缩结果（command为0，状态为IR_SIG_VALID）
+// 返回值：1=成功，0=电平段太少/太多、符号超过IR_LEARN_SYM_MAX个或码流溢出
+// 说明：每个电平段归入宽度最接近且在IR_LEARN_QUANT%内的符号，否则新建符号，符号宽度取归入电平段的平均值
+//      码流中前一对"载波+间隔"连续重复2次以上时写游程码，NEC的32个数据位约压缩为20~40个码
+u8 IR_Signal_Encode(const u16 *seg,u16 n,IR_Signal *sig)
+{
+	u32 sum[IR_LEARN_SYM_MAX],diff,best;
+	u16 cnt[IR_LEARN_SYM_MAX],mean[IR_LEARN_SYM_MAX];
+	u8 idx[IR_LEARN_MAX_SEG];
+	u16 i,r;
+	u8 s,k,nsym=0;
+	
+	if(n<IR_LEARN_MIN_SEG||n>IR_LEARN_MAX_SEG) return 0;
+	memset(sig,0,sizeof(IR_Signal));
+	
+	// 宽度聚类：按首次出现的顺序编号，同一遥控器的每次发射得到相同的符号序列
+	for(i=0;i<n;i++)
+	{
+		k=0xFF;
+		best=0xFFFFFFFFUL;
+		for(s=0;s<nsym;s++)
+			if(IR_Learn_Near(seg[i],mean[s],IR_LEARN_QUANT,&diff)&&diff<best)
+			{
+				best=diff;
+				k=s;
+			}
+		if(k==0xFF)
+		{
+			if(nsym>=IR_LEARN_SYM_MAX) return 0;
+			k=nsym++;
+			sum[k]=0;
+			cnt[k]=0;
+		}
+		sum[k]+=seg[i];
+		cnt[k]++;
+		mean[k]=(u16)(sum[k]/cnt[k]);
+		idx[i]=k;
+	}
+	
+	// 符号序列 + 游程码
+	for(i=0;i<n;)
+	{
+		r=0;
+		if(i>=2)
+			while(r<17&&i+2*r+1<n&&idx[i+2*r]==idx[i-2]&&idx[i+2*r+1]==idx[i-1]) r++;
+		if(r>=2)
+		{
+			if(!IR_Learn_Put(sig,IR_LEARN_RUN)||!IR_Learn_Put(sig,(u8)(r-2))) return 0;
+			i+=2*r;
+		}
+		else
+		{
+			if(!IR_Learn_Put(sig,idx[i])) return 0;
+			i++;
+		}
+	}
+	
+	for(s=0;s<nsym;s++) sig->sym[s]=mean[s];
+	sig->nsym=nsym;
+	sig->nseg=(u8)n;
+	sig->hash=IR_Learn_Hash(sig);
+	sig->state=IR_SIG_VALID;
+	return 1;
+}
+
+// 逐段比较一次发射与参考信号
+// 参数：ref    - 参考信号（信号库中的信号或第一次录制的信号）
+//      seg/n  - 收到的电平段
+//      jitter - 输出各电平段与参考符号宽度的平均偏差（us），可为0
+// 返回值：1=电平段数相同且每个电平段都在参考符号宽度的容差内（或相差不超过IR_LEARN_TOL_US）
+// 说明：按参考信号的符号表比较，不依赖收到的发射自己的聚类结果，抖动较大时仍能匹配
+u8 IR_Signal_Match(const IR_Signal *ref,const u16 *seg,u16 n,u16 *jitter)
+{
+	u32 diff,total=0;
+	u16 i,j=0;
+	u8 c,r,a=0,b=0;
+	
+	if(n!=ref->nseg) return 0;
+	for(i=0;i<ref->ncode;i++)
+	{
+		c=IR_Learn_Get(ref,i);
+		if(c==IR_LEARN_RUN)
+		{
+			r=IR_Learn_Get(ref,++i)+2;
+			while(r--)
+			{
+				if(j+2>n) return 0;
+				if(!IR_Learn_Near(seg[j],ref->sym[a],IR_LEARN_TOL,&diff)&&diff>IR_LEARN_TOL_US) return 0;
+				total+=diff;
+				if(!IR_Learn_Near(seg[j+1],ref->sym[b],IR_LEARN_TOL,&diff)&&diff>IR_LEARN_TOL_US) return 0;
+				total+=diff;
+				j+=2;
+			}
+		}
+		else
+		{
+			if(j>=n||c>=ref->nsym) return 0;
+			if(!IR_Learn_Near(seg[j],ref->sym[c],IR_LEARN_TOL,&diff)&&diff>IR_LEARN_TOL_US) return 0;
+			total+=diff;
+			a=b;                        // 最近两个符号，游程码重复的就是这一对
+			b=c;
+			j++;
+		}
+	}
+	if(j!=n) return 0;
+	if(jitter) *jitter=(u16)(total/n);
+	return 1;
+}
+
+// 还原电平段序列（用于重新发射或调试输出）
+// 参数：seg - 输出缓冲区，max - 缓冲区长度
+// 返回值：电平段个数（缓冲区不足时截断）
+u16 IR_Signal_Decode(const IR_Signal *sig,u16 *seg,u16 max)
+{
+	u16 i,n=0;
+	u8 c,r;
+	
+	for(i=0;i<sig->ncode&&n<max;i++)
+	{
+		c=IR_Learn_Get(sig,i);
+		if(c==IR_LEARN_RUN&&i+1<sig->ncode&&n>=2)
+		{
+			r=IR_Learn_Get(sig,++i)+2;
+			while(r--&&n+1<max)
+			{
+				seg[n]=seg[n-2];
+				seg[n+1]=seg[n-1];
+				n+=2;
+			}
+		}
+		else seg[n++]=sig->sym[c%IR_LEARN_SYM_MAX];
+	}
+	return n;
+}
+
+// ==================== 信号库 ====================
+// RAM中的信号库和散列索引在PendSV中读取，修改时关中断；Flash写入在关中断之外进行
+#define IR_LIB_REC_SIZE     sizeof(IR_Signal)
+#define IR_LIB_REC_MAX      (IR_LIB_FLASH_SIZE/IR_LIB_REC_SIZE)
+#define IR_LIB_REC_ADDR(r)  (IR_LIB_FLASH_ADDR+(u32)(r)*IR_LIB_REC_SIZE)
+
+static IR_Signal ir_lib[IR_LIB_SIZE];       // 信号库（state==IR_SIG_VALID为有效）
+static u16 ir_lib_rec[IR_LIB_SIZE];         // 各信号在Flash中的记录号
+static u8  ir_lib_hidx[IR_LIB_HASH_LEN];    // 散列索引：信号下标+1，0=空
+static u16 ir_lib_next=0;                   // Flash中下一个空记录号
+
+// 重建散列索引（开放寻址，线性探测）
+static void IR_Lib_Index(void)
+{
+	u8 k,i;
+	
+	memset(ir_lib_hidx,0,sizeof(ir_lib_hidx));
+	for(k=0;k<IR_LIB_SIZE;k++)
+	{
+		if(ir_lib[k].state!=IR_SIG_VALID) continue;
+		i=ir_lib[k].hash&(IR_LIB_HASH_LEN-1);
+		while(ir_lib_hidx[i]) i=(i+1)&(IR_LIB_HASH_LEN-1);
+		ir_lib_hidx[i]=k+1;
+	}
+}
+
+// Flash记录是否为擦除状态
+static u8 IR_Lib_Blank(u16 rec)
+{
+	const u32 *p=(const u32 *)IR_LIB_MEM(IR_LIB_REC_ADDR(rec));
+	u8 i;
+	
+	for(i=0;i<IR_LIB_REC_SIZE/4;i++)
+		if(p[i]!=0xFFFFFFFFUL) return 0;
+	return 1;
+}
+
+// 写入一条Flash记录：先写除状态字以外的内容，最后写状态字
+// 中途掉电的记录状态仍为IR_SIG_EMPTY，加载时跳过
+static u8 IR_Lib_Write(u16 rec,const IR_Signal *sig)
+{
+	u32 addr=IR_LIB_REC_ADDR(rec),w;
+	u8 i,ok=1;
+	
+	HAL_FLASH_Unlock();
+	for(i=0;i<IR_LIB_REC_SIZE/4&&ok;i++)
+	{
+		if(i==1) continue;
+		memcpy(&w,(const u8 *)sig+i*4,4);
+		ok=(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,addr+i*4,w)==HAL_OK);
+	}
+	memcpy(&w,(const u8 *)sig+4,4);
+	if(ok) ok=(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD,addr+4,w)==HAL_OK);
+	HAL_FLASH_Lock();
+	return ok;
+}
+
+// 擦除信号库所在扇区（128KB扇区约需1~2s，期间CPU停止取指，红外接收中断会被推迟）
+static u8 IR_Lib_Erase(void)
+{
+	FLASH_EraseInitTypeDef erase;
+	u32 err=0;
+	u8 ok;
+	
+	erase.TypeErase=FLASH_TYPEERASE_SECTORS;
+	erase.Sector=IR_LIB_FLASH_SECTOR;
+	erase.NbSectors=1;
+	erase.VoltageRange=FLASH_VOLTAGE_RANGE_3;
+	HAL_FLASH_Unlock();
+	ok=(HAL_FLASHEx_Erase(&erase,&err)==HAL_OK);
+	HAL_FLASH_Lock();
+	return ok;
+}
+
+// 扇区写满：擦除后按顺序重写全部有效信号
+static u8 IR_Lib_Compact(void)
+{
+	u8 k;
+	
+	if(!IR_Lib_Erase()) return 0;
+	ir_lib_next=0;
+	for(k=0;k<IR_LIB_SIZE;k++)
+	{
+		if(ir_lib[k].state!=IR_SIG_VALID) continue;
+		if(!IR_Lib_Write(ir_lib_next,&ir_lib[k])) return 0;
+		ir_lib_rec[k]=ir_lib_next++;
+	}
+	return 1;
+}
+
+// 从Flash加载信号库（上电时由Remote_Init()调用）
+void IR_Lib_Init(void)
+{
+	const IR_Signal *p;
+	u16 rec;
+	u8 n=0;
+	
+	__disable_irq();
+	memset(ir_lib,0,sizeof(ir_lib));
+	for(rec=0;rec<IR_LIB_REC_MAX;rec++)
+	{
+		p=(const IR_Signal *)IR_LIB_MEM(IR_LIB_REC_ADDR(rec));
+		if(p->state==IR_SIG_EMPTY&&IR_Lib_Blank(rec)) break;   // 第一个空记录
+		if(p->state!=IR_SIG_VALID||n>=IR_LIB_SIZE) continue;
+		ir_lib[n]=*p;
+		ir_lib_rec[n++]=rec;
+	}
+	ir_lib_next=rec;
+	IR_Lib_Index();
+	__enable_irq();
+}
+
+// 查找信号
+// 参数：sig    - 收到的发射经IR_Signal_Encode()得到的信号
+//      seg/n  - 收到的电平段
+//      jitter - 输出电平段宽度的平均偏差（us），可为0
+// 返回值：信号库下标，-1=没有匹配的信号
+// 说明：先逐段比较散列相同的信号（信号库装填率不超过1/2，平均探测不到2次）；
+//      宽度相近的两个符号（如Kaseikyo的1296/1728us间隔）在抖动下可能聚类不同而散列不同，
+//      此时再逐段比较电平段数相同的信号
+s8 IR_Lib_Match(const IR_Signal *sig,const u16 *seg,u16 n,u16 *jitter)
+{
+	u8 i=sig->hash&(IR_LIB_HASH_LEN-1),k;
+	
+	while(ir_lib_hidx[i])
+	{
+		k=ir_lib_hidx[i]-1;
+		if(ir_lib[k].hash==sig->hash&&IR_Signal_Match(&ir_lib[k],seg,n,jitter)) return (s8)k;
+		i=(i+1)&(IR_LIB_HASH_LEN-1);
+	}
+	for(k=0;k<IR_LIB_SIZE;k++)
+		if(ir_lib[k].state==IR_SIG_VALID&&ir_lib[k].nseg==n&&ir_lib[k].hash!=sig->hash&&
+		   IR_Signal_Match(&ir_lib[k],seg,n,jitter)) return (s8)k;
+	return -1;
+}
+
+// 加入信号并绑定命令
+// 返回值：信号库下标，-1=信号库已满或Flash写入失败
+// 说明：信号库中已有同样的信号时改为绑定新命令（旧记录标记为删除）
+s8 IR_Lib_Add(const IR_Signal *sig,u16 command)
+{
+	IR_Signal rec;
+	u16 seg[IR_LEARN_MAX_SEG];
+	s8 k;
+	
+	k=IR_Lib_Match(sig,seg,IR_Signal_Decode(sig,seg,IR_LEARN_MAX_SEG),0);
+	if(k>=0)
+	{
+		if(ir_lib[k].command==command) return k;
+		IR_Lib_Delete((u8)k);
+	}
+	for(k=0;k<IR_LIB_SIZE;k++)
+		if(ir_lib[k].state!=IR_SIG_VALID) break;
+	if(k>=IR_LIB_SIZE) return -1;
+	if(ir_lib_next>=IR_LIB_REC_MAX&&!IR_Lib_Compact()) return -1;
+	
+	rec=*sig;
+	rec.command=command;
+	rec.state=IR_SIG_VALID;
+	rec.reserved=0xFFFF;
+	if(!IR_Lib_Write(ir_lib_next,&rec)) return -1;
+	
+	__disable_irq();
+	ir_lib[k]=rec;
+	ir_lib_rec[k]=ir_lib_next++;
+	IR_Lib_Index();
+	__enable_irq();
+	return k;
+}
+
+// 删除信号（Flash记录的状态字节写为IR_SIG_DELETED）
+// 返回值：1=成功，0=下标无效
+u8 IR_Lib_Delete(u8 idx)
+{
+	if(idx>=IR_LIB_SIZE||ir_lib[idx].state!=IR_SIG_VALID) return 0;
+	__disable_irq();
+	ir_lib[idx].state=IR_SIG_DELETED;
+	IR_Lib_Index();
+	__enable_irq();
+	HAL_FLASH_Unlock();
+	HAL_FLASH_Program(FLASH_TYPEPROGRAM_BYTE,IR_LIB_REC_ADDR(ir_lib_rec[idx])+7,IR_SIG_DELETED);
+	HAL_FLASH_Lock();
+	return 1;
+}
+
+// 清空信号库（擦除扇区）
+u8 IR_Lib_Clear(void)
+{
+	__disable_irq();
+	memset(ir_lib,0,sizeof(ir_lib));
+	IR_Lib_Index();
+	__enable_irq();
+	ir_lib_next=0;
+	return IR_Lib_Erase();
+}
+
+// 信号库中的信号个数
+u8 IR_Lib_Count(void)
+{
+	u8 k,n=0;
+	
+	for(k=0;k<IR_LIB_SIZE;k++)
+		if(ir_lib[k].state==IR_SIG_VALID) n++;
+	return n;
+}
+
+// 取信号（用于显示或重新发射），下标无效返回0
+const IR_Signal *IR_Lib_Get(u8 idx)
+{
+	if(idx>=IR_LIB_SIZE||ir_lib[idx].state!=IR_SIG_VALID) return 0;
+	return &ir_lib[idx];
+}
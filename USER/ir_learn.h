@@ -0,0 +1,82 @@
+#ifndef __IR_LEARN_H
+#define __IR_LEARN_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 红外学习与信号库头文件
+// 功能说明：把协议表之外的遥控器发射的原始"载波/间隔"序列压缩为信号，保存在Flash信号库中，
+//          之后收到同样的发射时匹配出绑定的命令
+// 压缩方式：各电平段宽度按±IR_LEARN_QUANT%聚类为每个信号自己的符号表（最多15个符号），
+//          序列用4位符号码表示，重复的"载波+间隔"对用游程码表示
+// 匹配方式：符号序列的16位散列查信号库的散列索引，再按信号库中信号的符号表逐段比较宽度
+// 依赖说明：压缩和匹配不访问硬件；信号库用HAL_FLASH写入片内Flash（IR_LIB_FLASH_ADDR所在扇区）
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 录制与压缩参数 ====================
+// IR_LEARN_MAX_SEG： 一次发射最多记录的电平段（NEC为67个，Panasonic 48位约100个）
+// IR_LEARN_MIN_SEG： 少于此数的发射视为噪声或重复码，不学习也不匹配
+// IR_LEARN_GAP_US：  超过此长度的间隔结束一次发射
+// IR_LEARN_QUANT：   聚类容差（%），须小于相近符号宽度比的一半（Kaseikyo的1296/1728us相差33%）
+// IR_LEARN_TOL：     匹配容差（%），电平段与参考信号的符号宽度比较，另有IR_LEARN_TOL_US的绝对容差
+// IR_LEARN_SYM_MAX： 每个信号的符号个数上限（符号码0~14，15为游程码）
+// IR_LEARN_CODE_LEN：压缩码流长度（字节，每字节2个码）
+#define IR_LEARN_MAX_SEG    200
+#define IR_LEARN_MIN_SEG    8
+#define IR_LEARN_GAP_US     10000UL
+#define IR_LEARN_QUANT      12
+#define IR_LEARN_TOL        25
+#define IR_LEARN_TOL_US     100     // 匹配时短电平段的绝对容差（接收头对短载波的展宽可达100us）
+#define IR_LEARN_SYM_MAX    15
+#define IR_LEARN_CODE_LEN   96
+#define IR_LEARN_RUN        0x0F    // 游程码：下一个码n表示前一个"载波+间隔"对再重复n+2次
+
+// ==================== 信号库参数 ====================
+// 信号库在RAM中保留一份（匹配只读RAM），Flash中按记录追加，删除时把记录标记为无效，
+// 扇区写满后擦除并重写全部有效信号
+// 默认使用扇区5（0x08020000，128KB，STM32F411RC的最后一个扇区），固件只能使用扇区0~4（128KB），
+// LCD.uvprojx中IROM大小相应设为0x20000，链接器不会把代码放进信号库扇区
+#ifndef IR_LIB_FLASH_ADDR
+#define IR_LIB_FLASH_ADDR   0x08020000UL
+#define IR_LIB_FLASH_SECTOR FLASH_SECTOR_5
+#define IR_LIB_FLASH_SIZE   0x20000UL
+#endif
+#ifndef IR_LIB_MEM
+#define IR_LIB_MEM(addr)    ((const void *)(addr))  // 片内Flash按地址直接读取
+#endif
+#define IR_LIB_SIZE         32      // 信号库容量
+#define IR_LIB_HASH_LEN     64      // 散列索引长度（2的幂，不小于2*IR_LIB_SIZE）
+
+#define IR_SIG_EMPTY        0xFF    // Flash记录状态：未写入（擦除值）
+#define IR_SIG_VALID        0x5A    // 有效
+#define IR_SIG_DELETED      0x00    // 已删除
+
+// 压缩后的信号（同时是Flash记录格式，长度为4的倍数）
+typedef struct
+{
+    u16 hash;                       // 符号序列的散列（用于快速匹配）
+    u16 command;                    // 绑定的命令（与按键值相同，匹配后作为事件的command）
+    u8  nsym;                       // 符号个数
+    u8  nseg;                       // 电平段个数（从载波开始，载波/间隔交替）
+    u8  ncode;                      // 码流中4位码的个数
+    u8  state;                      // 记录状态（IR_SIG_xxx），最后写入
+    u16 sym[IR_LEARN_SYM_MAX];      // 各符号的宽度（us，聚类的平均值）
+    u16 reserved;
+    u8  code[IR_LEARN_CODE_LEN];    // 码流，先低4位后高4位
+} IR_Signal;
+
+// ==================== 函数声明 ====================
+u8 IR_Signal_Encode(const u16 *seg, u16 n, IR_Signal *sig);
+u8 IR_Signal_Match(const IR_Signal *ref, const u16 *seg, u16 n, u16 *jitter);
+u16 IR_Signal_Decode(const IR_Signal *sig, u16 *seg, u16 max);
+
+void IR_Lib_Init(void);
+s8 IR_Lib_Add(const IR_Signal *sig, u16 command);
+u8 IR_Lib_Delete(u8 idx);
+u8 IR_Lib_Clear(void);
+u8 IR_Lib_Count(void);
+const IR_Signal *IR_Lib_Get(u8 idx);
+s8 IR_Lib_Match(const IR_Signal *sig, const u16 *seg, u16 n, u16 *jitter);
+
+#endif
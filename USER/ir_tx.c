@@ -0,0 +1,300 @@
+#include "ir_tx.h"
+#include "ir_learn.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 红外发射模块
+// 功能说明：按协议表编码（IR_Encode）或还原学习信号（IR_Signal_Decode），生成包络表，
+//          由TIM1+DMA输出带38kHz载波的红外帧
+// 硬件接口：PA8（TIM1_CH1）驱动红外发射管，高电平发光
+//          TIM1更新事件触发DMA2_Stream5（通道6）突发传输，写TIM1_RCR和TIM1_CCR1
+// 时序说明：一帧开始时前两项由CPU写入（第一项经UG装入影子寄存器，第二项进预装载寄存器），
+//          之后每次更新事件DMA写入再下一项；最后一项为结束项（间隔），DMA传输完成后
+//          打开更新中断，帧后间隔结束时停止计数器并开始队列中的下一帧
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+TIM_HandleTypeDef TIM1_Handler;         // 定时器1句柄（载波与包络）
+static DMA_HandleTypeDef ir_tx_dma;     // TIM1_UP DMA（DMA2_Stream5通道6）
+
+static IR_Tx_Env ir_tx_env[IR_TX_ENV_LEN];  // 当前帧的包络表
+static u16 ir_tx_seg[IR_TX_SEG_MAX];        // 当前帧的电平段（us）
+
+// ==================== 发送队列 ====================
+// 主循环只写ir_tx_head，中断只写ir_tx_tail，与按键事件队列相同
+static IR_Tx_Job ir_tx_queue[IR_TX_QUEUE_LEN];
+static vu8 ir_tx_head=0;                // 写位置（仅IR_Tx_Send()修改）
+static vu8 ir_tx_tail=0;                // 读位置（仅IR_Tx_Next()修改）
+
+static IR_Tx_Job ir_tx_job;             // 正在发送的任务
+static u8  ir_tx_left=0;                // 当前任务还要发送的帧数
+static u8  ir_tx_rpt=0;                 // 当前任务已发送的帧数（>0时发重复帧）
+static u8  ir_tx_toggle=0;              // RC5/RC6翻转位，每个任务取反
+static vu8 ir_tx_active=0;              // 1=TIM1正在输出一帧
+static IR_Tx_Stats ir_tx_stats;
+
+// 各协议的帧周期（us，从一帧开始到下一帧开始）
+static u32 IR_Tx_Period(u8 protocol)
+{
+	switch(protocol)
+	{
+		case IR_PROTO_SIRC: return 45000;
+		case IR_PROTO_RC5:  return 113778;
+		case IR_PROTO_RC6:  return 107000;
+		default:            return 108000;   // NEC/扩展NEC/Samsung
+	}
+}
+
+// ==================== 包络表生成 ====================
+// 功能：把电平段换算为载波周期数，填入包络表
+// 参数：n      - 电平段个数（ir_tx_seg[]，从载波开始）
+//      period - 帧周期（us），帧后间隔补足到帧周期，且不短于IR_TX_GAP_US
+// 返回值：包络表项数（含结束项），0=包络表容量不足
+// 说明：按各段结束时刻的累计时间取整到载波周期，取整误差不会逐段累积
+static u16 IR_Tx_Envelope(u16 n,u32 period)
+{
+	u32 t=0,c=0,c1,k;
+	u16 m=0,i,ccr;
+
+	for(i=0;i<=n;i++)
+	{
+		if(i<n)
+		{
+			t+=ir_tx_seg[i];
+			ccr=(i&1)?0:IR_TX_CCR;
+		}
+		else
+		{
+			t=(period>t+IR_TX_GAP_US)?period:t+IR_TX_GAP_US;   // 帧后间隔
+			ccr=0;
+		}
+		c1=(t*(IR_TX_CARRIER_HZ/1000)+500)/1000;  // 本段结束时刻对应的载波周期数
+		k=c1-c;
+		c=c1;
+		while(k)
+		{
+			if(m>=IR_TX_ENV_LEN-1) return 0;
+			ir_tx_env[m].rcr=(u16)((k>IR_TX_RCR_MAX?IR_TX_RCR_MAX:k)-1);
+			ir_tx_env[m].ccr=ccr;
+			k-=ir_tx_env[m].rcr+1;
+			m++;
+		}
+	}
+	ir_tx_env[m].rcr=0;                 // 结束项：帧后间隔结束时装入，保证停止后输出低电平
+	ir_tx_env[m].ccr=0;
+	return m+1;
+}
+
+// 启动一帧：前两项由CPU写入，其余由更新事件DMA写入
+static void IR_Tx_Start(u16 m)
+{
+	TIM1->CR1&=~TIM_CR1_CEN;
+	TIM1->CNT=0;
+	TIM1->RCR=ir_tx_env[0].rcr;
+	TIM1->CCR1=ir_tx_env[0].ccr;
+	HAL_TIM_GenerateEvent(&TIM1_Handler,TIM_EVENTSOURCE_UPDATE);  // 第一项装入影子寄存器（URS=1，不触发DMA）
+	TIM1->RCR=ir_tx_env[1].rcr;         // 第二项在第一项结束时生效
+	TIM1->CCR1=ir_tx_env[1].ccr;
+
+	HAL_DMA_Start_IT(&ir_tx_dma,(u32)&ir_tx_env[2],(u32)&TIM1->DMAR,(u32)(m-2)*2);
+	TIM1->DIER|=TIM_DIER_UDE;           // 更新事件触发DMA突发传输
+	TIM1->CR1|=TIM_CR1_CEN;
+	ir_tx_active=1;
+	ir_tx_stats.frames++;
+}
+
+// 开始下一帧：当前任务的下一次重复，或队列中的下一个任务；都没有则停止
+// 调用：TIM1更新中断，或发射空闲时由IR_Tx_Send()在关中断下调用
+static void IR_Tx_Next(void)
+{
+	const IR_Signal *sig;
+	u16 n,m;
+	u32 period,i;
+
+	for(;;)
+	{
+		if(!ir_tx_left)
+		{
+			if(ir_tx_tail==ir_tx_head)
+			{
+				ir_tx_active=0;
+				return;
+			}
+			ir_tx_job=ir_tx_queue[ir_tx_tail&(IR_TX_QUEUE_LEN-1)];
+			ir_tx_tail++;
+			ir_tx_left=ir_tx_job.repeats+1;
+			ir_tx_rpt=0;
+			ir_tx_toggle^=1;            // 新按键
+		}
+
+		if(ir_tx_job.protocol==IR_PROTO_LEARNED)
+		{
+			sig=IR_Lib_Get((u8)ir_tx_job.address);
+			n=sig?IR_Signal_Decode(sig,ir_tx_seg,IR_TX_SEG_MAX):0;
+			for(i=0,period=IR_TX_RAW_GAP_US;i<n;i++) period+=ir_tx_seg[i];
+		}
+		else
+		{
+			n=IR_Encode(ir_tx_job.protocol,ir_tx_job.address,ir_tx_job.command,ir_tx_toggle,ir_tx_rpt>0,
+			            ir_tx_seg,IR_TX_SEG_MAX);
+			period=IR_Tx_Period(ir_tx_job.protocol);
+		}
+		m=n?IR_Tx_Envelope(n,period):0;
+		if(m>=3)
+		{
+			ir_tx_left--;
+			ir_tx_rpt++;
+			if(!ir_tx_left) ir_tx_stats.jobs++;
+			IR_Tx_Start(m);
+			return;
+		}
+		ir_tx_stats.encode_fail++;      // 无法编码：丢弃整个任务
+		ir_tx_left=0;
+	}
+}
+
+// ==================== 中断服务函数 ====================
+// DMA传输完成：结束项已写入预装载寄存器，最后一段（帧后间隔）正在输出
+static void IR_Tx_DMA_Cplt(DMA_HandleTypeDef *hdma)
+{
+	(void)hdma;
+	TIM1->DIER&=~TIM_DIER_UDE;
+	__HAL_TIM_CLEAR_FLAG(&TIM1_Handler,TIM_FLAG_UPDATE);
+	__HAL_TIM_ENABLE_IT(&TIM1_Handler,TIM_IT_UPDATE);   // 帧后间隔结束时进入更新中断
+}
+
+void DMA2_Stream5_IRQHandler(void)
+{
+	HAL_DMA_IRQHandler(&ir_tx_dma);
+}
+
+// 帧后间隔结束：结束项已生效（输出低电平），停止计数器，开始下一帧
+void TIM1_UP_TIM10_IRQHandler(void)
+{
+	if(__HAL_TIM_GET_FLAG(&TIM1_Handler,TIM_FLAG_UPDATE))
+	{
+		__HAL_TIM_CLEAR_FLAG(&TIM1_Handler,TIM_FLAG_UPDATE);
+		__HAL_TIM_DISABLE_IT(&TIM1_Handler,TIM_IT_UPDATE);
+		TIM1->CR1&=~TIM_CR1_CEN;
+		IR_Tx_Next();
+	}
+}
+
+// ==================== 初始化 ====================
+// TIM1：96MHz计数，自动重装值IR_TX_ARR（38kHz），通道1 PWM1模式，比较值预装载
+// 计数器只在发射期间运行，停止时CCR1=0，PA8输出低电平
+void IR_Tx_Init(void)
+{
+	TIM_OC_InitTypeDef TIM1_CH1Handler;     // 定时器1通道1配置
+
+	ir_tx_head=ir_tx_tail=0;
+	ir_tx_left=0;
+	ir_tx_active=0;
+	memset(&ir_tx_stats,0,sizeof(ir_tx_stats));
+
+	TIM1_Handler.Instance=TIM1;                          // 高级定时器1
+	TIM1_Handler.Init.Prescaler=0;                       // 不分频，96MHz
+	TIM1_Handler.Init.CounterMode=TIM_COUNTERMODE_UP;    // 向上计数模式
+	TIM1_Handler.Init.Period=IR_TX_ARR;                  // 载波周期
+	TIM1_Handler.Init.ClockDivision=TIM_CLOCKDIVISION_DIV1;
+	TIM1_Handler.Init.RepetitionCounter=0;
+	HAL_TIM_PWM_Init(&TIM1_Handler);
+
+	TIM1_CH1Handler.OCMode=TIM_OCMODE_PWM1;              // PWM1模式：CNT<CCR1时输出高电平
+	TIM1_CH1Handler.Pulse=0;                             // 初始为间隔
+	TIM1_CH1Handler.OCPolarity=TIM_OCPOLARITY_HIGH;
+	TIM1_CH1Handler.OCNPolarity=TIM_OCNPOLARITY_HIGH;
+	TIM1_CH1Handler.OCFastMode=TIM_OCFAST_DISABLE;
+	TIM1_CH1Handler.OCIdleState=TIM_OCIDLESTATE_RESET;   // 空闲（MOE=0）时输出低电平
+	TIM1_CH1Handler.OCNIdleState=TIM_OCNIDLESTATE_RESET;
+	HAL_TIM_PWM_ConfigChannel(&TIM1_Handler,&TIM1_CH1Handler,TIM_CHANNEL_1);  // 同时使能CCR1预装载
+
+	TIM1->CR1|=TIM_CR1_URS;                              // 软件UG不产生更新请求，只有计数溢出触发DMA
+	TIM1->DCR=TIM_DMABASE_RCR|TIM_DMABURSTLENGTH_2TRANSFERS;  // DMA突发：RCR、CCR1
+	TIM1->CCER|=TIM_CCER_CC1E;                           // 开启通道1输出
+	TIM1->BDTR|=TIM_BDTR_MOE;                            // 高级定时器主输出使能
+}
+
+//定时器1底层驱动：时钟使能，PA8引脚配置，TIM1_UP DMA配置
+//此函数会被HAL_TIM_PWM_Init()调用
+//htim:定时器1句柄
+void HAL_TIM_PWM_MspInit(TIM_HandleTypeDef *htim)
+{
+    GPIO_InitTypeDef GPIO_Initure;
+
+    __HAL_RCC_TIM1_CLK_ENABLE();			//使能定时器1
+    __HAL_RCC_GPIOA_CLK_ENABLE();			//开启GPIOA时钟
+    __HAL_RCC_DMA2_CLK_ENABLE();            //使能DMA2时钟
+
+    GPIO_Initure.Pin=GPIO_PIN_8;           	//PA8
+    GPIO_Initure.Mode=GPIO_MODE_AF_PP;  	//复用推挽输出
+    GPIO_Initure.Pull=GPIO_PULLDOWN;        //下拉，复位期间发射管不亮
+    GPIO_Initure.Speed=GPIO_SPEED_HIGH;     //高速
+    GPIO_Initure.Alternate=GPIO_AF1_TIM1;	//PA8复用为TIM1通道1
+    HAL_GPIO_Init(GPIOA,&GPIO_Initure);
+
+    //TIM1_UP DMA请求：DMA2数据流5通道6，包络表 -> TIM1_DMAR
+    ir_tx_dma.Instance=DMA2_Stream5;
+    ir_tx_dma.Init.Channel=DMA_CHANNEL_6;
+    ir_tx_dma.Init.Direction=DMA_MEMORY_TO_PERIPH;      //存储器到外设
+    ir_tx_dma.Init.PeriphInc=DMA_PINC_DISABLE;          //外设地址固定（DMAR按DCR分配到RCR/CCR1）
+    ir_tx_dma.Init.MemInc=DMA_MINC_ENABLE;              //存储器地址递增
+    ir_tx_dma.Init.PeriphDataAlignment=DMA_PDATAALIGN_HALFWORD;
+    ir_tx_dma.Init.MemDataAlignment=DMA_MDATAALIGN_HALFWORD;
+    ir_tx_dma.Init.Mode=DMA_NORMAL;                     //每帧启动一次
+    ir_tx_dma.Init.Priority=DMA_PRIORITY_MEDIUM;
+    ir_tx_dma.Init.FIFOMode=DMA_FIFOMODE_DISABLE;
+    HAL_DMA_Init(&ir_tx_dma);
+    ir_tx_dma.XferCpltCallback=IR_Tx_DMA_Cplt;
+    __HAL_LINKDMA(htim,hdma[TIM_DMA_ID_UPDATE],ir_tx_dma);
+
+    HAL_NVIC_SetPriority(DMA2_Stream5_IRQn,2,1);        //低于红外接收（1,3），每帧一次
+    HAL_NVIC_EnableIRQ(DMA2_Stream5_IRQn);
+    HAL_NVIC_SetPriority(TIM1_UP_TIM10_IRQn,2,1);       //只在帧后间隔结束时使能
+    HAL_NVIC_EnableIRQ(TIM1_UP_TIM10_IRQn);
+}
+
+// ==================== 接口函数 ====================
+// 发送一次按键
+// 参数：protocol - 协议编号（协议表中的协议，或IR_PROTO_LEARNED）
+//      address/command - 与接收事件的字段含义相同（学习信号的address为信号库下标）
+//      repeats  - 首帧之后的重复次数（模拟按住）
+// 返回值：1=已排队，0=队列已满
+// 说明：只能在主循环中调用；同一按键连续发送两次时，接收方在重复窗口内会把后一次当作重复
+u8 IR_Tx_Send(u8 protocol,u16 address,u16 command,u8 repeats)
+{
+	u8 head=ir_tx_head;
+	IR_Tx_Job *job;
+
+	if((u8)(head-ir_tx_tail)>=IR_TX_QUEUE_LEN)
+	{
+		ir_tx_stats.rejected++;
+		return 0;
+	}
+	job=&ir_tx_queue[head&(IR_TX_QUEUE_LEN-1)];
+	job->protocol=protocol;
+	job->repeats=repeats;
+	job->address=address;
+	job->command=command;
+	__DMB();
+	ir_tx_head=head+1;
+
+	__disable_irq();                    // 与帧结束中断互斥：中断中发现队列已空后才会清除ir_tx_active
+	if(!ir_tx_active) IR_Tx_Next();
+	__enable_irq();
+	return 1;
+}
+
+// 是否正在发射（含队列中未发送的任务）
+u8 IR_Tx_Busy(void)
+{
+	return ir_tx_active||ir_tx_tail!=ir_tx_head;
+}
+
+void IR_Tx_Get_Stats(IR_Tx_Stats *st)
+{
+	__disable_irq();
+	*st=ir_tx_stats;
+	__enable_irq();
+}
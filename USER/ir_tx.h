@@ -0,0 +1,69 @@
+#ifndef __IR_TX_H
+#define __IR_TX_H
+#include "sys.h"
+#include "ir_decode.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 红外发射头文件
+// 功能说明：TIM1_CH1（PA8）产生38kHz载波，DMA按包络表改写重复计数器和比较值，
+//          整帧的载波/间隔由硬件按序输出，CPU每帧只做一次设置
+// 包络表：每项为一段连续载波或间隔，{RCR,CCR1}两个半字；TIM1每次更新事件（RCR+1个载波周期）
+//        由DMA突发传输写入下一项，CCR1=0的项输出间隔
+// 发送队列：主循环调用IR_Tx_Send()排队，帧间切换在TIM1更新中断中完成，发射期间主循环可以继续刷新界面
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 发射参数 ====================
+// IR_TX_TIM_HZ：    TIM1计数时钟（APB2=96MHz，不分频）
+// IR_TX_CARRIER_HZ：载波频率（1000的整数倍），TIM1自动重装值由它计算
+// IR_TX_DUTY：      载波占空比（%），红外LED一般用1/3占空比降低平均电流
+// IR_TX_ENV_LEN：   包络表项数，一项最长256个载波周期（约6.7ms），更长的段拆成多项
+// IR_TX_SEG_MAX：   一帧最多的电平段（与学习信号的最大段数相同）
+// IR_TX_GAP_US：    帧后最短间隔（不足帧周期时补足到帧周期）
+// IR_TX_RAW_GAP_US：学习信号每次发射之后的间隔（信号库不记录原遥控器的帧周期）
+// IR_TX_QUEUE_LEN： 发送队列长度（2的幂，不超过128）
+#define IR_TX_TIM_HZ        96000000UL
+#define IR_TX_CARRIER_HZ    38000UL
+#define IR_TX_ARR           (IR_TX_TIM_HZ/IR_TX_CARRIER_HZ-1)
+#define IR_TX_DUTY          33
+#define IR_TX_CCR           ((IR_TX_ARR+1)*IR_TX_DUTY/100)
+#define IR_TX_RCR_MAX       256
+#define IR_TX_ENV_LEN       256
+#define IR_TX_SEG_MAX       200
+#define IR_TX_GAP_US        10000UL
+#define IR_TX_RAW_GAP_US    40000UL
+#define IR_TX_QUEUE_LEN     8
+
+// 包络表项（DMA突发传输依次写入TIM1_RCR、TIM1_CCR1）
+typedef struct
+{
+    u16 rcr;            // 本段载波周期数-1
+    u16 ccr;            // 比较值：IR_TX_CCR=载波，0=间隔
+} IR_Tx_Env;
+
+// 发送任务：一次按键（首帧 + repeats次重复）
+typedef struct
+{
+    u8  protocol;       // 协议编号（IR_PROTO_xxx），IR_PROTO_LEARNED为信号库中的学习信号
+    u8  repeats;        // 首帧之后的重复次数（NEC/扩展NEC发重复码，其他协议重发同一帧）
+    u16 address;        // 地址（学习信号为信号库下标）
+    u16 command;        // 命令（学习信号不使用）
+} IR_Tx_Job;
+
+// 发射统计
+typedef struct
+{
+    u32 frames;         // 已发出的帧（含重复码/重复帧）
+    u32 jobs;           // 已完成的发送任务
+    u32 rejected;       // 队列满时被拒绝的任务
+    u32 encode_fail;    // 无法编码的任务（协议不支持、学习信号不存在、包络表容量不足）
+} IR_Tx_Stats;
+
+// ==================== 函数声明 ====================
+void IR_Tx_Init(void);
+u8 IR_Tx_Send(u8 protocol, u16 address, u16 command, u8 repeats);
+u8 IR_Tx_Busy(void);
+void IR_Tx_Get_Stats(IR_Tx_Stats *st);
+
+#endif
@@ -0,0 +1,68 @@
+#include "key_gesture.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 按键手势识别
+// 功能说明：按下记录时刻并判断双击，重复事件推进最后一帧时刻并判断长按，
+//          松开时按是否已长按给出短按或长按松开
+// 计时原理：所有时刻都是32位us时间戳，用无符号差值比较，回绕后依然正确
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// 按键按下
+// 参数：g   - 手势识别状态
+//      key - 按下的按键
+//      cfg - 该按键的手势参数，NULL表示不识别手势
+//      t_us- 按下事件的时间戳
+// 返回值：KEY_GST_DOUBLE=与上一次短按组成双击，否则KEY_GST_NONE
+u8 Key_Gesture_Press(Key_Gesture *g,u8 key,const Key_Gesture_Cfg *cfg,u32 t_us)
+{
+	u8 dbl;
+
+	dbl=(cfg&&g->tap&&g->tap_key==key&&t_us-g->tap_us<=(u32)cfg->double_ms*1000);
+	g->cfg=cfg;
+	g->key=key;
+	g->held=0;
+	g->dbl=dbl;
+	g->tap=0;               // 一次短按只能作为一个双击的第一击
+	g->down_us=t_us;
+	g->last_us=t_us;
+	return dbl?KEY_GST_DOUBLE:KEY_GST_NONE;
+}
+
+// 重复事件：按住达到长按时间时给出一次长按
+u8 Key_Gesture_Repeat(Key_Gesture *g,u32 t_us)
+{
+	if(g->cfg==0) return KEY_GST_NONE;
+	g->last_us=t_us;
+	if(g->held||t_us-g->down_us<(u32)g->cfg->hold_ms*1000) return KEY_GST_NONE;
+	g->held=1;
+	return KEY_GST_HOLD;
+}
+
+// 按键松开
+// 返回值：KEY_GST_HOLD_END=长按后松开，KEY_GST_TAP=短按，KEY_GST_NONE=不识别手势的按键
+// 说明：双击的第二击松开时也给出短按，但不再作为下一次双击的第一击
+u8 Key_Gesture_Release(Key_Gesture *g)
+{
+	const Key_Gesture_Cfg *cfg=g->cfg;
+
+	g->cfg=0;
+	if(cfg==0) return KEY_GST_NONE;
+	if(g->held) return KEY_GST_HOLD_END;
+	if(!g->dbl)
+	{
+		g->tap=1;
+		g->tap_key=g->key;
+		g->tap_us=g->last_us;
+	}
+	return KEY_GST_TAP;
+}
+
+// 手势名称（串口调试输出用）
+const char *Key_Gesture_Name(u8 gesture)
+{
+	static const char *const name[]={"none","tap","double","hold","hold-end"};
+
+	return gesture<=KEY_GST_HOLD_END?name[gesture]:"?";
+}
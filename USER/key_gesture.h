@@ -0,0 +1,50 @@
+#ifndef __KEY_GESTURE_H
+#define __KEY_GESTURE_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 按键手势识别头文件
+// 功能说明：由按下/重复/松开事件的时间戳识别短按、双击、长按和长按松开
+// 设计思路：增量状态机，每个事件只做常数次比较，不等待后续事件
+//          短按在松开事件时给出，双击在第二次按下时给出（第一次短按已经给出，不会撤回），
+//          按键本身的功能仍在按下事件中立即执行，手势识别不增加普通按键的响应延迟
+// 时间基准：按住时长由按下和最后一个重复事件的时间戳计算（松开事件的时间为松开超时的判定时间，
+//          比实际松开晚约IR_RELEASE_MS，不参与计算）
+// 依赖说明：本模块不访问任何硬件寄存器，时间单位为us（Remote_Time_Us时间基准）
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 手势类型 ====================
+#define KEY_GST_NONE        0       // 无
+#define KEY_GST_TAP         1       // 短按：按住不到hold_ms就松开（松开时给出）
+#define KEY_GST_DOUBLE      2       // 双击：短按松开后double_ms内再次按下同一按键（按下时给出）
+#define KEY_GST_HOLD        3       // 长按：按住达到hold_ms（重复事件中给出，每次按住只给一次）
+#define KEY_GST_HOLD_END    4       // 长按后松开
+
+// ==================== 按键手势参数 ====================
+typedef struct
+{
+	u16 hold_ms;        // 长按判定时间（按下到最后一个重复事件）
+	u16 double_ms;      // 双击间隔（上一次短按的最后一帧到这次按下）
+} Key_Gesture_Cfg;
+
+// ==================== 手势识别状态 ====================
+typedef struct
+{
+	const Key_Gesture_Cfg *cfg; // 当前按住按键的参数，NULL表示无按键或不识别手势
+	u8  key;            // 当前按住的按键
+	u8  held;           // 1=本次按住已给出长按
+	u8  dbl;            // 1=本次按下已给出双击（松开时不再作为下一次双击的第一击）
+	u8  tap;            // 1=tap_key的短按可以与下一次按下组成双击
+	u8  tap_key;        // 上一次短按的按键
+	u32 down_us;        // 按下时刻
+	u32 last_us;        // 最后一帧（按下或重复）的时刻
+	u32 tap_us;         // 上一次短按最后一帧的时刻
+} Key_Gesture;
+
+u8 Key_Gesture_Press(Key_Gesture *g,u8 key,const Key_Gesture_Cfg *cfg,u32 t_us);  // 按下：返回KEY_GST_DOUBLE或NONE
+u8 Key_Gesture_Repeat(Key_Gesture *g,u32 t_us);                                    // 重复：返回KEY_GST_HOLD或NONE
+u8 Key_Gesture_Release(Key_Gesture *g);                                            // 松开：返回TAP/HOLD_END或NONE
+const char *Key_Gesture_Name(u8 gesture);
+#endif
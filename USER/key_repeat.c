@@ -0,0 +1,57 @@
+#include "key_repeat.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 长按自动重复引擎
+// 功能说明：按下时记录时间戳，之后每收到一个重复事件就按事件时间推进重复时刻
+//          返回从上次处理到本次事件之间应触发的重复次数
+// 计时原理：所有时刻都是32位us时间戳，用有符号差值比较，回绕后依然正确
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// 按键按下：记录按下时刻，安排第一次重复
+// 参数：r   - 重复引擎状态
+//      key - 按下的按键
+//      cfg - 该按键的重复参数，NULL表示不支持长按重复
+//      t_us- 按下事件的时间戳
+void Key_Repeat_Start(Key_Repeat *r,u8 key,const Key_Repeat_Cfg *cfg,u32 t_us)
+{
+	r->cfg=cfg;
+	r->key=key;
+	r->count=0;
+	if(cfg==0) return;
+	r->next_us=t_us+(u32)cfg->delay_ms*1000;
+	r->period_us=(u32)cfg->rate_ms*1000;
+}
+
+// 重复事件：按事件时间戳推进重复时刻
+// 参数：r   - 重复引擎状态
+//      t_us- 重复事件的时间戳
+// 返回值：到t_us为止新到期的重复次数（0表示还未到重复时刻）
+u8 Key_Repeat_Update(Key_Repeat *r,u32 t_us)
+{
+	const Key_Repeat_Cfg *cfg=r->cfg;
+	u32 min_us;
+	u8 n=0;
+	
+	if(cfg==0) return 0;
+	min_us=(u32)cfg->min_ms*1000;
+	while((s32)(t_us-r->next_us)>=0&&n<KEY_RPT_MAX_BURST)
+	{
+		n++;
+		r->count++;
+		r->next_us+=r->period_us;
+		// 加速：间隔按比例缩短，不低于最小间隔
+		r->period_us=r->period_us/100*cfg->accel_pct;
+		if(r->period_us<min_us) r->period_us=min_us;
+	}
+	if(n==KEY_RPT_MAX_BURST) r->next_us=t_us+r->period_us;  // 补齐次数达上限：从当前时刻重新计时
+	return n;
+}
+
+// 按键松开：停止重复
+void Key_Repeat_Stop(Key_Repeat *r)
+{
+	r->cfg=0;
+	r->key=0;
+}
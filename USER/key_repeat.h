@@ -0,0 +1,43 @@
+#ifndef __KEY_REPEAT_H
+#define __KEY_REPEAT_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 长按自动重复引擎头文件
+// 功能说明：根据按下/重复事件的时间戳计算长按期间应触发的重复次数
+// 设计思路：重复节奏只由遥控器重复码携带的时间戳决定，与主循环周期无关
+//          主循环因LCD刷新等原因停顿时，下次处理事件会一次补齐应触发的次数
+//          每个按键可单独配置首次延时、重复间隔和加速曲线
+// 依赖说明：本模块不访问任何硬件寄存器，时间单位为us（Remote_Time_Us时间基准）
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 单次处理最多补齐的重复次数 ====================
+#define KEY_RPT_MAX_BURST   16          // 防止时间戳异常时一次触发过多
+
+// ==================== 按键重复参数 ====================
+// 重复间隔：第1次为rate_ms，此后每次乘以accel_pct%，直到不小于min_ms为止
+// accel_pct=100表示匀速重复
+typedef struct
+{
+	u16 delay_ms;       // 按下后到第一次重复的延时
+	u16 rate_ms;        // 初始重复间隔
+	u16 min_ms;         // 加速后的最小重复间隔
+	u8  accel_pct;      // 每次重复后间隔缩放比例（%）
+} Key_Repeat_Cfg;
+
+// ==================== 重复引擎状态 ====================
+typedef struct
+{
+	const Key_Repeat_Cfg *cfg;  // 当前按住按键的参数，NULL表示无按键或不支持重复
+	u8  key;            // 当前按住的按键
+	u32 next_us;        // 下一次重复的触发时刻
+	u32 period_us;      // 当前重复间隔
+	u16 count;          // 本次长按已触发的重复次数
+} Key_Repeat;
+
+void Key_Repeat_Start(Key_Repeat *r,u8 key,const Key_Repeat_Cfg *cfg,u32 t_us);  // 按键按下
+u8   Key_Repeat_Update(Key_Repeat *r,u32 t_us);                                     // 重复事件：返回应触发的次数
+void Key_Repeat_Stop(Key_Repeat *r);                                                // 按键松开
+#endif
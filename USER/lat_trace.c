@@ -0,0 +1,162 @@
+#include "lat_trace.h"
+#include "stdio.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 按键到显示延迟追踪
+// 功能说明：追踪点按顺序到达时记录时间戳（PICKUP需要FRAME，DISPATCH需要PICKUP，PWM和LCD需要DISPATCH），
+//          PWM为开始执行按键功能之后的第一次软件PWM中断，两个终点都到达后各阶段差值计入直方图
+// 并发说明：FRAME在PendSV（最低优先级）中调用，PWM在TIM2中断中调用，LCD在SPI DMA中断（或主循环）中调用，
+//          其余在主循环中调用，Lat_Trace_Frame()和Lat_Trace_Mark()都关中断完成检查和记录，终点由最后到达的一方计入统计
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+static u32 lat_t[LAT_PT_COUNT];         // 本次追踪各点的时间戳（周期）
+static u32 lat_edge;                    // 帧最后一个电平段开始的时间（周期）
+static vu8 lat_mask=0;                  // 已到达的追踪点（bit n = LAT_PT_n），0=没有进行中的追踪
+static u32 lat_aborted=0;               // 未结束就被新的按下帧取代的追踪
+static Lat_Hist lat_hist[LAT_ST_COUNT];
+
+static const char *const lat_name[LAT_ST_COUNT]=
+{
+	"decode","pickup","dispatch","pwm","lcd","key->led","key->lcd"
+};
+
+#if LAT_TRACE
+// 各追踪点的前一个追踪点
+static const u8 lat_need[LAT_PT_COUNT]=
+{
+	0,
+	1<<LAT_PT_FRAME,
+	1<<LAT_PT_PICKUP,
+	1<<LAT_PT_DISPATCH,
+	1<<LAT_PT_DISPATCH,
+};
+
+// 累加一次延迟（周期转换为us）
+static void Lat_Hist_Add(Lat_Hist *h,u32 cycles)
+{
+	u32 us=cycles/LAT_CYC_PER_US,v=us;
+	u8 b;
+
+	for(b=0;v&&b<LAT_BINS-1;b++) v>>=1;    // 第b格：[2^(b-1),2^b)us
+	h->bins[b]++;
+	if(h->count==0||us<h->min) h->min=us;
+	if(us>h->max) h->max=us;
+	h->total+=us;
+	h->count++;
+}
+
+// 一次追踪完成：计入各阶段统计（关中断中调用）
+static void Lat_Trace_Done(void)
+{
+	Lat_Hist_Add(&lat_hist[LAT_ST_DECODE],lat_t[LAT_PT_FRAME]-lat_edge);
+	Lat_Hist_Add(&lat_hist[LAT_ST_PICKUP],lat_t[LAT_PT_PICKUP]-lat_t[LAT_PT_FRAME]);
+	Lat_Hist_Add(&lat_hist[LAT_ST_DISPATCH],lat_t[LAT_PT_DISPATCH]-lat_t[LAT_PT_PICKUP]);
+	Lat_Hist_Add(&lat_hist[LAT_ST_PWM],lat_t[LAT_PT_PWM]-lat_t[LAT_PT_DISPATCH]);
+	Lat_Hist_Add(&lat_hist[LAT_ST_LCD],lat_t[LAT_PT_LCD]-lat_t[LAT_PT_DISPATCH]);
+	Lat_Hist_Add(&lat_hist[LAT_ST_LED_TOTAL],lat_t[LAT_PT_PWM]-lat_edge);
+	Lat_Hist_Add(&lat_hist[LAT_ST_LCD_TOTAL],lat_t[LAT_PT_LCD]-lat_edge);
+}
+
+// 启动DWT周期计数器并清除统计
+void Lat_Trace_Init(void)
+{
+	CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;        //使能DWT
+	DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;                   //启动周期计数器（不清零，IR_PROFILE可能已在使用）
+	Lat_Trace_Reset();
+}
+
+// 解出按下帧：开始一次新的追踪
+// 参数：edge_us - 帧最后一个电平段的开始时间，now_us - 当前时间（Remote_Time_Us时基）
+// 说明：在PendSV中调用，可被TIM2和SPI DMA中断中的追踪点打断，关中断完成
+void Lat_Trace_Frame(u32 edge_us,u32 now_us)
+{
+	u32 c=LAT_CYCLES();
+
+	__disable_irq();
+	if(lat_mask) lat_aborted++;
+	lat_edge=c-(now_us-edge_us)*LAT_CYC_PER_US;
+	lat_t[LAT_PT_FRAME]=c;
+	lat_mask=1<<LAT_PT_FRAME;
+	__enable_irq();
+}
+
+// 到达一个追踪点：前一个追踪点已到达且本点尚未记录时记下时间戳
+void Lat_Trace_Mark(u8 point)
+{
+	u32 c=LAT_CYCLES();
+	u8 bit=1<<point;
+
+	__disable_irq();
+	if((lat_mask&lat_need[point])&&!(lat_mask&bit))
+	{
+		lat_t[point]=c;
+		lat_mask|=bit;
+		if((lat_mask&(1<<LAT_PT_PWM))&&(lat_mask&(1<<LAT_PT_LCD)))
+		{
+			Lat_Trace_Done();
+			lat_mask=0;
+		}
+	}
+	__enable_irq();
+}
+#endif
+
+// 清除统计（进行中的追踪一并放弃）
+void Lat_Trace_Reset(void)
+{
+	__disable_irq();
+	memset(lat_hist,0,sizeof(lat_hist));
+	lat_mask=0;
+	lat_aborted=0;
+	__enable_irq();
+}
+
+// 读取一个阶段的统计快照
+void Lat_Trace_Get(u8 stage,Lat_Hist *h)
+{
+	if(stage>=LAT_ST_COUNT)
+	{
+		memset(h,0,sizeof(*h));
+		return;
+	}
+	__disable_irq();
+	*h=lat_hist[stage];
+	__enable_irq();
+}
+
+// 通过串口打印各阶段的最小/平均/最大延迟和直方图（us）
+// 直方图每列为该格的下限：0,1,2,4,...,64k
+void Lat_Trace_Print(void)
+{
+	Lat_Hist h;
+	u8 s,b;
+
+	Lat_Trace_Get(LAT_ST_LCD_TOTAL,&h);
+	printf("[LAT] key-to-photon latency (us): traces=%lu aborted=%lu\r\n",(unsigned long)h.count,(unsigned long)lat_aborted);
+	printf("[LAT] %-9s %6s %8s %8s %8s\r\n","stage","n","min","avg","max");
+	for(s=0;s<LAT_ST_COUNT;s++)
+	{
+		Lat_Trace_Get(s,&h);
+		printf("[LAT] %-9s %6lu %8lu %8lu %8lu\r\n",lat_name[s],(unsigned long)h.count,(unsigned long)h.min,
+		       (unsigned long)(h.count?h.total/h.count:0),(unsigned long)h.max);
+	}
+	printf("[LAT] %-9s","hist");
+	for(b=0;b<LAT_BINS;b++)
+	{
+		u32 lo=b?1UL<<(b-1):0;
+
+		if(lo>=1024) printf(" %4luk",(unsigned long)(lo>>10));
+		else printf(" %5lu",(unsigned long)lo);
+	}
+	printf("\r\n");
+	for(s=0;s<LAT_ST_COUNT;s++)
+	{
+		Lat_Trace_Get(s,&h);
+		printf("[LAT] %-9s",lat_name[s]);
+		for(b=0;b<LAT_BINS;b++) printf(" %5lu",(unsigned long)h.bins[b]);
+		printf("\r\n");
+	}
+}
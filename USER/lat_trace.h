@@ -0,0 +1,71 @@
+#ifndef __LAT_TRACE_H
+#define __LAT_TRACE_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 按键到显示延迟追踪头文件
+// 功能说明：从遥控器帧的最后一个边沿开始，记录一次按下经过各处理环节的DWT周期时间戳，
+//          统计各阶段延迟的对数直方图，串口命令"lat"打印
+// 追踪点：LAT_PT_FRAME    PendSV中解出按下帧（Remote_Poll，起点为帧最后一个电平段的开始）
+//        LAT_PT_PICKUP   主循环取出按下事件（Remote_Get_Event）
+//        LAT_PT_DISPATCH 开始执行按键功能（Process_Remote_Key）
+//        LAT_PT_PWM      软件PWM中断应用新的LED状态/占空比（Software_PWM_LED_Control）
+//        LAT_PT_LCD      按键功能的LCD刷新全部发送完毕（SPI DMA队列中本次刷新的最后一个任务完成）
+// 设计思路：同一时刻只追踪一次按下，PWM和LCD两个终点都到达后计入直方图；
+//          追踪未结束又解出新的按下帧时放弃旧的追踪并计数；重复码不追踪
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+// LAT_TRACE：1=启用延迟追踪，0=追踪点编译为空
+#define LAT_TRACE           1
+#define LAT_CYC_PER_US      96          // DWT周期/us（96MHz）
+#define LAT_BINS            18          // 直方图：第0格为0us，第k格为[2^(k-1),2^k)us，最后一格为65.536ms以上
+
+// 时间戳来源：DWT周期计数器（主机仿真中由STUB/sys.h改为虚拟时间）
+#ifndef LAT_CYCLES
+#define LAT_CYCLES()        (DWT->CYCCNT)
+#endif
+
+// ==================== 追踪点 ====================
+#define LAT_PT_FRAME        0
+#define LAT_PT_PICKUP       1
+#define LAT_PT_DISPATCH     2
+#define LAT_PT_PWM          3
+#define LAT_PT_LCD          4
+#define LAT_PT_COUNT        5
+
+// ==================== 统计阶段 ====================
+#define LAT_ST_DECODE       0           // 最后边沿 -> 解出帧
+#define LAT_ST_PICKUP       1           // 解出帧 -> 主循环取出
+#define LAT_ST_DISPATCH     2           // 取出 -> 执行按键功能
+#define LAT_ST_PWM          3           // 执行按键功能 -> PWM应用
+#define LAT_ST_LCD          4           // 执行按键功能 -> LCD发送完毕
+#define LAT_ST_LED_TOTAL    5           // 最后边沿 -> PWM应用（按键到LED）
+#define LAT_ST_LCD_TOTAL    6           // 最后边沿 -> LCD发送完毕（按键到屏幕）
+#define LAT_ST_COUNT        7
+
+// 一个阶段的延迟统计（us）
+typedef struct
+{
+	u32 count;
+	u32 min;
+	u32 max;
+	uint64_t total;                     // 平均值=total/count
+	u32 bins[LAT_BINS];
+} Lat_Hist;
+
+#if LAT_TRACE
+void Lat_Trace_Init(void);
+void Lat_Trace_Frame(u32 edge_us,u32 now_us);   // PendSV：解出按下帧，edge_us为帧最后一个电平段的开始
+void Lat_Trace_Mark(u8 point);                  // 其他追踪点（LAT_PT_PICKUP~LAT_PT_LCD）
+#else
+#define Lat_Trace_Init()
+#define Lat_Trace_Frame(edge_us,now_us)
+#define Lat_Trace_Mark(point)
+#endif
+void Lat_Trace_Reset(void);
+void Lat_Trace_Get(u8 stage,Lat_Hist *h);       // 读取一个阶段的统计快照
+void Lat_Trace_Print(void);                     // 串口打印各阶段统计和直方图
+#endif
@@ -3,9 +3,19 @@
 #include "usart.h"
 #include "led.h"
 #include "spi.h"
+#include "spi_dma.h"
 #include "tftlcd.h"
+#include "lcd_band.h"
+#include "ui_widget.h"
 #include "remote.h"
+#include "ir_tx.h"
+#include "irda_simple.h"
 #include "pwm.h"
+#include "key_repeat.h"
+#include "key_gesture.h"
+#include "lat_trace.h"
+#include "string.h"
+#include "stdlib.h"
 
 /************************************************
  红外遥控LED调光系统 - 主程序文件
@@ -35,9 +45,8 @@ u8 all_led_status = 1;       // 所有LED的统一状态：1=关闭，0=开启
 u8 led_brightness_level = 5; // LED亮度等级：0-10级（0最暗，10最亮）
 
 // 按键防抖变量组（防止按键重复触发导致的误操作）
-u8 last_key = 0;         // 上一次按键值，用于检测按键变化
-u8 key_repeat_count = 0; // 按键重复计数器，用于实现长按功能
-u8 key_debounce_timer = 0; // 按键防抖定时器，消除按键抖动
+Key_Repeat key_rpt;      // 长按自动重复引擎状态（按住的按键、下次重复时刻）
+Key_Gesture key_gst;     // 按键手势识别状态（短按/双击/长按）
 
 // ==================== 函数声明区 ====================
 // LCD显示相关函数
@@ -49,6 +58,8 @@ void Show_Key_Info_New(u8 key);         // 显示按键信息
 
 // 系统控制相关函数
 void Process_Remote_Key(u8 key);        // 处理红外遥控按键
+void Process_Key_Gesture(u8 key, u8 gst);  // 处理按键手势
+void Process_Uart_Command(void);        // 处理串口命令
 
 // 实验21兼容函数（保持接口兼容性）
 void LED_Toggle(u8 led_num);            // 切换指定LED状态
@@ -58,10 +69,81 @@ void LED_Brightness_Up(void);           // 增加LED亮度
 void LED_Brightness_Down(void);         // 降低LED亮度
 void System_Mode_Switch(void);          // 系统模式切换
 
+// ==================== 按键功能映射表 ====================
+/*
+ * 按命令字节直接索引的256项常量表（存放在Flash中）：
+ * - 按键处理只需一次查表，不再逐个case比较
+ * - 显示文本在编译期拼好，按键时无需sprintf格式化
+ * - 更换遥控器或调整按键功能时只需修改本表
+ * - 表中未登记的命令字节全为0，即"Unknown"按键
+ */
+typedef void (*Key_Handler)(u8 arg);   // 按键功能函数，arg为表中登记的参数
+
+#define KEY_RPT_NONE     0              // 长按不重复，只在按下时执行一次
+#define KEY_GST_OFF      0              // 不识别手势
+
+// 长按重复参数：首次延时、初始间隔、最小间隔、每次加速比例
+// 亮度调节：按住300ms后开始，间隔从200ms逐次缩短到60ms
+static const Key_Repeat_Cfg key_rpt_bright = { 300, 200, 60, 80 };
+
+// 手势参数：长按判定时间、双击间隔
+// 数字键0-7双击：只保留这一路LED；POWER长按：回到主页面；UP/DOWN长按松开时打印最终亮度
+static const Key_Gesture_Cfg key_gst_std = { 800, 400 };
+
+typedef struct
+{
+	Key_Handler handler;    // 功能函数，NULL表示只显示按键信息
+	u8 arg;                 // 传给功能函数的参数（LED编号等）
+	const Key_Repeat_Cfg *repeat;  // 长按重复参数，KEY_RPT_NONE表示不重复
+	const Key_Gesture_Cfg *gesture;  // 手势参数，KEY_GST_OFF表示不识别手势
+	const char *name;       // 按键名称
+	const char *label;      // 预先拼好的LCD显示文本
+} Key_Action;
+
+static void Key_All_Toggle(u8 arg);     // 数字9：所有LED切换
+static void Key_All_Off(u8 arg);        // DELETE：关闭所有LED
+static void Key_Mode_Switch(u8 arg);    // POWER：页面切换
+static void Key_Bright_Up(u8 arg);      // UP：亮度增加
+static void Key_Bright_Down(u8 arg);    // DOWN：亮度降低
+
+// hex为按键编码的十六进制文本，必须与code一致
+#define KEY_ENTRY(code, hex, nm, fn, a, rpt, gst) \
+	[code] = { fn, a, rpt, gst, nm, "Key:0x" hex " " nm }
+
+static const Key_Action key_table[256] =
+{
+	KEY_ENTRY(KEY_NUM0,     "42", "NUM0",     LED_Toggle,      0, KEY_RPT_NONE,    &key_gst_std),  // LED0控制
+	KEY_ENTRY(KEY_NUM1,     "68", "NUM1",     LED_Toggle,      1, KEY_RPT_NONE,    &key_gst_std),  // LED1控制
+	KEY_ENTRY(KEY_NUM2,     "98", "NUM2",     LED_Toggle,      2, KEY_RPT_NONE,    &key_gst_std),  // LED2控制
+	KEY_ENTRY(KEY_NUM3,     "B0", "NUM3",     LED_Toggle,      3, KEY_RPT_NONE,    &key_gst_std),  // LED3控制
+	KEY_ENTRY(KEY_NUM4,     "30", "NUM4",     LED_Toggle,      4, KEY_RPT_NONE,    &key_gst_std),  // LED4控制
+	KEY_ENTRY(KEY_NUM5,     "18", "NUM5",     LED_Toggle,      5, KEY_RPT_NONE,    &key_gst_std),  // LED5控制
+	KEY_ENTRY(KEY_NUM6,     "7A", "NUM6",     LED_Toggle,      6, KEY_RPT_NONE,    &key_gst_std),  // LED6控制
+	KEY_ENTRY(KEY_NUM7,     "10", "NUM7",     LED_Toggle,      7, KEY_RPT_NONE,    &key_gst_std),  // LED7控制
+	KEY_ENTRY(KEY_NUM8,     "38", "NUM8",     0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 信息显示（预留）
+	KEY_ENTRY(KEY_NUM9,     "5A", "NUM9",     Key_All_Toggle,  0, KEY_RPT_NONE,    KEY_GST_OFF),   // 所有LED切换
+	KEY_ENTRY(KEY_DELETE,   "52", "DELETE",   Key_All_Off,     0, KEY_RPT_NONE,    KEY_GST_OFF),   // 关闭所有LED
+	KEY_ENTRY(KEY_POWER,    "A2", "POWER",    Key_Mode_Switch, 0, KEY_RPT_NONE,    &key_gst_std),  // 页面切换
+	KEY_ENTRY(KEY_UP,       "62", "UP",       Key_Bright_Up,   0, &key_rpt_bright, &key_gst_std),  // 亮度增加，支持长按
+	KEY_ENTRY(KEY_DOWN,     "A8", "DOWN",     Key_Bright_Down, 0, &key_rpt_bright, &key_gst_std),  // 亮度降低，支持长按
+	KEY_ENTRY(KEY_LEFT,     "22", "LEFT",     0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能C（预留）
+	KEY_ENTRY(KEY_PLAY,     "02", "PLAY",     0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能D（预留）
+	KEY_ENTRY(KEY_RIGHT,    "C2", "RIGHT",    0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能E（预留）
+	KEY_ENTRY(KEY_VOL_UP,   "90", "VOL+",     0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能F（预留）
+	KEY_ENTRY(KEY_VOL_DOWN, "E0", "VOL-",     0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能G（预留）
+	KEY_ENTRY(KEY_ALIENTEK, "E2", "ALIENTEK", 0,               0, KEY_RPT_NONE,    KEY_GST_OFF),   // 功能H（预留）
+};
+
 // ==================== 主函数 ====================
 int main(void)
 { 
-    u8 key=0;   // 红外遥控按键值
+    IR_Event ev;   // 红外遥控按键事件
+    u8 key=0;      // 红外遥控按键值
+    u8 n;          // 本次应触发的长按重复次数
+    u8 gst;        // 本次事件识别出的手势
+    u32 stats_tick=0;  // 上一次打印红外接收统计的时间（ms）
+    u8 frame[IRDA_FRAME_MAX];  // IrDA接收帧
+    u16 len;
 
     // ========== 系统初始化阶段 ==========
     HAL_Init();                     // 初始化HAL库（硬件抽象层）
@@ -71,108 +153,94 @@ int main(void)
     LED_Init();                     // 初始化8路LED硬件接口
     LCD_Init();                     // 初始化1.3寸TFTLCD显示屏
     Remote_Init();                  // 初始化红外遥控接收模块
+    IR_Tx_Init();                   // 初始化红外发射（TIM1载波，PA8）
+    IrDA_Init(IRDA_BAUD);           // 初始化IrDA SIR数据链路（USART6，PA11/PA12）
     TIM2_PWM_Init(1000-1,96-1);     // 初始化软件PWM定时器（用于LED亮度控制）
+    Lat_Trace_Init();               // 按键到显示延迟追踪（DWT周期计数器）
     
-    // 显示系统启动主页面
+    // 显示系统启动主页面（一帧，整屏分带合成发送）
+    LCD_Band_Begin();
     Display_Main_Page();
+    LCD_Band_End();
 	
-	// ========== 主循环：按键扫描与处理 ==========
+	// ========== 主循环：按键事件处理 ==========
 	while(1)
 	{
-		key = Remote_Scan();        // 扫描红外遥控按键值
-		
-		// ========== 按键防抖定时器管理 ==========
-		// 防抖定时器每个循环递减1，10ms后自动归零
-		// 作用：确保按键信号稳定后才允许处理，避免机械抖动干扰
-		if(key_debounce_timer > 0) key_debounce_timer--;
-		
-		if(key != 0)  // 检测到按键按下
+		// ========== 取出队列中的全部按键事件 ==========
+		/*
+		 * 事件驱动的按键处理：
+		 * - 解码在PendSV中断中完成，按下/重复/松开事件写入队列
+		 * - 主循环阻塞（LCD刷新、延时）期间的按键不会丢失或合并
+		 * - 每个按下事件都立即处理，无需再做"与上次不同"的比较
+		 */
+		while(Remote_Get_Event(&ev))
 		{
-			// ========== 核心按键防抖算法 ==========
-			/*
-			 * 防抖算法工作原理：
-			 * 1. 新按键检测：当前按键值与上次不同时，立即处理
-			 * 2. 相同按键防抖：设置防抖时间窗口，避免抖动重复触发
-			 * 3. 长按重复：防抖时间过后允许特定按键重复触发
-			 * 4. 状态保持：记录按键状态，用于下次比较
-			 */
+			key = (u8)ev.command;
+			gst = KEY_GST_NONE;
 			
-			if(key != last_key)  // 条件1：检测到新按键（不同于上次按键）
+			if(ev.type == IR_EVT_PRESS)  // 新按键按下：立即处理
 			{
-				// ========== 新按键立即处理分支 ==========
-				/*
-				 * 新按键处理逻辑：
-				 * - 立即响应：新按键无需等待，提升用户体验
-				 * - 状态重置：清除所有防抖和重复计数状态
-				 * - 防抖启动：设置防抖时间窗口，防止后续抖动
-				 */
-				last_key = key;                  // 保存当前按键值，用于下次比较
-				key_repeat_count = 0;            // 重置重复计数器，清除长按状态
-				key_debounce_timer = 10;         // 设置100ms防抖时间（10个循环×10ms）
+				Lat_Trace_Mark(LAT_PT_PICKUP);
+				
+				// 以按下事件的时间戳作为长按计时起点
+				Key_Repeat_Start(&key_rpt, key, key_table[key].repeat, ev.time_us);
 				
-				// 执行按键功能（新按键立即响应）
-				Show_Key_Info_New(key);          // 在LCD上显示按键信息
-				printf("Key Value: 0x%02X (%d)\r\n", key, key);  // 串口输出调试信息
-				Process_Remote_Key(key);         // 执行按键对应的功能
+				printf("Key Value: 0x%02X (%d) P%d @%luus\r\n", key, key, ev.protocol, (unsigned long)ev.time_us);
+				Process_Remote_Key(key);         // 执行按键功能并显示按键信息
+				gst = Key_Gesture_Press(&key_gst, key, key_table[key].gesture, ev.time_us);  // 按键功能先执行，双击不延后单击
 			}
-			else if(key_debounce_timer == 0)  // 条件2：相同按键且防抖时间已过
+			else if(ev.type == IR_EVT_REPEAT && key == key_rpt.key)  // 按住期间的重复码
 			{
-				// ========== 长按重复触发算法 ==========
 				/*
 				 * 长按重复机制说明：
-				 * - 防抖完成：防抖时间归零，确认按键信号稳定
-				 * - 重复计数：累计相同按键的持续时间
-				 * - 选择性重复：只有特定按键（UP/DOWN）支持长按重复
-				 * - 重复频率控制：通过计数器实现不同的重复速度
+				 * - 重复节奏由重复码的时间戳决定，与主循环周期无关
+				 * - 主循环停顿（LCD刷新）后补齐期间应触发的次数，调节量与按住时长一致
+				 * - 首次延时、重复间隔、加速曲线由映射表中每个按键的参数决定
 				 */
-				key_repeat_count++;              // 重复计数递增，记录按键持续时间
-				
-				// UP/DOWN键支持长按连续调节亮度功能
-				if((key == 98 || key == 168) && key_repeat_count >= 25) // 250ms后开始重复
+				n = Key_Repeat_Update(&key_rpt, ev.time_us);
+				while(n--)
 				{
-					/*
-					 * 长按重复触发条件：
-					 * - 按键类型：仅UP(98)和DOWN(168)键支持
-					 * - 触发时间：持续按下250ms（25个循环×10ms）
-					 * - 重复频率：每200ms重复一次（20个循环间隔）
-					 */
-					key_repeat_count = 20;       // 重置为较小值，实现200ms重复间隔
-					Show_Key_Info_New(key);      // 显示重复按键信息
 					printf("Key Value: 0x%02X (%d) [Repeat]\r\n", key, key);
 					Process_Remote_Key(key);     // 执行重复功能（亮度连续调节）
 				}
-				else if(key_repeat_count > 1 && key != 98 && key != 168)
-				{
-					/*
-					 * 其他按键防重复机制：
-					 * - 目的：防止数字键等功能键意外重复触发
-					 * - 方法：检测到重复后强制清零按键值
-					 * - 范围：除UP/DOWN键外的所有按键
-					 */
-					key = 0;  // 强制清零，忽略后续重复触发
-				}
+				gst = Key_Gesture_Repeat(&key_gst, ev.time_us);
 			}
-			// 注意：当key == last_key且key_debounce_timer > 0时
-			// 程序不进入任何分支，直接忽略该次按键，实现防抖效果
-		}
-		else  // 没有按键按下（key == 0）
-		{
-			// ========== 按键释放状态清理 ==========
-			/*
-			 * 按键释放处理：
-			 * - 状态重置：清除所有按键相关的状态变量
-			 * - 准备下次：为下一次按键检测做准备
-			 * - 防止误判：避免释放状态影响后续按键检测
-			 */
-			if(last_key != 0)  // 检查是否有按键状态需要清理
+			else if(ev.type == IR_EVT_RELEASE && key == key_rpt.key)  // 按键松开：停止长按重复
 			{
-				last_key = 0;           // 清除上次按键记录，表示无按键按下
-				key_repeat_count = 0;   // 清除重复计数，准备接收新按键
-				// 注意：防抖定时器会自然递减归零，无需手动清除
+				Key_Repeat_Stop(&key_rpt);
+				gst = Key_Gesture_Release(&key_gst);
 			}
+			
+			// 手势：短按/双击/长按/长按松开，按各按键的手势参数识别
+			if(gst != KEY_GST_NONE) Process_Key_Gesture(key, gst);
+		}
+		
+		// ========== 红外学习：保存录制好的信号 ==========
+		// 录制在PendSV中断中完成，Flash擦写耗时较长，放在主循环中执行
+		n = Remote_Learn_Poll();
+		if(n == IR_LEARN_SAVED) printf("IR learned: %u signals\r\n", IR_Lib_Count());
+		else if(n == IR_LEARN_FAIL)                // 信号库已满，或Flash擦除/写入失败
+			printf("IR learn failed: %s\r\n", IR_Lib_Count() >= IR_LIB_SIZE ? "library full" : "flash write error");
+		
+		// ========== IrDA数据帧 ==========
+		// 只打印长度；按键只来自红外遥控器（经过地址允许列表），IrDA帧不执行按键功能
+		while((len = IrDA_Frame_Receive(frame, sizeof(frame))) != 0)
+			printf("IrDA frame: %u bytes\r\n", len);
+		
+		// ========== 串口命令 ==========
+		Process_Uart_Command();
+		
+		// ========== 红外接收统计周期输出 ==========
+		// 引导码/帧/校验失败/超时计数和中断耗时，用于调整时序窗口和评估中断开销
+#if IR_STATS_PERIOD_MS
+		if(HAL_GetTick() - stats_tick >= IR_STATS_PERIOD_MS)
+		{
+			stats_tick = HAL_GetTick();
+			Remote_Print_Stats();
 		}
+#endif
 		
-		delay_ms(10);  // 主循环延时10ms，控制扫描频率和时间基准
+		delay_ms(10);  // 主循环延时10ms，控制事件扫描频率
 	}
 }
 
@@ -186,381 +254,207 @@ int main(void)
  * 功能：三页面设计，支持文字、图形、进度条显示
  */
 
+// ==================== 页面布局表 ====================
+/*
+ * 页面是控件的常量表（ui_widget.c），布局改动只需修改本表：
+ * - LABEL：固定文字，只在页面显示时画一次
+ * - VALUE：绑定模型值的文字，值变化时才重新sprintf并重画
+ * - BAR：  分段亮度条，只重画亮灭变化的段
+ * - LED：  LED指示灯，绑定led_status_array的一路
+ * 按键处理后调用Update_LED_Display()，只有值变化的控件产生SPI数据
+ */
+static u32 Ui_Get_Status(u8 arg)     { (void)arg; return (u32)led_status << 8 | led_brightness_level; }
+static u32 Ui_Get_All(u8 arg)        { (void)arg; return all_led_status; }
+static u32 Ui_Get_Led_Status(u8 arg) { (void)arg; return led_status; }
+static u32 Ui_Get_Level(u8 arg)      { (void)arg; return led_brightness_level; }
+static u32 Ui_Get_Led(u8 arg)        { return !led_status_array[arg]; }   // 1=点亮
+
+// 主页面状态行：如"LED: ON  Brightness: 7/10"
+static void Ui_Fmt_Status(char *buf, u32 v)
+{
+	sprintf(buf, "LED: %s  Brightness: %d/10", (v >> 8) ? "OFF" : "ON", (int)(v & 0xFF));
+}
+static void Ui_Fmt_All(char *buf, u32 v)     { sprintf(buf, "LED0-7: %s", v ? "SINGLE" : "ALL ON"); }
+static void Ui_Fmt_Current(char *buf, u32 v) { sprintf(buf, "Current: %s", v ? "OFF" : "ON"); }
+static void Ui_Fmt_Level(char *buf, u32 v)   { sprintf(buf, "%d / 10", (int)v); }
+
+// 主页面：黑色背景，Logo + 白色标题 + 黄色按键说明 + 底部绿色状态行
+static const UI_Widget ui_main[] =
+{
+	UI_DRAW_W (0, 0, Display_ALIENTEK_LOGO),
+	UI_LABEL_W(10, 80,  16, WHITE,  BLACK, "IR Remote Control"),
+	UI_LABEL_W(10, 100, 16, WHITE,  BLACK, "LED & LCD System"),
+	UI_LABEL_W(10, 130, 12, YELLOW, BLACK, "Key Functions:"),
+	UI_LABEL_W(10, 145, 12, YELLOW, BLACK, "0-7: LED Control"),
+	UI_LABEL_W(10, 158, 12, YELLOW, BLACK, "9: All LEDs Toggle"),
+	UI_LABEL_W(10, 171, 12, YELLOW, BLACK, "UP/DOWN: Brightness"),
+	UI_LABEL_W(10, 184, 12, YELLOW, BLACK, "POWER: Switch Page"),
+	UI_LABEL_W(10, 197, 12, YELLOW, BLACK, "DELETE: All LEDs OFF"),
+	UI_VALUE_W(10, 215, 12, 162, GREEN, BLACK, Ui_Get_Status, Ui_Fmt_Status),
+};
+
+// LED控制页：蓝色背景，控制模式、总体状态和8路LED指示灯
+#define UI_LED_IND(i) \
+	UI_LED_W  (10 + (i)*28, 95, 20, 12, YELLOW, GRAY, Ui_Get_Led, i), \
+	UI_LABEL_W(17 + (i)*28, 110, 12, WHITE, BLUE, #i)
+
+static const UI_Widget ui_led[] =
+{
+	UI_LABEL_W(10, 10, 16, WHITE, BLUE, "LED Control Page"),
+	UI_LABEL_W(10, 40, 12, WHITE, BLUE, "Current LED Status:"),
+	UI_VALUE_W(10, 60, 12, 84, YELLOW, BLUE, Ui_Get_All, Ui_Fmt_All),
+	UI_VALUE_W(10, 75, 12, 72, YELLOW, BLUE, Ui_Get_Led_Status, Ui_Fmt_Current),
+	UI_LED_IND(0), UI_LED_IND(1), UI_LED_IND(2), UI_LED_IND(3),
+	UI_LED_IND(4), UI_LED_IND(5), UI_LED_IND(6), UI_LED_IND(7),
+};
+
+// 亮度控制页：绿色背景，亮度数值 + 10段亮度条（每段16x16，间距20，白色点亮、黑色熄灭）
+static const UI_Widget ui_bright[] =
+{
+	UI_LABEL_W(10, 10, 16, WHITE, GREEN, "Brightness Control"),
+	UI_LABEL_W(10, 40, 12, WHITE, GREEN, "Current Level:"),
+	UI_VALUE_W(150, 40, 16, 56, BLACK, GREEN, Ui_Get_Level, Ui_Fmt_Level),
+	UI_BAR_W  (10, 70, 10, 16, 16, 20, WHITE, BLACK, Ui_Get_Level),
+};
+
+static const UI_Page ui_pages[3] =
+{
+	UI_PAGE(BLACK, ui_main),
+	UI_PAGE(BLUE,  ui_led),
+	UI_PAGE(GREEN, ui_bright),
+};
+
 // 显示系统主页面
 // 功能：显示ALIENTEK Logo、系统标题和按键功能说明
 // 调用：系统启动时和页面切换时调用
-// 设计：黑色背景+彩色文字，突出专业感和可读性
 void Display_Main_Page(void)
 {
-	// ========== 页面背景和Logo显示 ==========
-	/*
-	 * LCD_Clear()函数原理：
-	 * - 功能：将整个屏幕填充为指定颜色
-	 * - 实现：通过SPI快速写入240*240个像素点
-	 * - 颜色：BLACK = 0x0000（16位RGB565格式）
-	 */
-	LCD_Clear(BLACK);                    // 清屏为黑色背景，提供高对比度
-	
-	/*
-	 * Display_ALIENTEK_LOGO()函数说明：
-	 * - 功能：显示预定义的ALIENTEK公司Logo图形
-	 * - 参数：(0, 0)表示显示位置为左上角
-	 * - 实现：通过像素数组或字符方式绘制Logo
-	 * - 作用：品牌标识和系统启动提示
-	 */
-	Display_ALIENTEK_LOGO(0, 0);         // 在屏幕左上角显示ALIENTEK Logo
-	
-	// ========== 系统标题显示区域 ==========
-	/*
-	 * LCD颜色设置机制：
-	 * POINT_COLOR：文字前景色（字体颜色）
-	 * BACK_COLOR：文字背景色（字符底色）
-	 * 颜色格式：16位RGB565 (R:5位, G:6位, B:5位)
-	 * 常用颜色：BLACK(0x0000), WHITE(0xFFFF), RED(0xF800), GREEN(0x07E0), BLUE(0x001F)
-	 */
-	POINT_COLOR = WHITE;                 // 设置字体颜色为白色，在黑背景上清晰可见
-	BACK_COLOR = BLACK;                  // 设置字符背景为黑色，与屏幕背景一致
-	
-	/*
-	 * LCD_ShowString()函数详解：
-	 * 参数1：x坐标（像素）- 字符串起始X位置
-	 * 参数2：y坐标（像素）- 字符串起始Y位置  
-	 * 参数3：宽度（像素）- 显示区域最大宽度，用于换行控制
-	 * 参数4：高度（像素）- 显示区域最大高度，用于垂直范围控制
-	 * 参数5：字体大小 - 字符高度（12/16/24等），影响显示效果
-	 * 参数6：字符串内容 - 要显示的文本内容
-	 */
-	LCD_ShowString(10, 80, 240, 16, 16, "IR Remote Control");   // 系统标题第1行
-	LCD_ShowString(10, 100, 240, 16, 16, "LED & LCD System");   // 系统标题第2行
-	
-	// ========== 功能说明文字显示区域 ==========
-	/*
-	 * 颜色切换策略：
-	 * - 白色标题：突出系统名称的重要性
-	 * - 黄色说明：功能描述用不同颜色区分，提升可读性
-	 * - 颜色对比：确保在黑色背景上有良好的视觉效果
-	 */
-	POINT_COLOR = YELLOW;                // 切换为黄色字体，用于功能说明文字
-	
-	/*
-	 * 功能说明布局设计：
-	 * Y坐标间距：13-15像素，确保文字不重叠且排列整齐
-	 * 字体大小：12像素高度，适合详细说明文字
-	 * 内容安排：按使用频率和重要性排列功能说明
-	 */
-	LCD_ShowString(10, 130, 240, 12, 12, "Key Functions:");      // 功能说明标题
-	LCD_ShowString(10, 145, 240, 12, 12, "0-7: LED Control");    // 数字键0-7：LED控制
-	LCD_ShowString(10, 158, 240, 12, 12, "9: All LEDs Toggle");  // 数字键9：所有LED切换
-	LCD_ShowString(10, 171, 240, 12, 12, "UP/DOWN: Brightness"); // UP/DOWN键：亮度调节
-	LCD_ShowString(10, 184, 240, 12, 12, "POWER: Switch Page");  // POWER键：页面切换
-	LCD_ShowString(10, 197, 240, 12, 12, "DELETE: All LEDs OFF");// DELETE键：关闭所有LED
-	
-	// ========== 页面状态设置 ==========
-	current_page = 0;                    // 设置当前页面标识为主页面(0)
-	Update_LED_Display();                // 调用状态显示函数，在页面底部显示LED状态
+	current_page = 0;
+	UI_Show(&ui_pages[0]);
 }
 
 // 显示LED控制页面
-// 功能：专门用于显示LED控制状态的页面
-// 背景：蓝色主题，突出LED控制功能
-// 设计：简洁明了，突出LED状态信息的可视化
+// 功能：显示LED控制模式、总体状态和每一路LED的指示灯
 void Display_LED_Control_Page(void)
 {
-	// ========== LED控制页面背景设置 ==========
-	/*
-	 * 页面主题色彩设计原理：
-	 * - 蓝色背景：BLUE = 0x001F，代表技术和控制的专业感
-	 * - 白色文字：在蓝色背景上提供最佳对比度和可读性
-	 * - 功能分区：通过颜色区分不同的功能模块
-	 */
-	LCD_Clear(BLUE);                     // 清屏为蓝色背景，营造控制面板氛围
-	POINT_COLOR = WHITE;                 // 设置字体颜色为白色，确保高对比度
-	BACK_COLOR = BLUE;                   // 设置字符背景为蓝色，与屏幕背景一致
-	
-	// ========== LED控制页面标题和状态显示 ==========
-	/*
-	 * 页面布局设计：
-	 * - 顶部：页面标题，使用16像素大字体突出显示
-	 * - 中部：LED状态信息区域，用于显示当前LED控制模式
-	 * - 底部：由Update_LED_Display()函数动态更新具体状态
-	 */
-	LCD_ShowString(10, 10, 240, 16, 16, "LED Control Page");     // 页面标题，位置靠上
-	LCD_ShowString(10, 40, 240, 12, 12, "Current LED Status:");  // LED状态提示文字
-	
-	current_page = 1;                    // 设置当前页面标识为LED控制页(1)
-	Update_LED_Display();                // 调用状态更新函数，显示具体LED控制信息
+	current_page = 1;
+	UI_Show(&ui_pages[1]);
 }
 
-// 显示亮度控制页面  
-// 功能：专门用于显示LED亮度调节的页面
-// 背景：绿色主题，突出亮度调节功能
-// 特色：包含可视化亮度进度条，直观显示当前亮度等级
+// 显示亮度控制页面
+// 功能：显示亮度数值和可视化亮度条
 void Display_Brightness_Page(void)
 {
-	// ========== 亮度控制页面背景设置 ==========
-	/*
-	 * 绿色主题设计理念：
-	 * - 绿色背景：GREEN = 0x07E0，象征能量和亮度调节
-	 * - 黑色文字：在绿色背景上提供清晰的视觉对比
-	 * - 色彩心理：绿色给用户带来舒适和自然的感受
-	 */
-	LCD_Clear(GREEN);                    // 清屏为绿色背景，突出亮度调节主题
-	POINT_COLOR = WHITE;                 // 设置字体颜色为白色，保持清晰可读
-	BACK_COLOR = GREEN;                  // 设置字符背景为绿色，保持界面一致性
-	
-	// ========== 亮度控制页面内容显示 ==========
-	/*
-	 * 亮度页面特殊设计：
-	 * - 标题简洁：直接说明页面功能
-	 * - 数值显示：Current Level标签为后续数值显示做准备
-	 * - 进度条：由Update_LED_Display()绘制可视化亮度条
-	 */
-	LCD_ShowString(10, 10, 240, 16, 16, "Brightness Control");   // 页面标题
-	LCD_ShowString(10, 40, 240, 12, 12, "Current Level:");       // 亮度等级提示文字
-	
-	current_page = 2;                    // 设置当前页面标识为亮度控制页(2)
-	Update_LED_Display();                // 调用更新函数，显示亮度数值和进度条
+	current_page = 2;
+	UI_Show(&ui_pages[2]);
 }
 
 // 更新LED状态显示函数
-// 功能：根据当前页面显示相应的LED状态信息
-// 调用：在LED状态改变或页面切换时调用
-// 特点：多页面自适应显示，包含文字信息和图形化进度条
+// 功能：重画当前页面中绑定值变化了的控件（状态行、数值、亮度条、指示灯）
+// 调用：在LED状态改变后调用，值没有变化时不产生任何绘制
 void Update_LED_Display(void)
 {
-	char str[50];  // 字符串缓冲区，用于sprintf格式化显示内容
+	UI_Update();
+}
+
+// ==================== 红外遥控按键处理函数 ====================
+// LCD刷新的最后一个SPI DMA任务发送完毕（DMA中断中回调）：延迟追踪的LCD终点
+static void Lat_Lcd_Done(void *arg)
+{
+	(void)arg;
+	Lat_Trace_Mark(LAT_PT_LCD);
+}
+
+// 红外遥控按键处理主函数
+// 功能：查按键映射表执行相应的控制功能，并在LCD上显示按键信息
+// 参数：key - 红外遥控器按键对应的数值编码
+// 说明：按键功能由key_table登记，未登记的按键只显示"Unknown"
+void Process_Remote_Key(u8 key)
+{
+	const Key_Action *act = &key_table[key];  // 一次查表得到按键的全部属性
 	
-	// ========== 主页面状态显示模式 ==========
-	if(current_page == 0)  // 主页面显示模式
-	{
-		/*
-		 * 主页面状态显示设计：
-		 * - 位置：屏幕底部(Y=215)，不干扰主要内容
-		 * - 颜色：绿色文字突出状态信息的重要性
-		 * - 内容：LED总体状态 + 当前亮度等级
-		 * - 格式：简洁明了，一行显示所有关键信息
-		 */
-		POINT_COLOR = GREEN;                     // 设置状态信息为绿色，表示系统正常
-		BACK_COLOR = BLACK;                      // 背景保持黑色，与主页面一致
-		
-		/*
-		 * sprintf格式化字符串原理：
-		 * - %s：字符串占位符，根据条件显示"OFF"或"ON"
-		 * - %d：整数占位符，显示亮度数值
-		 * - 三元运算符：led_status ? "OFF" : "ON" 实现状态文字切换
-		 * - 拼接结果：如"LED: ON  Brightness: 7/10"
-		 */
-		sprintf(str, "LED: %s  Brightness: %d/10", 
-				led_status ? "OFF" : "ON", led_brightness);
-		LCD_ShowString(10, 215, 240, 12, 12, str);  // 在屏幕底部显示状态信息
-	}
+	Lat_Trace_Mark(LAT_PT_DISPATCH);
+	LCD_Band_Begin();                        // 按键的全部显示为一帧，只发送有变化的区域
+	if(act->handler) act->handler(act->arg); // 执行按键功能（预留键无功能）
+	Update_LED_Display();                    // 重画模型值变化了的控件
+	Show_Key_Info_New(key);                  // 显示按键信息
+	LCD_Band_End();
+	SPI1_DMA_Notify(Lat_Lcd_Done, 0);        // 清屏/填充在DMA队列中发送，全部送出时记录LCD终点
+}
+
+// 串口命令处理函数
+// 功能：执行串口收到的一行命令（回车换行结束，由usart.c的接收中断收集到USART_RX_BUF）
+// 命令：lat       - 打印按键到显示的各阶段延迟和直方图
+//      lat reset - 清除延迟统计
+//      learn <键码> - 学习一个遥控器按键，绑定到键码（0~255，可用0x前缀写十六进制），对准接收头按两次
+//      learn cancel - 取消学习
+void Process_Uart_Command(void)
+{
+	u16 len;
+	char *end;
+	unsigned long cmd;
+	
+	if((USART_RX_STA & 0x8000) == 0) return;  // 尚未收到完整的一行
+	len = USART_RX_STA & 0x3FFF;
+	USART_RX_BUF[len] = 0;                    // 接收长度小于USART_REC_LEN，可以直接结尾
 	
-	// ========== LED控制页面详细显示模式 ==========
-	else if(current_page == 1)  // LED控制页面显示模式
+	if(strcmp((char *)USART_RX_BUF, "lat") == 0) Lat_Trace_Print();
+	else if(strcmp((char *)USART_RX_BUF, "lat reset") == 0) Lat_Trace_Reset();
+	else if(strcmp((char *)USART_RX_BUF, "learn cancel") == 0)
 	{
-		/*
-		 * LED控制页面显示特色：
-		 * - 颜色：黄色突出控制状态，在蓝色背景上醒目
-		 * - 内容：显示LED控制模式和当前状态
-		 * - 层次：两行信息，第一行显示控制模式，第二行显示当前状态
-		 */
-		POINT_COLOR = YELLOW;                    // 黄色字体在蓝色背景上形成鲜明对比
-		BACK_COLOR = BLUE;                       // 保持与页面背景一致的蓝色
-		
-		/*
-		 * LED控制模式显示逻辑：
-		 * - "ALL ON"：所有LED统一控制模式
-		 * - "SINGLE"：单个LED独立控制模式  
-		 * - all_leds_on变量：控制模式标志位
-		 */
-		sprintf(str, "LED0-7: %s", all_leds_on ? "ALL ON" : "SINGLE");
-		LCD_ShowString(10, 60, 240, 12, 12, str);  // Y=60位置显示控制模式
-		
-		/*
-		 * LED当前状态显示：
-		 * - 显示所有LED的总体开关状态
-		 * - 位置：紧接在控制模式下方
-		 */
-		sprintf(str, "Current: %s", led_status ? "OFF" : "ON");
-		LCD_ShowString(10, 75, 240, 12, 12, str);  // Y=75位置显示当前状态
+		Remote_Learn_Cancel();
+		printf("IR learn cancelled\r\n");
 	}
-	
-	// ========== 亮度控制页面可视化显示模式 ==========
-	else if(current_page == 2)  // 亮度控制页面显示模式
+	else if(strncmp((char *)USART_RX_BUF, "learn ", 6) == 0)
 	{
-		/*
-		 * 亮度页面显示设计亮点：
-		 * 1. 数值显示：直观的数字亮度等级
-		 * 2. 进度条：10段式图形化亮度指示
-		 * 3. 颜色对比：黑色文字在绿色背景上清晰可见
-		 */
-		POINT_COLOR = BLACK;                     // 黑色字体在绿色背景上清晰易读
-		BACK_COLOR = GREEN;                      // 保持绿色背景的主题一致性
-		
-		/*
-		 * 亮度数值显示：
-		 * - 位置：X=150，与"Current Level:"标签对齐
-		 * - 格式：当前亮度/最大亮度 (如"7 / 10")
-		 * - 字体：16像素，比标签更大，突出重要性
-		 */
-		sprintf(str, "%d / 10", led_brightness);
-		LCD_ShowString(150, 40, 240, 16, 16, str);  // 显示亮度数值
-		
-		// ========== 亮度进度条绘制算法 ==========
-		/*
-		 * 10段式亮度进度条设计：
-		 * - 总长度：200像素 (10段 × 20像素/段)
-		 * - 每段宽度：15像素 (20像素间距 - 5像素间隔)
-		 * - 高度：15像素 (Y=70到Y=85)
-		 * - 颜色：白色表示已点亮段，黑色表示未点亮段
-		 * - 位置：水平居中，垂直在数值下方
-		 */
-		for(int i = 0; i < 10; i++)  // 循环绘制10个亮度段
+		cmd = strtoul((char *)USART_RX_BUF + 6, &end, 0);
+		if(end == (char *)USART_RX_BUF + 6 || *end != 0 || cmd > 0xFF)
+			printf("Usage: learn <0-255> | learn cancel\r\n");
+		else
 		{
-			/*
-			 * LCD_Fill()函数详解：
-			 * 参数1-2：起始坐标 (x1, y1)
-			 * 参数3-4：结束坐标 (x2, y2) 
-			 * 参数5：填充颜色
-			 * 功能：在指定矩形区域填充指定颜色
-			 * 
-			 * 坐标计算：
-			 * - X起始：10 + i*20 (每段间隔20像素)
-			 * - X结束：25 + i*20 (每段宽度15像素)
-			 * - Y固定：70-85 (高度15像素)
-			 */
-			if(i < led_brightness)  // 判断当前段是否应该点亮
-			{
-				// 当前亮度范围内的段显示为白色（点亮状态）
-				LCD_Fill(10 + i*20, 70, 25 + i*20, 85, WHITE);
-			}
-			else
-			{
-				// 超出当前亮度的段显示为黑色（熄灭状态）
-				LCD_Fill(10 + i*20, 70, 25 + i*20, 85, BLACK);
-			}
+			Remote_Learn_Start((u16)cmd);             // 结果由主循环的Remote_Learn_Poll()打印
+			printf("IR learn: press the remote key twice (key 0x%02X)\r\n", (unsigned)cmd);
 		}
-		/*
-		 * 进度条视觉效果：
-		 * 亮度0：全黑 ■■■■■■■■■■
-		 * 亮度5：半亮 □□□□□■■■■■  
-		 * 亮度10：全亮 □□□□□□□□□□
-		 * 实时更新：每次亮度改变都会重新绘制
-		 */
 	}
+	else printf("Unknown command: %s\r\n", USART_RX_BUF);
+	
+	USART_RX_STA = 0;                         // 允许接收下一行
 }
 
-// ==================== 红外遥控按键处理函数 ====================
-// 红外遥控按键处理主函数
-// 功能：根据接收到的红外按键值执行相应的控制功能
-// 参数：key - 红外遥控器按键对应的数值编码
-// 说明：每个按键对应不同的功能，实现LED控制、亮度调节、页面切换等
-void Process_Remote_Key(u8 key)
+// 按键手势处理函数
+// 功能：在按键本身的功能之后追加手势功能
+// 参数：key - 按键编码，gst - 手势（KEY_GST_xxx）
+// 说明：双击时第一次和第二次按下的功能都已执行（数字键切换了两次），双击再把结果改为只开这一路
+void Process_Key_Gesture(u8 key, u8 gst)
 {
-    switch(key)
-    {
-        // ========== 数字键0-7：独立LED控制 ==========
-        case 66:  // 数字键0 - 控制LED0
-            LED_Toggle(0); 
-            Show_Key_Info_New(key);
-            break;
-            
-        case 104: // 数字键1 - 控制LED1  
-            LED_Toggle(1);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 152: // 数字键2 - 控制LED2
-            LED_Toggle(2);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 176: // 数字键3 - 控制LED3
-            LED_Toggle(3);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 48:  // 数字键4 - 控制LED4
-            LED_Toggle(4);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 24:  // 数字键5 - 控制LED5
-            LED_Toggle(5);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 122: // 数字键6 - 控制LED6
-            LED_Toggle(6);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 16:  // 数字键7 - 控制LED7
-            LED_Toggle(7);
-            Show_Key_Info_New(key);
-            break;
-            
-        case 56:  // 数字键8 - 显示按键信息（功能预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        // ========== 系统控制功能键 ==========
-        case 90:  // 数字键9 - 控制所有LED同时切换
-            LED_All_Toggle();
-            Show_Key_Info_New(key);
-            break;
-            
-        case 82:  // DELETE键 - 关闭所有LED
-            LED_All_Set(1);               // 1表示关闭所有LED
-            Show_Key_Info_New(key);
-            break;
-            
-        case 162: // POWER键 - 切换显示页面模式
-            System_Mode_Switch();
-            Show_Key_Info_New(key);
-            break;
-            
-        // ========== 亮度调节功能键 ==========
-        case 98:  // UP键 - 增加LED亮度（支持长按连续调节）
-            LED_Brightness_Up();
-            Show_Key_Info_New(key);
-            break;
-            
-        case 168: // DOWN键 - 降低LED亮度（支持长按连续调节）
-            LED_Brightness_Down();
-            Show_Key_Info_New(key);
-            break;
-            
-        // ========== 其他功能键（预留扩展功能） ==========
-        case 34:  // LEFT键 - 功能C（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        case 2:   // PLAY键 - 功能D（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        case 194: // RIGHT键 - 功能E（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        case 144: // VOL+键 - 功能F（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        case 224: // VOL-键 - 功能G（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        case 226: // ALIENTEK键 - 功能H（预留）
-            Show_Key_Info_New(key);
-            break;
-            
-        default:  // 未定义按键，不执行任何操作
-            break;
-    }
+	const Key_Action *act = &key_table[key];
+	
+	printf("Gesture: %s %s\r\n", act->name ? act->name : "?", Key_Gesture_Name(gst));
+	LCD_Band_Begin();                        // 手势的显示为一帧
+	if(gst == KEY_GST_DOUBLE && act->handler == LED_Toggle)      // 数字键双击：只开这一路LED
+	{
+		LED_All_Set(1);
+		LED_Toggle(act->arg);
+		Update_LED_Display();
+	}
+	else if(gst == KEY_GST_HOLD && key == KEY_POWER)              // POWER长按：回到主页面
+	{
+		Display_Main_Page();
+	}
+	else if(gst == KEY_GST_HOLD_END && act->repeat != KEY_RPT_NONE)  // 亮度长按调节结束
+	{
+		printf("Brightness: %d\r\n", led_brightness_level);
+	}
+	LCD_Band_End();
 }
 
+// 映射表适配函数：把无参数的控制函数包装成统一的Key_Handler形式
+static void Key_All_Toggle(u8 arg)  { (void)arg; LED_All_Toggle(); }
+static void Key_All_Off(u8 arg)     { (void)arg; LED_All_Set(1); }     // 1表示关闭所有LED
+static void Key_Mode_Switch(u8 arg) { (void)arg; System_Mode_Switch(); }
+static void Key_Bright_Up(u8 arg)   { (void)arg; LED_Brightness_Up(); }
+static void Key_Bright_Down(u8 arg) { (void)arg; LED_Brightness_Down(); }
+
 // ==================== 实验21兼容接口函数组 ====================
 
 // 单个LED状态切换函数
@@ -695,33 +589,16 @@ void System_Mode_Switch(void)
 // 位置：屏幕底部白色背景区域，红色字体
 void Show_Key_Info_New(u8 key)
 {
-	char str[50];  // 字符串缓冲区，存储格式化后的按键信息
+	char str[20];  // 仅未登记按键需要临时格式化
+	const char *label = key_table[key].label;  // 登记按键直接使用编译期拼好的文本
+	
 	POINT_COLOR = RED;                       // 设置字体颜色为红色，突出按键信息
 	BACK_COLOR = WHITE;                      // 设置背景颜色为白色，形成强烈对比
 	LCD_Fill(10, 225, 230, 240, WHITE);     // 清除按键信息显示区域
-	switch(key)
+	if(label == 0)                           // 未定义的按键
 	{
-		case 162: sprintf(str, "Key:0x%02X POWER", key); break;    // POWER键：页面切换功能
-		case 66:  sprintf(str, "Key:0x%02X NUM0", key); break;     // 数字0：LED0控制
-		case 104: sprintf(str, "Key:0x%02X NUM1", key); break;     // 数字1：LED1控制
-		case 152: sprintf(str, "Key:0x%02X NUM2", key); break;     // 数字2：LED2控制
-		case 176: sprintf(str, "Key:0x%02X NUM3", key); break;     // 数字3：LED3控制
-		case 48:  sprintf(str, "Key:0x%02X NUM4", key); break;     // 数字4：LED4控制
-		case 24:  sprintf(str, "Key:0x%02X NUM5", key); break;     // 数字5：LED5控制
-		case 122: sprintf(str, "Key:0x%02X NUM6", key); break;     // 数字6：LED6控制
-		case 16:  sprintf(str, "Key:0x%02X NUM7", key); break;     // 数字7：LED7控制
-		case 56:  sprintf(str, "Key:0x%02X NUM8", key); break;     // 数字8：信息显示功能
-		case 90:  sprintf(str, "Key:0x%02X NUM9", key); break;     // 数字9：所有LED切换
-		case 98:  sprintf(str, "Key:0x%02X UP", key); break;       // UP键：亮度增加
-		case 168: sprintf(str, "Key:0x%02X DOWN", key); break;     // DOWN键：亮度降低
-		case 34:  sprintf(str, "Key:0x%02X LEFT", key); break;     // LEFT键：预留功能
-		case 194: sprintf(str, "Key:0x%02X RIGHT", key); break;    // RIGHT键：预留功能
-		case 2:   sprintf(str, "Key:0x%02X PLAY", key); break;     // PLAY键：预留功能
-		case 144: sprintf(str, "Key:0x%02X VOL+", key); break;     // 音量+：预留功能
-		case 224: sprintf(str, "Key:0x%02X VOL-", key); break;     // 音量-：预留功能
-		case 82:  sprintf(str, "Key:0x%02X DELETE", key); break;   // DELETE键：关闭所有LED
-		case 226: sprintf(str, "Key:0x%02X ALIENTEK", key); break; // ALIENTEK键：预留功能
-		default:  sprintf(str, "Key:0x%02X Unknown", key); break; // 未定义的按键
+		sprintf(str, "Key:0x%02X Unknown", key);
+		label = str;
 	}
-	LCD_ShowString(10, 227, 220, 12, 12, str);  // 在屏幕底部显示按键信息
+	LCD_ShowString(10, 227, 220, 12, 12, (char*)label);  // 在屏幕底部显示按键信息
 }
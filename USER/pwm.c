@@ -1,5 +1,6 @@
 #include "pwm.h"
 #include "led.h"
+#include "lat_trace.h"
 
 //////////////////////////////////////////////////////////////////////////////////	 
 // 红外遥控LED调光系统 - PWM驱动模块
@@ -113,6 +114,8 @@ void Software_PWM_LED_Control(void)
             }
         }
     }
+    
+    Lat_Trace_Mark(LAT_PT_PWM);                 // 延迟追踪：新的LED状态和占空比已输出
 }
 
 // 定时器2中断服务函数（软件PWM的核心）
@@ -15,6 +15,7 @@
 //////////////////////////////////////////////////////////////////////////////////
 
 void TIM1_PWM_Init(u16 arr,u16 psc);
+void TIM2_PWM_Init(u16 arr,u16 psc);
 void LED_PWM_Set_Duty(u8 led_num, u16 duty);
 void LED_Brightness_Set(u8 brightness_level);
 void Software_PWM_LED_Control(void);
@@ -1,11 +1,17 @@
 #include "remote.h"
+#include "lat_trace.h"
 #include "delay.h"
+#include "stdio.h"
+#include "string.h"
 //////////////////////////////////////////////////////////////////////////////////	 
 // 红外遥控LED调光系统 - 红外遥控驱动模块
-// 功能说明：基于NEC协议的红外遥控信号接收和解码
+// 功能说明：红外遥控信号接收和多协议解码（NEC/扩展NEC/RC5/RC6/SIRC/Samsung）
 // 硬件接口：PB0引脚连接红外接收头（TIM3_CH3输入捕获）
 // 解码原理：通过定时器输入捕获测量红外信号的时间间隔
-//          根据NEC协议的时间标准判断数据位"0"和"1"
+//          捕获值由DMA写入环形缓冲区，主循环中批量解码
+//          电平段送入ir_decode.c中的表驱动解码器，各协议并行解码
+//          解码在PendSV中断（最低优先级，SysTick每1ms挂起一次）中进行，结果写入按键事件队列
+//          解码前去掉干扰产生的毛刺，边沿风暴时暂时关闭该通道的捕获
 // 开发板：ALIENTEK STM32F4 NANO
 // 技术支持：www.openedv.com
 // 开发团队：ALIENTEK团队
@@ -15,196 +21,1032 @@
 
 TIM_HandleTypeDef TIM3_Handler;      // 定时器3句柄（用于输入捕获）
 
+// ==================== 捕获通道硬件资源 ====================
+// 下标为TIM3通道号（0~3 = CH1~CH4），DMA请求均为DMA1通道5
+typedef struct
+{
+	u32 tim_channel;            // TIM_CHANNEL_x
+	u32 dma_req;                // TIM_DMA_CCx（捕获事件触发DMA请求）
+	u16 dma_id;                 // TIM_DMA_ID_CCx（TIM句柄中DMA句柄的下标）
+	u16 pin;                    // GPIOB引脚（复用为TIM3通道）
+	DMA_Stream_TypeDef *stream; // DMA1数据流
+	IRQn_Type irq;              // DMA数据流中断号
+	volatile u32 *ccr;          // 捕获寄存器（DMA源地址）
+} IR_Rx_Hw;
+
+static const IR_Rx_Hw ir_rx_hw[IR_RX_MAX]=
+{
+	{TIM_CHANNEL_1,TIM_DMA_CC1,TIM_DMA_ID_CC1,GPIO_PIN_4,DMA1_Stream4,DMA1_Stream4_IRQn,&TIM3->CCR1},  // PB4
+	{TIM_CHANNEL_2,TIM_DMA_CC2,TIM_DMA_ID_CC2,GPIO_PIN_5,DMA1_Stream5,DMA1_Stream5_IRQn,&TIM3->CCR2},  // PB5
+	{TIM_CHANNEL_3,TIM_DMA_CC3,TIM_DMA_ID_CC3,GPIO_PIN_0,DMA1_Stream7,DMA1_Stream7_IRQn,&TIM3->CCR3},  // PB0
+	{TIM_CHANNEL_4,TIM_DMA_CC4,TIM_DMA_ID_CC4,GPIO_PIN_1,DMA1_Stream2,DMA1_Stream2_IRQn,&TIM3->CCR4},  // PB1
+};
+
+// ==================== 接收头（每个捕获通道一个） ====================
+// 各通道在上升沿和下降沿都触发捕获，由DMA把CCRx搬运到该通道的环形缓冲区，
+// CPU不再为每个边沿进入中断，只在半满/全满时进一次DMA中断（接收头增多时中断耗时不随边沿数增加）。
+// 解码由Remote_Poll()在PendSV中对各接收头依次批量完成，每个接收头一个独立的解码器。
+typedef struct
+{
+	u16 buf[IR_CAP_BUF_LEN];    // 边沿时间戳环形缓冲区（1us/计数，TIM3低16位）
+	vu32 halves;                // DMA已完成的半缓冲区个数（半满/全满中断累加）
+	u32 tail;                   // 消费者已处理的边沿总数
+	u32 last_us;                // 上一个边沿的32位时间戳（us）
+	u32 idle_us;                // 判定线路空闲的时间（us）
+	u8  level;                  // 当前线路电平（接收头空闲为高电平）
+	u8  idle;                   // 线路空闲标志（1=空闲，下一个边沿为引导码起点）
+	u8  pend;                   // 1=有一个待定的电平段（后一个电平段可能是毛刺，暂不送入解码器）
+	u8  pend_level;             // 待定电平段的电平
+	u32 pend_us;                // 待定电平段的开始时间（结束时间为last_us）
+	u32 storm_us;               // 边沿计数窗口的开始时间（us）
+	u16 storm_n;                // 窗口内的边沿数
+	u8  masked;                 // 1=边沿风暴，捕获已关闭
+	u32 mask_us;                // 关闭捕获的时间（us）
+	u8  ch;                     // TIM3通道号（0~3）
+	const IR_Rx_Hw *hw;         // 硬件资源
+	IR_Decoder dec;             // 多协议解码器（NEC/扩展NEC/RC5/RC6/SIRC/Samsung）
+	DMA_HandleTypeDef dma;      // 捕获DMA句柄
+	u16 raw[IR_LEARN_MAX_SEG];  // 本次发射的电平段宽度（us，学习和信号库匹配用）
+	u8  raw_n;                  // 已记录的电平段个数
+	u8  raw_full;               // 1=电平段超过IR_LEARN_MAX_SEG个
+	u8  raw_dec;                // 1=本次发射已由协议表解码
+	s8  lib_last;               // 上一次匹配的信号库下标（判断重复）
+	u32 lib_us;                 // 上一次匹配的时间（us）
+} IR_Rx;
+
+static IR_Rx ir_rx[IR_RX_COUNT];        // 按通道号从小到大排列的接收头
+static IR_Rx *ir_rx_of_ch[IR_RX_MAX];   // 通道号 -> 接收头（未接接收头的通道为0）
+static u32 ir_poll_us=0;                // 上一次Remote_Poll()的时间（us）
+static u32 ir_key_us=0;                 // 最近一次收到完整数据或重复码的时间（us）
+
+// ==================== 32位微秒时基 ====================
+// TIM3自由计数（ARR=0xFFFF），更新中断每65.536ms累加一次高16位，
+// 与CNT或捕获值组合成32位单调递增的us时间戳（约71分钟回绕，差值运算不受影响）。
+// 各捕获通道共用该时基，捕获通道和解码路径中不再写计数器。
+static vu32 ir_tim_ovf=0;               // TIM3溢出次数（时间戳高16位）
+static vu8 ir_ready=0;                  // 1=Remote_Init()已完成，PendSV中可以开始解码
+static IR_Frame   ir_frame;             // 当前按住的按键对应的帧
+static u8  ir_held=0;                   // 1=按键按住（尚未产生松开事件）
+static u8  ir_evt_rx=0;                 // 当前按键事件的来源接收头（通道号）
+static u8  ir_evt_rx_mask=0;            // 当前按键事件收到该帧的接收头
+
+// ==================== 多接收头合并 ====================
+// 同一次发射会被多个接收头各解出一次：第一个解出的帧进入等待，IR_RX_MERGE_US内其他接收头
+// 解出的同一帧只更新来源（取jitter最小者）和接收头掩码；全部接收头都已收到或等待超时后产生事件。
+// 已发出的帧保留到窗口结束，迟到的同一帧直接丢弃。只有一个接收头时不等待。
+#define IR_PEND_NONE    0       // 无
+#define IR_PEND_WAIT    1       // 等待其他接收头
+#define IR_PEND_SENT    2       // 已产生事件
+
+static IR_Frame ir_pend;                // 等待合并的帧（当前质量最好的接收头的解码结果）
+static u32 ir_pend_us=0;                // 该帧最后一个电平段的开始时间（第一个解出该帧的接收头）
+static u32 ir_pend_poll=0;              // 开始等待的时间（Remote_Poll()时间，用于等待超时）
+static u8  ir_pend_rx=0;                // 当前选中的接收头
+static u8  ir_pend_mask=0;              // 已收到该帧的接收头
+static u8  ir_pend_state=IR_PEND_NONE;
+
+// ==================== 红外学习 ====================
+// 录制在PendSV中完成，写Flash在主循环的Remote_Learn_Poll()中完成
+static vu8 ir_learn_state=IR_LEARN_IDLE;
+static u16 ir_learn_cmd=0;              // 学习完成后绑定的命令
+static u32 ir_learn_us=0;               // 第一次录制的时间（us）
+static IR_Signal ir_learn_sig;          // 录制的信号
+
+// ==================== 按键事件队列 ====================
+// 单生产者（PendSV中的Remote_Poll）/单消费者（主循环中的Remote_Get_Event）环形队列
+// 生产者只写ir_evt_head，消费者只写ir_evt_tail，无需关中断
+// 下标自由累加，用(u8)(head-tail)计算队列长度，要求IR_EVT_QUEUE_LEN为2的幂且不超过128
+static IR_Event ir_evt_buf[IR_EVT_QUEUE_LEN];
+static vu8  ir_evt_head=0;              // 写位置（仅生产者修改）
+static vu8  ir_evt_tail=0;              // 读位置（仅消费者修改）
+static vu32 ir_evt_dropped=0;           // 队列满时丢弃的事件数
+
+// ==================== 地址允许列表 ====================
+// 在PendSV中查找，主循环中修改时短暂关中断
+static u32 ir_addr8[8];                     // 标准NEC 8位地址位图
+static u32 ir_addr_key[IR_ADDR_HASH_LEN];   // 其他协议的（协议，地址）散列表，0=空槽位
+static u8  ir_addr_n=0;                     // 散列表中的地址个数
+static u32 ir_addr_any=0;                   // 不过滤地址的协议（IR_PROTO_MASK组合）
+
+// ==================== 接收统计 ====================
+// 解码统计在各接收头的dec.stats中，这里只记录驱动层的超时、溢出、合并和中断耗时
+static u32 ir_addr_reject=0;            // 地址过滤丢弃的帧
+static u32 ir_release_timeouts=0;       // 松开超时次数
+static u32 ir_idle_timeouts=0;          // 帧接收中途空闲超时次数
+static u32 ir_overruns=0;               // 重新同步次数
+static u32 ir_glitches=0;               // 去掉的毛刺
+static u32 ir_storms=0;                 // 边沿风暴屏蔽次数
+static u32 ir_merged=0;                 // 被合并掉的其他接收头的同一帧
+static u32 ir_learned=0;                // 与信号库匹配的发射
+static u32 ir_unknown=0;                // 未解码也未匹配的发射
+static u32 ir_rx_frames[IR_RX_MAX];     // 各接收头解出的帧
+static u32 ir_rx_best[IR_RX_MAX];       // 各接收头被选为事件来源的次数
+static IR_Cycle_Stat ir_prof_capture;   // 捕获DMA中断耗时（各通道合计）
+static IR_Cycle_Stat ir_prof_update;    // TIM3更新中断耗时
+static IR_Cycle_Stat ir_prof_poll;      // Remote_Poll()耗时
+
+#if IR_PROFILE
+#define IR_PROF_BEGIN()     u32 prof_start=DWT->CYCCNT
+#define IR_PROF_END(stat)   Remote_Prof_Add(&(stat),DWT->CYCCNT-prof_start)
+#else
+#define IR_PROF_BEGIN()
+#define IR_PROF_END(stat)
+#endif
+
+static void Remote_DMA_HalfCplt(DMA_HandleTypeDef *hdma);
+static void Remote_DMA_Cplt(DMA_HandleTypeDef *hdma);
+static void Remote_Prof_Add(IR_Cycle_Stat *st,u32 cycles);
+
 //红外遥控初始化
-//设置IO以及TIM3_CH3输入捕获
+//设置IO以及TIM3各接收通道的输入捕获（双边沿捕获，DMA循环搬运）
 void Remote_Init(void)
 {  
-    TIM_IC_InitTypeDef TIM3_CH3Config;  
+    TIM_IC_InitTypeDef TIM3_ICConfig;  
+    IR_Rx *rx;
+    u8 ch,n=0;
+    
+    for(ch=0;ch<IR_RX_MAX;ch++)                          //按IR_RX_CH_MASK分配接收头
+    {
+        if(!(IR_RX_CH_MASK&(1<<ch))) continue;
+        rx=&ir_rx[n++];
+        rx->ch=ch;
+        rx->hw=&ir_rx_hw[ch];
+        rx->halves=0;
+        rx->tail=0;
+        rx->level=1;
+        rx->idle=1;
+        rx->pend=0;
+        rx->storm_n=0;
+        rx->masked=0;
+        rx->raw_n=0;
+        rx->raw_full=0;
+        rx->raw_dec=0;
+        rx->lib_last=-1;
+        IR_Decoder_Init(&rx->dec);                       //多协议解码器，默认使能全部协议
+        ir_rx_of_ch[ch]=rx;
+    }
+    Remote_Reset_Stats();
+    Remote_Addr_Clear();
+    Remote_Addr_Allow(IR_PROTO_NEC,REMOTE_ID);           //默认只接受本机遥控器的标准NEC帧
+    IR_Lib_Init();                                       //从Flash加载学习的信号
+#if IR_PROFILE
+    CoreDebug->DEMCR|=CoreDebug_DEMCR_TRCENA_Msk;        //使能DWT
+    DWT->CYCCNT=0;
+    DWT->CTRL|=DWT_CTRL_CYCCNTENA_Msk;                   //启动周期计数器，用于测量中断耗时
+#endif
     
     TIM3_Handler.Instance=TIM3;                          //通用定时器3
     TIM3_Handler.Init.Prescaler=(96-1);                	 //预分频器,1M的计数频率,1us计1.
     TIM3_Handler.Init.CounterMode=TIM_COUNTERMODE_UP;    //向上计数器
-    TIM3_Handler.Init.Period=10000;                      //自动装载值
+    TIM3_Handler.Init.Period=0xFFFF;                     //自由计数，溢出由更新中断扩展为32位时基
     TIM3_Handler.Init.ClockDivision=TIM_CLOCKDIVISION_DIV1;//时钟分频因子
     HAL_TIM_IC_Init(&TIM3_Handler);
     
-    //初始化TIM3输入捕获参数
-    TIM3_CH3Config.ICPolarity=TIM_ICPOLARITY_RISING;    //上升沿捕获
-    TIM3_CH3Config.ICSelection=TIM_ICSELECTION_DIRECTTI;//映射到TI3上
-    TIM3_CH3Config.ICPrescaler=TIM_ICPSC_DIV1;          //配置输入分频,不分频
-    TIM3_CH3Config.ICFilter=0x03;                       //IC4F=0003 8个定时器时钟周期滤波
-    HAL_TIM_IC_ConfigChannel(&TIM3_Handler,&TIM3_CH3Config,TIM_CHANNEL_3);//配置TIM3通道3
-    HAL_TIM_IC_Start_IT(&TIM3_Handler,TIM_CHANNEL_3);   //开始捕获TIM3的通道3
-    __HAL_TIM_ENABLE_IT(&TIM3_Handler,TIM_IT_UPDATE);   //使能更新中断
+    //初始化TIM3输入捕获参数（各通道相同）
+    TIM3_ICConfig.ICPolarity=TIM_ICPOLARITY_BOTHEDGE;   //双边沿捕获，无需在中断中翻转极性
+    TIM3_ICConfig.ICSelection=TIM_ICSELECTION_DIRECTTI; //映射到各自的TIx上
+    TIM3_ICConfig.ICPrescaler=TIM_ICPSC_DIV1;           //配置输入分频,不分频
+    TIM3_ICConfig.ICFilter=0x03;                        //ICxF=0003 8个定时器时钟周期滤波
+    
+    for(n=0;n<IR_RX_COUNT;n++)
+    {
+        rx=&ir_rx[n];
+        HAL_TIM_IC_ConfigChannel(&TIM3_Handler,&TIM3_ICConfig,rx->hw->tim_channel);
+        
+        //启动捕获DMA：CCRx -> rx->buf，循环模式，半满/全满中断
+        rx->dma.XferHalfCpltCallback=Remote_DMA_HalfCplt;
+        rx->dma.XferCpltCallback=Remote_DMA_Cplt;
+        HAL_DMA_Start_IT(&rx->dma,(u32)rx->hw->ccr,(u32)rx->buf,IR_CAP_BUF_LEN);
+        __HAL_TIM_ENABLE_DMA(&TIM3_Handler,rx->hw->dma_req);         //CCx捕获事件触发DMA请求
+        HAL_TIM_IC_Start(&TIM3_Handler,rx->hw->tim_channel);         //开始捕获（不开捕获中断）
+    }
+    __HAL_TIM_CLEAR_FLAG(&TIM3_Handler,TIM_FLAG_UPDATE);
+    __HAL_TIM_ENABLE_IT(&TIM3_Handler,TIM_IT_UPDATE);   //使能更新中断（仅用于时基溢出计数）
+    ir_poll_us=Remote_Time_Us();
+    for(n=0;n<IR_RX_COUNT;n++) ir_rx[n].idle_us=ir_poll_us;
+    
+    HAL_NVIC_SetPriority(PendSV_IRQn,15,0);             //解码放在PendSV中，抢占优先级15（最低），不推迟TIM2/TIM3/DMA中断
+    ir_ready=1;                                         //SysTick每1ms挂起PendSV，开始调用Remote_Poll()
 }
 
-//定时器3底层驱动，时钟使能，引脚配置
+//定时器3底层驱动，时钟使能，引脚配置，各通道捕获DMA配置
 //此函数会被HAL_TIM_IC_Init()调用
 //htim:定时器3句柄
 void HAL_TIM_IC_MspInit(TIM_HandleTypeDef *htim)
 {
     GPIO_InitTypeDef GPIO_Initure;
+    IR_Rx *rx;
+    u8 n;
+    
     __HAL_RCC_TIM3_CLK_ENABLE();            //使能TIM3时钟
     __HAL_RCC_GPIOB_CLK_ENABLE();			//开启GPIOB时钟
+    __HAL_RCC_DMA1_CLK_ENABLE();            //使能DMA1时钟
 	
-    GPIO_Initure.Pin=GPIO_PIN_0;            //PB0
+    GPIO_Initure.Pin=0;
+    for(n=0;n<IR_RX_COUNT;n++) GPIO_Initure.Pin|=ir_rx[n].hw->pin;  //PB4/PB5/PB0/PB1中接了接收头的引脚
     GPIO_Initure.Mode=GPIO_MODE_AF_PP;  	 //复用推挽输出
     GPIO_Initure.Pull=GPIO_PULLUP;          //上拉
     GPIO_Initure.Speed=GPIO_SPEED_HIGH;     //高速
-	GPIO_Initure.Alternate=GPIO_AF2_TIM3;   //PB0复用为TIM3通道3
+	GPIO_Initure.Alternate=GPIO_AF2_TIM3;   //复用为TIM3通道
     HAL_GPIO_Init(GPIOB,&GPIO_Initure);
 
-    HAL_NVIC_SetPriority(TIM3_IRQn,1,3); 	//设置中断优先级，抢占优先级1，子优先级3
-    HAL_NVIC_EnableIRQ(TIM3_IRQn);       	//开启ITM3中断
-}
+    //TIM3_CHx DMA请求：DMA1通道5，数据流见ir_rx_hw[]
+    for(n=0;n<IR_RX_COUNT;n++)
+    {
+        rx=&ir_rx[n];
+        rx->dma.Instance=rx->hw->stream;
+        rx->dma.Init.Channel=DMA_CHANNEL_5;
+        rx->dma.Init.Direction=DMA_PERIPH_TO_MEMORY;           //外设到存储器
+        rx->dma.Init.PeriphInc=DMA_PINC_DISABLE;               //外设地址固定（CCRx）
+        rx->dma.Init.MemInc=DMA_MINC_ENABLE;                   //存储器地址递增
+        rx->dma.Init.PeriphDataAlignment=DMA_PDATAALIGN_HALFWORD;//16位捕获值
+        rx->dma.Init.MemDataAlignment=DMA_MDATAALIGN_HALFWORD;
+        rx->dma.Init.Mode=DMA_CIRCULAR;                        //循环模式，构成环形缓冲区
+        rx->dma.Init.Priority=DMA_PRIORITY_HIGH;
+        rx->dma.Init.FIFOMode=DMA_FIFOMODE_DISABLE;
+        HAL_DMA_Init(&rx->dma);
+        __HAL_LINKDMA(htim,hdma[rx->hw->dma_id],rx->dma);
 
-// ==================== 红外遥控解码状态变量 ====================
-// 红外遥控接收状态寄存器（8位状态标志）
-// 位7 [7]：收到引导码标志（1=已收到9ms+4.5ms引导码，0=未收到）
-// 位6 [6]：完整按键数据接收完成标志（1=完成，0=未完成）
-// 位5 [5]：保留位，暂未使用
-// 位4 [4]：上升沿捕获标记（1=已捕获上升沿，0=未捕获）
-// 位3-0 [3:0]：溢出计时器（计数定时器更新中断次数，用于超时检测）
-u8 	RmtSta=0;	  	  
+        HAL_NVIC_SetPriority(rx->hw->irq,1,3);  //设置中断优先级，抢占优先级1，子优先级3
+        HAL_NVIC_EnableIRQ(rx->hw->irq);        //开启DMA数据流中断（仅半满/全满）
+    }
+    
+    HAL_NVIC_SetPriority(TIM3_IRQn,1,3);         //设置中断优先级，抢占优先级1，子优先级3
+    HAL_NVIC_EnableIRQ(TIM3_IRQn);               //开启TIM3中断（仅更新中断，每65.536ms一次）
+}
 
-// NEC协议解码相关变量
-u16 Dval;		    // 下降沿时定时器的计数值（用于测量高电平持续时间）
-u32 RmtRec=0;	    // 红外接收到的完整32位数据（地址码+地址反码+命令码+命令反码）
-u8  RmtCnt=0;	    // 按键按下的次数计数器（用于连击检测） 
+// ==================== 兼容变量 ====================
+u8  RmtCnt=0;	    // 当前按键的重复次数（与事件中的repeat相同，保留给旧代码）
+static vu8 ir_held_key=0;  // 当前按住的按键命令码（0=无），供Remote_Scan()使用
 
 // ==================== 定时器中断服务函数 ====================
-// 定时器3中断服务程序（入口函数）
-// 功能：调用HAL库的通用中断处理函数，分发到具体的回调函数
+// 定时器3中断服务程序：只处理更新（溢出）中断，累加时基高16位
 void TIM3_IRQHandler(void)
 {
-	HAL_TIM_IRQHandler(&TIM3_Handler);  // 调用HAL库定时器通用中断处理函数
-} 
-
-// ==================== NEC协议解码核心：定时器更新中断回调 ====================
-// 定时器更新中断回调函数（超时检测和状态管理）
-// 功能：每10ms触发一次，用于检测红外信号接收超时和状态清理
-// 原理：NEC协议要求在特定时间内完成数据接收，超时则认为传输失败
-void HAL_TIM_PeriodElapsedCallback(TIM_HandleTypeDef *htim)
-{
-	if(htim->Instance==TIM3)  // 确认是定时器3触发的中断
-	{
- 		if(RmtSta&0x80)  // 检查是否已接收到引导码（位7=1）
-		{	
-			RmtSta&=~0X10;  // 清除上升沿捕获标记（位4=0）
-			
-			// 检查是否已完成一次完整的按键数据接收
-			if((RmtSta&0X0F)==0X00)  // 计时器为0，说明接收完成
-				RmtSta|=1<<6;  // 设置按键信息接收完成标志（位6=1）
-			
-			// 溢出计时器管理（防止长时间无信号导致状态锁定）
-			if((RmtSta&0X0F)<14)  // 计时器未达到最大值
-				RmtSta++;  // 计时器加1
-			else  // 计时器达到最大值，超时处理
+	IR_PROF_BEGIN();
+	
+	if(__HAL_TIM_GET_FLAG(&TIM3_Handler,TIM_FLAG_UPDATE))
+	{
+		__HAL_TIM_CLEAR_FLAG(&TIM3_Handler,TIM_FLAG_UPDATE);  // 清除中断标志
+		ir_tim_ovf++;
+	}
+	IR_PROF_END(ir_prof_update);
+}
+
+// 获取32位微秒时间戳（与捕获值同一时基）
+// 原理：溢出次数<<16 | CNT；若计数器已回绕而更新中断尚未执行（在更高优先级中断中调用），
+//      通过挂起的更新标志和CNT处于低半区来补偿
+//      溢出次数、CNT、更新标志在同一次循环中读取，期间更新中断执行过（溢出次数变化、标志被清除）则重读，
+//      补偿只作用于一致的快照；先读CNT后读标志，两次读取之间回绕时CNT在高半区，不会误补
+// 调用：任意上下文均可调用
+u32 Remote_Time_Us(void)
+{
+	u32 ovf,cnt;
+	u8 upd;
+	
+	do
+	{
+		ovf=ir_tim_ovf;
+		cnt=__HAL_TIM_GET_COUNTER(&TIM3_Handler);
+		upd=__HAL_TIM_GET_FLAG(&TIM3_Handler,TIM_FLAG_UPDATE);
+	}while(ovf!=ir_tim_ovf);
+	
+	if(upd&&cnt<0x8000) ovf++;  // 中断尚未到来，补上这次溢出
+	return (ovf<<16)|cnt;
+}
+
+// ==================== DMA中断服务函数 ====================
+// 各通道DMA数据流中断共用的处理（每半个缓冲区进入一次）
+static void Remote_DMA_IRQ(u8 ch)
+{
+	IR_PROF_BEGIN();
+	
+	HAL_DMA_IRQHandler(&ir_rx_of_ch[ch]->dma);  // 调用HAL库DMA通用中断处理函数
+	IR_PROF_END(ir_prof_capture);
+}
+
+#if IR_RX_CH_MASK&0x01
+void DMA1_Stream4_IRQHandler(void)      // TIM3_CH1
+{
+	Remote_DMA_IRQ(0);
+}
+#endif
+
+#if IR_RX_CH_MASK&0x02
+void DMA1_Stream5_IRQHandler(void)      // TIM3_CH2
+{
+	Remote_DMA_IRQ(1);
+}
+#endif
+
+#if IR_RX_CH_MASK&0x04
+void DMA1_Stream7_IRQHandler(void)      // TIM3_CH3
+{
+	Remote_DMA_IRQ(2);
+}
+#endif
+
+#if IR_RX_CH_MASK&0x08
+void DMA1_Stream2_IRQHandler(void)      // TIM3_CH4
+{
+	Remote_DMA_IRQ(3);
+}
+#endif
+
+// 由DMA句柄找到所属接收头
+static IR_Rx *Remote_Rx_Of(DMA_HandleTypeDef *hdma)
+{
+	u8 n;
+	
+	for(n=0;n<IR_RX_COUNT-1;n++)
+		if(&ir_rx[n].dma==hdma) break;
+	return &ir_rx[n];
+}
+
+// 半满/全满回调：只累加计数，供消费者计算写指针和检测溢出
+static void Remote_DMA_HalfCplt(DMA_HandleTypeDef *hdma)
+{
+	Remote_Rx_Of(hdma)->halves++;
+}
+
+static void Remote_DMA_Cplt(DMA_HandleTypeDef *hdma)
+{
+	Remote_Rx_Of(hdma)->halves++;
+}
+
+// 获取DMA已写入的边沿总数（生产者位置）
+// 原理：半缓冲区计数 + 当前半区内的偏移；若DMA已越过半区边界而中断尚未执行，
+//      通过写位置所在半区与计数奇偶性不一致来补偿
+static u32 Remote_Cap_Head(IR_Rx *rx)
+{
+	u32 halves,pos;
+	
+	do
+	{
+		halves=rx->halves;
+		pos=IR_CAP_BUF_LEN-__HAL_DMA_GET_COUNTER(&rx->dma);  // NDTR范围1~LEN，pos范围0~LEN-1
+	}while(halves!=rx->halves);
+	
+	if((pos>=IR_CAP_BUF_LEN/2)!=(halves&1)) halves++;  // 中断尚未到来，补上这一半
+	return halves*(IR_CAP_BUF_LEN/2)+(pos%(IR_CAP_BUF_LEN/2));
+}
+
+// ==================== 按键事件入队（生产者） ====================
+// 功能：把当前按住按键的一个事件写入队列，队列满时丢弃并计数
+// 参数：type    - IR_EVT_PRESS/IR_EVT_REPEAT/IR_EVT_RELEASE
+//      time_us - 事件时间（us）
+static void Remote_Push_Event(u8 type,u32 time_us)
+{
+	u8 head=ir_evt_head;
+	IR_Event *ev;
+	
+	if((u8)(head-ir_evt_tail)>=IR_EVT_QUEUE_LEN)  // 队列已满
+	{
+		ir_evt_dropped++;
+		return;
+	}
+	ev=&ir_evt_buf[head&(IR_EVT_QUEUE_LEN-1)];
+	ev->type=type;
+	ev->protocol=ir_frame.protocol;
+	ev->address=ir_frame.address;
+	ev->command=ir_frame.command;
+	ev->repeat=RmtCnt;
+	ev->rx=ir_evt_rx;
+	ev->rx_mask=ir_evt_rx_mask;
+	ev->time_us=time_us;
+	__DMB();                 // 事件内容写完后再发布写位置
+	ir_evt_head=head+1;
+}
+
+// ==================== 地址允许列表 ====================
+// 散列表的键：协议在高16位，地址在低16位（协议号从1开始，键不会为0）
+// 槽位：Fibonacci散列，取32位乘积的高IR_ADDR_HASH_BITS位
+#define IR_ADDR_KEY(p,a)    (((u32)(p)<<16)|(u16)(a))
+#define IR_ADDR_HASH(k)     ((u8)((u32)((k)*2654435761U)>>(32-IR_ADDR_HASH_BITS)))
+
+// 查找（协议，地址），返回所在槽位，不存在时返回遇到的第一个空槽位
+// 装填率不超过1/2，线性探测平均不到2次
+static u8 Remote_Addr_Slot(u32 key)
+{
+	u8 i=IR_ADDR_HASH(key);
+	
+	while(ir_addr_key[i]&&ir_addr_key[i]!=key)
+		i=(i+1)&(IR_ADDR_HASH_LEN-1);
+	return i;
+}
+
+// 帧地址是否被允许
+// 说明：标准NEC查8位位图，其他协议查（协议，地址）散列表，学习的信号不过滤
+static u8 Remote_Addr_Ok(const IR_Frame *f)
+{
+	if(f->protocol==IR_PROTO_LEARNED||(ir_addr_any&IR_PROTO_MASK(f->protocol))) return 1;
+	if(f->protocol==IR_PROTO_NEC)
+		return (ir_addr8[(f->address>>5)&7]>>(f->address&31))&1;
+	return ir_addr_key[Remote_Addr_Slot(IR_ADDR_KEY(f->protocol,f->address))]!=0;
+}
+
+// 清空地址允许列表，之后协议表中的协议都不接受，直到加入地址或设为不过滤
+void Remote_Addr_Clear(void)
+{
+	__disable_irq();
+	memset(ir_addr8,0,sizeof(ir_addr8));
+	memset(ir_addr_key,0,sizeof(ir_addr_key));
+	ir_addr_n=0;
+	ir_addr_any=0;
+	__enable_irq();
+}
+
+// 允许一个地址
+// 参数：protocol - IR_PROTO_NEC~IR_PROTO_SAMSUNG
+//      address  - 地址（标准NEC只取低8位）
+// 返回值：1=成功（含已存在），0=散列表已达IR_ADDR_MAX个或协议无效
+// 说明：同时取消该协议的“不过滤”
+u8 Remote_Addr_Allow(u8 protocol,u16 address)
+{
+	u32 key=IR_ADDR_KEY(protocol,address);
+	u8 i,ok=1;
+	
+	if(protocol<1||protocol>IR_PROTO_COUNT) return 0;
+	__disable_irq();
+	if(protocol==IR_PROTO_NEC)
+		ir_addr8[(address>>5)&7]|=1UL<<(address&31);
+	else
+	{
+		i=Remote_Addr_Slot(key);
+		if(!ir_addr_key[i])
+		{
+			if(ir_addr_n<IR_ADDR_MAX)
 			{
-				RmtSta&=~(1<<7);  // 清除引导码标志（位7=0）
-				RmtSta&=0XF0;     // 清空溢出计时器（位3-0=0）
-			}						 	   	
-		}	
+				ir_addr_key[i]=key;
+				ir_addr_n++;
+			}
+			else ok=0;
+		}
+	}
+	if(ok) ir_addr_any&=~IR_PROTO_MASK(protocol);
+	__enable_irq();
+	return ok;
+}
+
+// 该协议的地址不过滤（已加入的地址保留，再调用Remote_Addr_Allow()恢复过滤）
+void Remote_Addr_Allow_Any(u8 protocol)
+{
+	if(protocol<1||protocol>IR_PROTO_COUNT) return;
+	__disable_irq();
+	ir_addr_any|=IR_PROTO_MASK(protocol);
+	__enable_irq();
+}
+
+// 用列表替换地址允许列表（例如多款遥控器的地址表）
+// 参数：list - 地址列表，n - 个数
+// 返回值：成功加入的个数
+// 说明：列表中没有某一协议的地址时，该协议的帧都不接受
+u8 Remote_Addr_Load(const IR_Addr *list,u8 n)
+{
+	u8 i,ok=0;
+	
+	Remote_Addr_Clear();
+	for(i=0;i<n;i++) ok+=Remote_Addr_Allow(list[i].protocol,list[i].address);
+	return ok;
+}
+
+// ==================== 按键事件产生 ====================
+// 功能：把合并后的等待帧转换为按下/重复事件
+// 说明：只接受地址允许列表中的（协议，地址），学习的信号不做限制
+static void Remote_Emit(void)
+{
+	const IR_Frame *f=&ir_pend;
+	u32 t=ir_pend_us;
+	
+	ir_pend_state=IR_PEND_SENT;
+	if(!Remote_Addr_Ok(f))                  // 非本机遥控器
+	{
+		ir_addr_reject++;
+		return;
+	}
+	ir_rx_best[ir_pend_rx]++;
+	
+	if(ir_held&&f->repeat&&f->protocol==ir_frame.protocol&&
+	   f->address==ir_frame.address&&f->command==ir_frame.command)
+	{
+		if(RmtCnt<0xFF) RmtCnt++;               // 重复码或同码连发：按键重复次数加1
+		ir_evt_rx=ir_pend_rx;
+		ir_evt_rx_mask=ir_pend_mask;
+		Remote_Push_Event(IR_EVT_REPEAT,t);
+	}
+	else
+	{
+		if(ir_held) Remote_Push_Event(IR_EVT_RELEASE,t);  // 未松开就换了按键：先结束上一个
+		ir_frame=*f;
+		RmtCnt=0;
+		ir_held=1;
+		ir_held_key=(u8)f->command;
+		ir_evt_rx=ir_pend_rx;
+		ir_evt_rx_mask=ir_pend_mask;
+		Remote_Push_Event(IR_EVT_PRESS,t);
+		Lat_Trace_Frame(t,Remote_Time_Us());    // 延迟追踪起点：帧的最后一个电平段
+	}
+	ir_key_us=t;                   // 重新开始松开超时计时
+}
+
+// ==================== 多接收头合并 ====================
+// 功能：一个接收头解出一帧，与等待中的帧合并或开始新的等待
+// 参数：rx - 解出该帧的接收头
+//      f  - 解码结果
+//      t  - 帧最后一个电平段的开始时间（us）
+// 说明：帧可能在下一帧的第一个边沿处完成，也可能在空闲超时时完成，不同接收头的边沿相差几us
+//      就可能分别落在这两种情况，所以用最后一个电平段的开始时间（帧的实际结束边沿）比较
+static void Remote_Merge(const IR_Rx *rx,const IR_Frame *f,u32 t)
+{
+	s32 dt=(s32)(t-ir_pend_us);
+	u8 bit=1<<rx->ch;
+	
+	if(ir_pend_state!=IR_PEND_NONE&&!(ir_pend_mask&bit)&&dt<=IR_RX_MERGE_US&&dt>=-IR_RX_MERGE_US&&
+	   f->protocol==ir_pend.protocol&&f->address==ir_pend.address&&
+	   f->command==ir_pend.command)
+	{
+		u8 rpt=ir_pend.repeat|f->repeat;          // 漏收上一帧的接收头会把重复帧当成新帧
+		
+		ir_merged++;                               // 其他接收头收到的同一帧
+		ir_pend_mask|=bit;
+		if(ir_pend_state!=IR_PEND_WAIT) return;    // 事件已产生，迟到的重复帧丢弃
+		if(f->jitter<ir_pend.jitter)               // 信号质量更好的接收头
+		{
+			ir_pend=*f;
+			ir_pend_rx=rx->ch;
+		}
+		ir_pend.repeat=rpt;
+		if(ir_pend_mask==IR_RX_CH_MASK) Remote_Emit();  // 全部接收头都已收到，不必再等
+		return;
+	}
+	
+	if(ir_pend_state==IR_PEND_WAIT) Remote_Emit();  // 另一帧到来：先产生等待中的帧的事件
+	ir_pend=*f;
+	ir_pend_us=t;
+	ir_pend_poll=ir_poll_us;
+	ir_pend_rx=rx->ch;
+	ir_pend_mask=bit;
+	ir_pend_state=IR_PEND_WAIT;
+	if(ir_pend_mask==IR_RX_CH_MASK) Remote_Emit();  // 只有一个接收头：不等待
+}
+
+// ==================== 解码核心：单个电平段处理 ====================
+// 功能：把一个接收头的一个完整电平段送入该接收头的解码器，解出帧后送去合并
+// 参数：rx    - 接收头
+//      level - 刚结束的电平（1=高电平，即载波间隙；0=低电平，即载波）
+//      start - 该电平段的开始时间（us）
+//      dur   - 该电平持续时间（us），线路空闲时为已经过的空闲时长
+// 返回值：1=解码出一帧，0=无
+// 说明：各协议的时序窗口见ir_decode.c中的ir_protocols[]
+static u8 Remote_Decode(IR_Rx *rx,u8 level,u32 start,u32 dur)
+{
+	IR_Frame f;
+	
+	if(!IR_Decoder_Feed(&rx->dec,!level,dur,&f)) return 0;
+	ir_rx_frames[rx->ch]++;
+	rx->raw_dec=1;
+	Remote_Merge(rx,&f,start);
+	return 1;
+}
+
+// ==================== 原始波形：学习与信号库匹配 ====================
+// 记录一个电平段（从载波开始，超过IR_LEARN_GAP_US的间隔不记录）
+static void Remote_Raw_Add(IR_Rx *rx,u32 dur)
+{
+	if(rx->raw_n<IR_LEARN_MAX_SEG) rx->raw[rx->raw_n++]=(dur>0xFFFF)?0xFFFF:(u16)dur;
+	else rx->raw_full=1;
+}
+
+// 学习：录制一次发射，与上一次录制的发射相同则完成
+// 说明：同一次发射会被多个接收头收到，第二次录制必须来自IR_RX_MERGE_US之后的另一次发射
+static void Remote_Learn_Capture(const IR_Rx *rx,const IR_Signal *sig,u8 n,u32 t)
+{
+	if(ir_learn_state==IR_LEARN_CONFIRM)
+	{
+		if(t-ir_learn_us<=IR_RX_MERGE_US) return;
+		if(IR_Signal_Match(&ir_learn_sig,rx->raw,n,0))
+		{
+			ir_learn_state=IR_LEARN_DONE;
+			return;
+		}
 	}
+	ir_learn_sig=*sig;               // 第一次，或与上一次不同：重新开始确认
+	ir_learn_us=t;
+	ir_learn_state=IR_LEARN_CONFIRM;
 }
 
-// ==================== NEC协议解码核心：输入捕获中断回调 ====================
-// 定时器输入捕获中断回调函数（NEC协议解码的核心逻辑）
-// 功能：捕获红外信号的上升沿和下降沿，通过测量时间间隔解码NEC协议
-// 原理：NEC协议通过不同的高电平持续时间来表示数据位"0"和"1"
-//      数据位"0": 高电平560μs  数据位"1": 高电平1680μs
-//      引导码: 高电平9ms + 低电平4.5ms
-void HAL_TIM_IC_CaptureCallback(TIM_HandleTypeDef *htim)
+// 一次发射结束：协议表未能解码的发射用于学习，或与信号库匹配产生按键事件
+// 参数：t - 发射最后一个边沿的时间（与协议帧的合并时间含义相同）
+static void Remote_Burst_End(IR_Rx *rx,u32 t)
 {
-	if(htim->Instance==TIM3)  // 确认是定时器3的输入捕获中断
+	IR_Signal sig;
+	IR_Frame f;
+	u16 jitter;
+	u8 n=rx->raw_n,skip=rx->raw_dec||rx->raw_full;
+	s8 k;
+	
+	rx->raw_n=0;
+	rx->raw_full=0;
+	rx->raw_dec=0;
+	if(skip||n<IR_LEARN_MIN_SEG) return;          // 已解码、过长，或是噪声/重复码
+	
+	if(!IR_Signal_Encode(rx->raw,n,&sig))
+	{
+		ir_unknown++;
+		return;
+	}
+	if(ir_learn_state==IR_LEARN_WAIT||ir_learn_state==IR_LEARN_CONFIRM)
+	{
+		Remote_Learn_Capture(rx,&sig,n,t);
+		return;
+	}
+	k=IR_Lib_Match(&sig,rx->raw,n,&jitter);
+	if(k<0)
 	{
-		if(RDATA)  // 检测到上升沿（红外信号从低电平变为高电平）
+		ir_unknown++;
+		return;
+	}
+	
+	ir_learned++;
+	ir_rx_frames[rx->ch]++;
+	f.protocol=IR_PROTO_LEARNED;
+	f.bits=n;
+	f.toggle=0;
+	f.address=(u16)k;
+	f.command=IR_Lib_Get((u8)k)->command;
+	f.raw=sig.hash;
+	f.jitter=jitter;
+	f.repeat=(rx->lib_last==k&&t-rx->lib_us<=IR_REPEAT_WINDOW_US);   // 按住时遥控器重复发送同一信号
+	rx->lib_last=k;
+	rx->lib_us=t;
+	Remote_Merge(rx,&f,t);
+}
+
+// 开始学习（主循环调用），之后按两次要学习的遥控器按键
+void Remote_Learn_Start(u16 command)
+{
+	__disable_irq();
+	ir_learn_cmd=command;
+	ir_learn_state=IR_LEARN_WAIT;
+	__enable_irq();
+}
+
+void Remote_Learn_Cancel(void)
+{
+	ir_learn_state=IR_LEARN_IDLE;
+}
+
+// 保存录制好的信号（主循环调用，Flash写入不能放在中断中）
+// 返回值：学习状态，IR_LEARN_SAVED/IR_LEARN_FAIL只返回一次
+u8 Remote_Learn_Poll(void)
+{
+	u8 st=ir_learn_state;
+	
+	if(st==IR_LEARN_DONE)
+		st=(IR_Lib_Add(&ir_learn_sig,ir_learn_cmd)>=0)?IR_LEARN_SAVED:IR_LEARN_FAIL;
+	if(st==IR_LEARN_SAVED||st==IR_LEARN_FAIL) ir_learn_state=IR_LEARN_IDLE;
+	return st;
+}
+
+// ==================== 毛刺滤波与边沿风暴抑制 ====================
+// 一个电平段送入解码器，并记录原始波形（学习和信号库匹配用）
+static void Remote_Rx_Segment(IR_Rx *rx,u8 level,u32 start,u32 dur)
+{
+	Remote_Decode(rx,level,start,dur);
+	if(level&&dur>IR_LEARN_GAP_US) Remote_Burst_End(rx,start);  // 长间隔：上一次发射结束
+	else Remote_Raw_Add(rx,dur);
+}
+
+// 待定的电平段已确认不是毛刺的一部分（后一个电平段已超过IR_GLITCH_US）：送入解码器
+static void Remote_Rx_Flush(IR_Rx *rx)
+{
+	if(!rx->pend) return;
+	rx->pend=0;
+	Remote_Rx_Segment(rx,rx->pend_level,rx->pend_us,rx->last_us-rx->pend_us);
+}
+
+// 丢弃接收头的全部状态，等待线路空闲后重新同步
+static void Remote_Rx_Reset(IR_Rx *rx,u32 now)
+{
+	rx->idle=1;
+	rx->level=1;
+	rx->pend=0;
+	rx->idle_us=now;
+	rx->raw_n=0;
+	rx->raw_dec=0;
+	rx->raw_full=0;
+	IR_Decoder_Reset(&rx->dec);
+}
+
+// 边沿风暴：关闭该通道的输入捕获，IR_STORM_MASK_MS后由Remote_Rx_Poll()重新使能
+static void Remote_Rx_Mask(IR_Rx *rx,u32 head,u32 now)
+{
+	TIM_CCxChannelCmd(TIM3,rx->hw->tim_channel,TIM_CCx_DISABLE);
+	ir_storms++;
+	rx->masked=1;
+	rx->mask_us=now;
+	rx->tail=head;
+	Remote_Rx_Reset(rx,now);
+}
+
+// ==================== 捕获缓冲区消费者 ====================
+// 功能：批量取出一个接收头DMA捕获到的边沿时间戳，计算电平持续时间并送入该接收头的解码器
+//      同时负责该接收头的毛刺滤波、边沿风暴检测和线路空闲检测
+// 参数：head   - 该接收头的生产者位置（在now之前读取）
+//      now    - 当前时间（us）
+//      resync - 1=Remote_Poll()间隔过长，积压的捕获值已无法还原
+// 毛刺滤波：每个电平段先作为待定段保留，后一个电平段结束时若短于IR_GLITCH_US，则它的两个边沿
+//          都是毛刺，待定段延续；否则待定段送入解码器。空闲后第一个脉冲就是毛刺时回到空闲
+static void Remote_Rx_Poll(IR_Rx *rx,u32 head,u32 now,u8 resync)
+{
+	u32 t,dur;
+	u16 cap;
+	u8 busy;
+	
+	if(rx->masked)   // 屏蔽期间没有捕获；到时后从当前位置重新开始
+	{
+		if(now-rx->mask_us<IR_STORM_MASK_MS*1000UL) return;
+		rx->masked=0;
+		rx->tail=Remote_Cap_Head(rx);
+		rx->storm_n=0;
+		Remote_Rx_Reset(rx,now);
+		TIM_CCxChannelCmd(TIM3,rx->hw->tim_channel,TIM_CCx_ENABLE);
+		return;
+	}
+	
+	// 捕获值只有低16位，必须在65.536ms内处理才能还原成32位时间戳
+	// 两次调用间隔过长（长时间关中断等）或缓冲区被覆盖：丢弃积压数据，等待线路空闲后重新同步
+	// 正常轮询间隔内写满缓冲区只可能是干扰，同时按边沿风暴屏蔽
+	if(resync||head-rx->tail>IR_CAP_BUF_LEN)
+	{
+		ir_overruns++;
+		if(!resync)
 		{
-			// ========== 上升沿处理：准备测量高电平持续时间 ==========
-			TIM_RESET_CAPTUREPOLARITY(&TIM3_Handler,TIM_CHANNEL_3);   // 清除原有极性设置
-			TIM_SET_CAPTUREPOLARITY(&TIM3_Handler,TIM_CHANNEL_3,TIM_ICPOLARITY_FALLING); // 设置为下降沿捕获
-			__HAL_TIM_SET_COUNTER(&TIM3_Handler,0);  	// 重置定时器计数值为0，开始计时
-		  	RmtSta|=0X10;  // 设置上升沿已捕获标志（位4=1）
+			Remote_Rx_Mask(rx,head,now);
+			return;
 		}
-		else  // 检测到下降沿（红外信号从高电平变为低电平）
+		rx->tail=head;
+		Remote_Rx_Reset(rx,now);
+	}
+	
+	while(rx->tail!=head)
+	{
+		cap=rx->buf[rx->tail%IR_CAP_BUF_LEN];
+		rx->tail++;
+		t=now-(u16)((u16)now-cap);   // 还原为32位时间戳：当前时间减去边沿距今的us数
+		
+		if(t-rx->storm_us>=IR_STORM_WINDOW_US)   // 按边沿时间戳分窗计数，与轮询是否延迟无关
 		{
-			// ========== 下降沿处理：读取高电平持续时间并解码 ==========
-			Dval=HAL_TIM_ReadCapturedValue(&TIM3_Handler,TIM_CHANNEL_3); // 读取高电平持续时间
-			TIM_RESET_CAPTUREPOLARITY(&TIM3_Handler,TIM_CHANNEL_3);   	 // 清除原有极性设置
-			TIM_SET_CAPTUREPOLARITY(&TIM3_Handler,TIM_CHANNEL_3,TIM_ICPOLARITY_RISING); // 设置为上升沿捕获
-			
-			if(RmtSta&0X10)  // 确认之前已捕获过上升沿（完成一次高电平测量）
+			rx->storm_us=t;
+			rx->storm_n=0;
+		}
+		if(++rx->storm_n>IR_STORM_EDGES)
+		{
+			Remote_Rx_Mask(rx,head,now);
+			return;
+		}
+		
+		if(rx->idle)  // 空闲后的第一个边沿必为下降沿（载波开始），空闲间隔已送入解码器
+		{
+			IR_Decoder_Elapse(&rx->dec,t-rx->idle_us);  // 补上判定空闲之后的时间
+			rx->idle=0;
+			rx->level=0;
+			rx->last_us=t;
+			continue;
+		}
+		
+		dur=t-rx->last_us;           // 高电平和低电平的持续时间都由32位差值得到
+		if(dur<IR_GLITCH_US)         // 毛刺：去掉这个电平段的两个边沿
+		{
+			ir_glitches++;
+			if(rx->pend)             // 待定段延续到下一个边沿
+			{
+				rx->pend=0;
+				rx->level=rx->pend_level;
+				rx->last_us=rx->pend_us;
+			}
+			else                     // 空闲中的孤立脉冲：回到空闲
 			{
- 				if(RmtSta&0X80)  // 已接收到引导码，开始数据位解码
-				{
-					// ========== 数据位解码部分 ==========
-					if(Dval>300&&Dval<800)  // 高电平560μs±240μs → 数据位"0"
-					{
-						RmtRec<<=1;  // 接收数据左移1位，为新数据位腾出空间
-						RmtRec|=0;   // 在最低位添加"0"
-					}
-					else if(Dval>1400&&Dval<1800)  // 高电平1680μs±200μs → 数据位"1"
-					{
-						RmtRec<<=1;  // 接收数据左移1位
-						RmtRec|=1;   // 在最低位添加"1"
-					}
-					else if(Dval>2200&&Dval<2600)  // 高电平2500μs±200μs → 重复码
-					{
-						RmtCnt++;        // 按键重复次数加1
-						RmtSta&=0XF0;    // 清空溢出计时器，重新开始计时
-					}
- 				}
-				else if(Dval>4200&&Dval<4700)  // 高电平4500μs±250μs → 引导码
-				{
-					// ========== 引导码检测 ==========
-					RmtSta|=1<<7;  // 设置引导码接收标志（位7=1）
-					RmtCnt=0;      // 清除按键重复计数器，开始新的按键接收
-				}						 
+				rx->idle=1;
+				rx->level=1;
+				rx->idle_us=t;
 			}
-			RmtSta&=~(1<<4);  // 清除上升沿捕获标志（位4=0），准备下次捕获
+			continue;
 		}
+		Remote_Rx_Flush(rx);
+		rx->pend=1;
+		rx->pend_level=rx->level;
+		rx->pend_us=rx->last_us;
+		rx->last_us=t;
+		rx->level=!rx->level;
 	}
+	
+	// 当前电平段已超过毛刺宽度：待定段不再可能被合并，立即送入解码器（不等下一个边沿）
+	if(!rx->idle&&now-rx->last_us>=IR_GLITCH_US) Remote_Rx_Flush(rx);
+	
+	// 线路长时间无边沿：回到空闲状态（高电平）
+	// 已经过的空闲间隔送入解码器，以长间隔结尾的协议（SIRC等）此时完成
+	if(!rx->idle&&(now-rx->last_us)>IR_IDLE_MS*1000UL)
+	{
+		busy=IR_Decoder_Busy(&rx->dec);
+		if(!Remote_Decode(rx,1,rx->last_us,now-rx->last_us)&&busy) ir_idle_timeouts++;  // 帧未收完线路就空闲了
+		Remote_Burst_End(rx,rx->last_us);
+		rx->idle_us=now;
+		rx->idle=1;
+		rx->level=1;
+	}
+}
+
+// 功能：依次处理各接收头的捕获数据，产生合并后的按键事件
+//      同时负责按键松开超时（取代原10ms更新中断）
+// 调用：由PendSV_Handler()调用，SysTick_Handler()每1ms挂起一次PendSV（事件队列的唯一生产者），主循环不要调用
+void Remote_Poll(void)
+{
+	u32 head[IR_RX_COUNT];
+	u32 now;
+	u8 n,resync;
+	IR_PROF_BEGIN();
+	
+	if(!ir_ready) return;
+	for(n=0;n<IR_RX_COUNT;n++) head[n]=Remote_Cap_Head(&ir_rx[n]);  // 先取写位置再取当前时间，
+	now=Remote_Time_Us();                                              // 保证已取到的捕获值都早于now
+	resync=(now-ir_poll_us>IR_POLL_MAX_US);
+	ir_poll_us=now;
+	
+	for(n=0;n<IR_RX_COUNT;n++) Remote_Rx_Poll(&ir_rx[n],head[n],now,resync);
+	
+	// 合并窗口结束：其他接收头没有收到这一帧（被遮挡或超出接收角度）
+	if(ir_pend_state!=IR_PEND_NONE&&now-ir_pend_poll>=IR_RX_MERGE_US)
+	{
+		if(ir_pend_state==IR_PEND_WAIT) Remote_Emit();
+		ir_pend_state=IR_PEND_NONE;
+	}
+	
+	// 超过松开超时仍未收到重复码/重复帧：认为按键已松开
+	// 学习的信号在线路空闲后才判定发射结束，比协议帧晚最多IR_IDLE_MS，松开超时相应延长
+	if(ir_held&&(now-ir_key_us)>(IR_RELEASE_MS+(ir_frame.protocol==IR_PROTO_LEARNED?IR_IDLE_MS:0))*1000UL)
+	{
+		ir_release_timeouts++;
+		ir_held=0;
+		ir_held_key=0;
+		Remote_Push_Event(IR_EVT_RELEASE,now);
+	}
+	IR_PROF_END(ir_prof_poll);
+}
+
+// ==================== 按键事件读取（消费者） ====================
+// 功能：从事件队列取出一个按键事件，主循环中应循环调用直到返回0
+// 参数：ev - 事件输出
+// 返回值：1=取到事件，0=队列为空
+u8 Remote_Get_Event(IR_Event *ev)
+{
+	u8 tail=ir_evt_tail;
+	
+	if(tail==ir_evt_head) return 0;
+	__DMB();                 // 先看到写位置，再读事件内容
+	*ev=ir_evt_buf[tail&(IR_EVT_QUEUE_LEN-1)];
+	__DMB();                 // 事件内容读完后再释放该位置
+	ir_evt_tail=tail+1;
+	return 1;
+}
+
+// 获取因队列满而丢弃的事件数
+u32 Remote_Dropped_Events(void)
+{
+	return ir_evt_dropped;
 }
 
-// ==================== NEC协议数据解析和按键扫描函数 ====================
+// ==================== 按键扫描函数（兼容接口） ====================
 // 红外遥控按键扫描函数
-// 功能：解析接收到的32位NEC协议数据，提取并验证按键值
-// 返回值：0=无按键按下，其他值=按下的按键编码
-// 调用：在主循环中周期性调用，检测是否有新的按键按下
+// 功能：返回当前按住的按键命令码，不消耗事件队列
+//      按住期间每次调用都返回同一键值，松开后返回0
+//      主循环中两次调用之间的短按可能被合并，新代码请使用Remote_Get_Event()
+// 返回值：0=无按键按下，其他值=按下的按键编码（命令码低8位）
 u8 Remote_Scan(void)
 {        
-	u8 sta=0;       // 最终返回的按键值
-	u8 t1,t2;       // 临时变量，用于数据解析和校验
-	
-	if(RmtSta&(1<<6))  // 检查是否接收到完整的按键数据（位6=1）
-	{ 
-		// ========== NEC协议32位数据解析 ==========
-		// NEC协议数据格式：[地址码8位][地址反码8位][命令码8位][命令反码8位]
-		// 高位先传输，所以数据在RmtRec中的排列为：
-		// 位31-24: 地址码    位23-16: 地址反码
-		// 位15-8:  命令码    位7-0:   命令反码
-		
-	    t1=RmtRec>>24;			    // 提取地址码（位31-24）
-	    t2=(RmtRec>>16)&0xff;	    // 提取地址反码（位23-16）
-	    
-	    // ========== 地址码验证 ==========
- 	    if((t1==(u8)~t2)&&t1==REMOTE_ID)  // 验证：地址码 = ~地址反码 且 地址码 = 预设ID
-	    { 
-	        // 地址码验证通过，开始解析命令码
-	        t1=RmtRec>>8;     // 提取命令码（位15-8）
-	        t2=RmtRec; 	      // 提取命令反码（位7-0）
-	        
-	        // ========== 命令码验证 ==========
-	        if(t1==(u8)~t2)   // 验证：命令码 = ~命令反码
-	            sta=t1;       // 命令码验证通过，返回按键值
-		}   
-		
-		// ========== 数据清理和状态重置 ==========
-		if((sta==0)||((RmtSta&0X80)==0))  // 按键数据错误 或 遥控器已松开
-		{
-		 	RmtSta&=~(1<<6);  // 清除"接收到有效按键"标志（位6=0）
-			RmtCnt=0;		  // 清除按键重复次数计数器
-		}
-	}  
-    return sta;  // 返回按键值（0=无按键，其他=具体按键编码）
+	return ir_held_key;
+}
+
+// 设置接收的协议，例如 IR_PROTO_MASK(IR_PROTO_NEC)|IR_PROTO_MASK(IR_PROTO_RC5)
+// 默认接收全部协议，对全部接收头生效
+// 说明：解码器在PendSV中运行，修改期间短暂关中断
+void Remote_Set_Protocols(u32 mask)
+{
+	u8 n;
+	
+	__disable_irq();
+	for(n=0;n<IR_RX_COUNT;n++) IR_Decoder_Enable(&ir_rx[n].dec,mask);
+	__enable_irq();
+}
+
+// ==================== 接收统计 ====================
+// 累加一次耗时测量
+static void Remote_Prof_Add(IR_Cycle_Stat *st,u32 cycles)
+{
+	if(st->count==0||cycles<st->min) st->min=cycles;
+	if(cycles>st->max) st->max=cycles;
+	st->total+=cycles;
+	st->count++;
+}
+
+// 读取接收统计快照
+// 说明：统计在中断中更新，复制期间短暂关中断，保证各项来自同一时刻
+void Remote_Get_Stats(IR_Stats *st)
+{
+	const IR_Decoder_Stats *d;
+	u8 n;
+	
+	memset(&st->dec,0,sizeof(st->dec));
+	__disable_irq();
+	for(n=0;n<IR_RX_COUNT;n++)     // 解码统计为各接收头之和
+	{
+		d=&ir_rx[n].dec.stats;
+		st->dec.leaders+=d->leaders;
+		st->dec.frames+=d->frames;
+		st->dec.repeats+=d->repeats;
+		st->dec.check_fail+=d->check_fail;
+		st->dec.bad_pulse+=d->bad_pulse;
+	}
+	memcpy(st->rx_frames,ir_rx_frames,sizeof(ir_rx_frames));
+	memcpy(st->rx_best,ir_rx_best,sizeof(ir_rx_best));
+	st->merged=ir_merged;
+	st->learned=ir_learned;
+	st->unknown=ir_unknown;
+	st->addr_reject=ir_addr_reject;
+	st->release_timeouts=ir_release_timeouts;
+	st->idle_timeouts=ir_idle_timeouts;
+	st->overruns=ir_overruns;
+	st->glitches=ir_glitches;
+	st->storms=ir_storms;
+	st->dropped_events=ir_evt_dropped;
+	st->isr_capture=ir_prof_capture;
+	st->isr_update=ir_prof_update;
+	st->poll=ir_prof_poll;
+	__enable_irq();
+}
+
+// 清零接收统计（开始一轮新的测量，例如调整时序窗口之后）
+void Remote_Reset_Stats(void)
+{
+	u8 n;
+	
+	__disable_irq();
+	for(n=0;n<IR_RX_COUNT;n++) memset(&ir_rx[n].dec.stats,0,sizeof(ir_rx[n].dec.stats));
+	memset(ir_rx_frames,0,sizeof(ir_rx_frames));
+	memset(ir_rx_best,0,sizeof(ir_rx_best));
+	ir_merged=0;
+	ir_learned=0;
+	ir_unknown=0;
+	ir_addr_reject=0;
+	ir_release_timeouts=0;
+	ir_idle_timeouts=0;
+	ir_overruns=0;
+	ir_glitches=0;
+	ir_storms=0;
+	ir_evt_dropped=0;
+	memset(&ir_prof_capture,0,sizeof(ir_prof_capture));
+	memset(&ir_prof_update,0,sizeof(ir_prof_update));
+	memset(&ir_prof_poll,0,sizeof(ir_prof_poll));
+	__enable_irq();
+}
+
+// 打印一项耗时统计：次数 最小/平均/最大周期数
+static void Remote_Print_Cycles(const char *name,const IR_Cycle_Stat *c)
+{
+	u32 avg=c->count?(u32)(c->total/c->count):0;
+	
+	printf("  %-8s n=%lu min/avg/max=%lu/%lu/%lu cyc\r\n",name,
+	       (unsigned long)c->count,(unsigned long)c->min,(unsigned long)avg,(unsigned long)c->max);
+}
+
+// 通过串口打印接收统计
+// 调用：主循环中按IR_STATS_PERIOD_MS周期调用，或调试时随时调用
+void Remote_Print_Stats(void)
+{
+	IR_Stats st;
+#if IR_RX_COUNT>1
+	u8 ch;
+#endif
+	
+	Remote_Get_Stats(&st);
+	printf("[IR] leader=%lu frame=%lu repeat=%lu chk_fail=%lu bad_pulse=%lu\r\n",
+	       (unsigned long)st.dec.leaders,(unsigned long)st.dec.frames,(unsigned long)st.dec.repeats,
+	       (unsigned long)st.dec.check_fail,(unsigned long)st.dec.bad_pulse);
+	printf("[IR] addr_rej=%lu release_to=%lu idle_to=%lu overrun=%lu evt_drop=%lu\r\n",
+	       (unsigned long)st.addr_reject,(unsigned long)st.release_timeouts,(unsigned long)st.idle_timeouts,
+	       (unsigned long)st.overruns,(unsigned long)st.dropped_events);
+	printf("[IR] learned=%lu unknown=%lu library=%u glitch=%lu storm=%lu\r\n",
+	       (unsigned long)st.learned,(unsigned long)st.unknown,IR_Lib_Count(),
+	       (unsigned long)st.glitches,(unsigned long)st.storms);
+#if IR_RX_COUNT>1
+	printf("[IR] merged=%lu",(unsigned long)st.merged);
+	for(ch=0;ch<IR_RX_MAX;ch++)    // 各接收头：解出的帧/被选为事件来源的次数
+		if(IR_RX_CH_MASK&(1<<ch)) printf(" ch%u=%lu/%lu",ch+1,(unsigned long)st.rx_frames[ch],(unsigned long)st.rx_best[ch]);
+	printf("\r\n");
+#endif
+#if IR_PROFILE
+	Remote_Print_Cycles("capture",&st.isr_capture);
+	Remote_Print_Cycles("update",&st.isr_update);
+	Remote_Print_Cycles("poll",&st.poll);
+#endif
 }
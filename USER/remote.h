@@ -1,3 +1,8 @@
+#ifndef __REMOTE_H
+#define __REMOTE_H
+#include "sys.h"
+#include "ir_decode.h"
+#include "ir_learn.h"
 //////////////////////////////////////////////////////////////////////////////////	 
 // 红外遥控LED调光系统 - 红外遥控头文件
 // 功能说明：定义红外遥控相关的宏定义、函数声明和接口
@@ -11,16 +16,154 @@
 
 #define RDATA   PBin(0)		// 红外数据输入引脚（PB0，连接红外接收头输出）
 
+// ==================== 多接收头配置 ====================
+// IR_RX_CH_MASK：接有红外接收头的TIM3捕获通道（bit0~bit3 = CH1~CH4），可在编译选项中覆盖
+//   CH1=PB4（DMA1_Stream4）  CH2=PB5（DMA1_Stream5）  CH3=PB0（DMA1_Stream7）  CH4=PB1（DMA1_Stream2）
+//   各通道共用TIM3时基，各自一个DMA环形缓冲区和一个解码器，事件中的rx为收到该帧的通道号
+// IR_RX_MERGE_US：不同接收头解出的同一帧（协议/地址/命令/重复标志相同）结束边沿相差在此范围内
+//                 视为同一次发射，只产生一个事件，取信号质量最好（IR_Frame.jitter最小）的接收头
+#ifndef IR_RX_CH_MASK
+#define IR_RX_CH_MASK    0x04
+#endif
+#define IR_RX_MAX        4
+#define IR_RX_COUNT      (((IR_RX_CH_MASK)&1)+(((IR_RX_CH_MASK)>>1)&1)+(((IR_RX_CH_MASK)>>2)&1)+(((IR_RX_CH_MASK)>>3)&1))
+#define IR_RX_MERGE_US   3000
+
 // 红外遥控器识别码(ID)
 // 说明：每款遥控器都有唯一的识别码，用于区分不同品牌的遥控器
-// 当前使用的遥控器识别码为0（ALIENTEK标准遥控器）
+// 当前使用的遥控器识别码为0（ALIENTEK标准遥控器），Remote_Init()把它作为地址允许列表默认接受的标准NEC地址
 #define REMOTE_ID 0      		   
 
-extern u8 RmtCnt;	        // 按键按下的次数计数器（外部变量声明）
+// ==================== 地址允许列表 ====================
+// 按（协议，地址）过滤协议表中的全部协议，地址与解码结果IR_Frame的address相同
+// 标准NEC的8位地址用256位位图，其他协议（扩展NEC/Samsung/SIRC/RC5/RC6）的地址用开放寻址散列表
+// （表长IR_ADDR_HASH_LEN，最多IR_ADDR_MAX个，装填率不超过1/2），每帧的查找都是常数时间
+// 列表中没有的协议一律不接受，除非用Remote_Addr_Allow_Any()设为不过滤；学习的信号（IR_PROTO_LEARNED）不过滤
+// Remote_Init()后的默认值：只接受REMOTE_ID的标准NEC帧
+#define IR_ADDR_MAX         32
+#define IR_ADDR_HASH_BITS   6
+#define IR_ADDR_HASH_LEN    (1<<IR_ADDR_HASH_BITS)
+
+typedef struct
+{
+    u8  protocol;       // 协议（IR_PROTO_NEC~IR_PROTO_SAMSUNG）
+    u16 address;        // 地址（标准NEC/Samsung/RC6为8位，RC5为5位，SIRC为5/8/13位，扩展NEC为16位）
+} IR_Addr;
+
+// ==================== 捕获缓冲区配置 ====================
+// IR_CAP_BUF_LEN：DMA捕获环形缓冲区长度（边沿个数，必须为偶数）
+//                 一帧NEC约68个边沿，128可缓存主循环阻塞期间的完整一帧
+// IR_IDLE_MS：    超过该时间无边沿则认为线路回到空闲
+// IR_RELEASE_MS： 超过该时间未收到重复码则认为按键已松开（重复码周期约108ms）
+#define IR_CAP_BUF_LEN   128
+#define IR_IDLE_MS       20
+#define IR_RELEASE_MS    140
+
+// IR_POLL_MAX_US：两次Remote_Poll()之间允许的最长间隔
+//                 捕获值为TIM3低16位，超过65.536ms无法还原32位时间戳，留出余量
+#define IR_POLL_MAX_US   60000UL
+
+// ==================== 毛刺滤波与边沿风暴抑制 ====================
+// 荧光灯、阳光等干扰使接收头输出很短的脉冲，硬件输入滤波（ICFilter）只能去掉100ns以内的毛刺，
+// 解码前在各接收头的边沿流上再做一级处理：
+// IR_GLITCH_US：     短于此宽度的电平段为毛刺，连同两侧的边沿一起去掉，前一个电平段延续（0=不滤波）
+//                    各协议最短的电平段为RC6的444us；电平段要等后一个电平段超过此宽度才送入解码器，
+//                    解码结果最多延后IR_GLITCH_US+1ms
+// IR_STORM_EDGES：   一个接收头每IR_STORM_WINDOW_US内最多的边沿数，超过即为边沿风暴
+//                    （协议波形最密约2.3个边沿/ms）；一个轮询周期内写满捕获缓冲区也按边沿风暴处理
+// IR_STORM_MASK_MS： 边沿风暴时关闭该通道的输入捕获（CCxE），屏蔽期间没有捕获DMA和DMA中断，
+//                    解码也跳过该接收头，中断负载不随干扰强度增加；到时后重新使能
+#define IR_GLITCH_US        100
+#define IR_STORM_EDGES      48
+#define IR_STORM_WINDOW_US  10000UL
+#define IR_STORM_MASK_MS    50
+
+// IR_EVT_QUEUE_LEN：按键事件队列长度（2的幂，不超过128）
+//                   主循环阻塞期间产生的按下/重复/松开事件都暂存在这里
+#define IR_EVT_QUEUE_LEN 16
+
+// ==================== 红外学习 ====================
+// Remote_Learn_Start(命令)后，协议表无法解码的发射连续两次（不同的两次发射）压缩结果相同即录制完成，
+// 主循环中的Remote_Learn_Poll()把它写入Flash信号库并绑定该命令
+// 之后收到同样的发射产生protocol=IR_PROTO_LEARNED、address=信号库下标、command=绑定命令的按键事件
+#define IR_LEARN_IDLE       0   // 未学习
+#define IR_LEARN_WAIT       1   // 等待第一次发射
+#define IR_LEARN_CONFIRM    2   // 等待第二次相同的发射
+#define IR_LEARN_DONE       3   // 已录制，等待Remote_Learn_Poll()保存
+#define IR_LEARN_SAVED      4   // 已写入信号库（Remote_Learn_Poll()返回一次后回到IDLE）
+#define IR_LEARN_FAIL       5   // 信号库已满或Flash写入失败（同上）
+
+// ==================== 按键事件 ====================
+#define IR_EVT_PRESS     0      // 按下（新按键的第一帧）
+#define IR_EVT_REPEAT    1      // 按住重复（NEC重复码或同码连发）
+#define IR_EVT_RELEASE   2      // 松开（超过IR_RELEASE_MS未收到重复）
+
+typedef struct
+{
+    u8  type;           // 事件类型（IR_EVT_xxx）
+    u8  protocol;       // 协议编号（IR_PROTO_xxx）
+    u8  repeat;         // 本次按住已收到的重复次数（按下事件为0）
+    u8  rx;             // 选中的接收头（TIM3通道号0~3 = CH1~CH4）
+    u8  rx_mask;        // 收到该帧的全部接收头（bit0~bit3 = CH1~CH4）
+    u16 address;        // 地址
+    u16 command;        // 命令（ALIENTEK遥控器按键值即命令码）
+    u32 time_us;        // 事件时间（us，Remote_Time_Us()时基）：按下/重复为帧最后一个电平段开始的时间，松开为判定时间
+} IR_Event;
+
+// ==================== 接收统计与中断耗时 ====================
+// IR_PROFILE：1=用DWT周期计数器测量中断和解码耗时（单位：CPU周期，96MHz下96周期=1us）
+// IR_STATS_PERIOD_MS：主循环通过串口周期打印统计的间隔，0=不打印
+#define IR_PROFILE          1
+#define IR_STATS_PERIOD_MS  10000
+
+typedef struct
+{
+    u32 count;          // 测量次数
+    u32 min;            // 最短耗时（周期）
+    u32 max;            // 最长耗时（周期）
+    uint64_t total;     // 累计耗时（周期），平均值=total/count
+} IR_Cycle_Stat;
+
+typedef struct
+{
+    IR_Decoder_Stats dec;       // 解码统计：引导码、完整帧、重复码、校验失败、窗口外脉冲（各接收头之和）
+    u32 rx_frames[IR_RX_MAX];   // 各接收头解出的帧（含重复码和被合并的帧）
+    u32 rx_best[IR_RX_MAX];     // 各接收头被选为事件来源的次数
+    u32 merged;                 // 被合并掉的其他接收头的同一帧
+    u32 learned;                // 与信号库匹配的未解码发射
+    u32 unknown;                // 未解码、也不在信号库中的发射（不少于IR_LEARN_MIN_SEG个电平段）
+    u32 addr_reject;            // 地址不在允许列表中而被丢弃的NEC/扩展NEC帧
+    u32 release_timeouts;       // 超过IR_RELEASE_MS未收到重复而判定松开的次数
+    u32 idle_timeouts;          // 帧接收中途超过IR_IDLE_MS无边沿的次数
+    u32 overruns;               // 捕获缓冲区溢出或Remote_Poll()间隔过长导致的重新同步
+    u32 glitches;               // 去掉的毛刺（短于IR_GLITCH_US的电平段）
+    u32 storms;                 // 边沿风暴导致的捕获屏蔽次数
+    u32 dropped_events;         // 事件队列满而丢弃的事件
+    IR_Cycle_Stat isr_capture;  // 捕获DMA中断（各通道的DMA数据流，每半个缓冲区一次）
+    IR_Cycle_Stat isr_update;   // TIM3更新中断（时基溢出，每65.536ms一次）
+    IR_Cycle_Stat poll;         // Remote_Poll()解码（PendSV中，最低优先级，可被上面两个中断抢占）
+} IR_Stats;
+
+extern u8 RmtCnt;	        // 当前按键的重复次数（外部变量声明）
 
 // ==================== 函数声明 ====================
 void Remote_Init(void);     // 红外接收模块初始化函数
-u8 Remote_Scan(void);       // 红外按键扫描函数
+void Remote_Poll(void);     // 处理DMA缓冲区中的边沿数据（由PendSV中断调用）
+u8 Remote_Get_Event(IR_Event *ev);      // 取出一个按键事件（主循环调用）
+u32 Remote_Dropped_Events(void);        // 队列满时丢弃的事件数
+u32 Remote_Time_Us(void);               // 32位微秒时间戳（与按键事件time_us同一时基）
+u8 Remote_Scan(void);       // 红外按键扫描函数（兼容接口：返回当前按住的键值）
+void Remote_Set_Protocols(u32 mask);    // 设置接收的协议（IR_PROTO_MASK组合）
+void Remote_Addr_Clear(void);           // 清空地址允许列表（协议表中的协议都不接受）
+u8 Remote_Addr_Allow(u8 protocol,u16 address);  // 允许一个地址，返回0=散列表已满或协议无效
+void Remote_Addr_Allow_Any(u8 protocol);    // 该协议的地址不过滤（再调用Remote_Addr_Allow()则恢复过滤）
+u8 Remote_Addr_Load(const IR_Addr *list,u8 n);  // 用列表替换允许列表，返回成功加入的个数
+void Remote_Learn_Start(u16 command);   // 开始学习，录制的信号绑定command
+void Remote_Learn_Cancel(void);         // 取消学习
+u8 Remote_Learn_Poll(void);             // 主循环调用：保存录制好的信号，返回学习状态（IR_LEARN_xxx）
+void Remote_Get_Stats(IR_Stats *st);    // 读取接收统计快照
+void Remote_Reset_Stats(void);          // 清零接收统计
+void Remote_Print_Stats(void);          // 通过串口打印接收统计
 
 // ==================== 标准按键值定义 ====================
 // 以下按键值通过实际测试NEC协议解码得出，对应ALIENTEK标准遥控器
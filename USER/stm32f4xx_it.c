@@ -38,6 +38,7 @@
 /* Includes ------------------------------------------------------------------*/
 #include "main.h"
 #include "stm32f4xx_it.h"
+#include "remote.h"
 
 /** @addtogroup STM32F4xx_HAL_Examples
   * @{
@@ -144,6 +145,7 @@ void DebugMon_Handler(void)
   */
 void PendSV_Handler(void)
 {
+  Remote_Poll();    /* Drain IR captures and queue key events (lowest priority, see Remote_Init) */
 }
 
 /**
@@ -154,6 +156,7 @@ void PendSV_Handler(void)
 void SysTick_Handler(void)
 {
   HAL_IncTick();
+  SCB->ICSR = SCB_ICSR_PENDSVSET_Msk;   /* Decode in PendSV so it never delays TIM2/TIM3/DMA */
 }
 
 /******************************************************************************/
@@ -0,0 +1,115 @@
+#include "ui_widget.h"
+#include "tftlcd.h"
+#include "string.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 保留模式控件层
+// 功能说明：记录当前页面和每个控件上一次画出的值；UI_Update()比较后只重画变化的控件
+// 显示说明：绘制经过tftlcd.c，清屏之后的绘制由lcd_band.c按帧只发送有变化的像素
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+static const UI_Page *ui_page=0;        // 当前页面
+static u32 ui_last[UI_MAX_WIDGETS];     // 各控件上一次画出的值
+static UI_Stats ui_stats;
+
+static void UI_Text(const UI_Widget *w,const char *s)
+{
+	POINT_COLOR=w->fg;
+	BACK_COLOR=w->bg;
+	LCD_ShowString(w->x,w->y,LCD_Width,w->size,w->size,(char*)s);
+}
+
+// 进度条的第from~to-1段，value为点亮的段数
+static void UI_Bar(const UI_Widget *w,u32 value,u8 from,u8 to)
+{
+	u16 x;
+
+	for(;from<to;from++)
+	{
+		x=w->x+from*w->pitch;
+		LCD_Fill(x,w->y,x+w->w-1,w->y+w->h-1,from<value?w->fg:w->bg);
+	}
+}
+
+// 画一个控件；old为上一次的值（进度条只重画两者之间的段），full=1表示整个画出
+static void UI_Draw(const UI_Widget *w,u32 value,u32 old,u8 full)
+{
+	char buf[UI_TEXT_MAX];
+	u16 n,pad;
+
+	switch(w->type)
+	{
+		case UI_LABEL:
+			UI_Text(w,w->text);
+			break;
+
+		case UI_VALUE:
+			w->fmt(buf,value);
+			n=strlen(buf);
+			pad=w->w/(w->size/2);               // 补齐到控件宽度，清除上一次较长的文字
+			if(pad>UI_TEXT_MAX-1) pad=UI_TEXT_MAX-1;
+			while(n<pad) buf[n++]=' ';
+			buf[n]=0;
+			UI_Text(w,buf);
+			break;
+
+		case UI_BAR:
+			if(full) UI_Bar(w,value,0,w->size);
+			else if(value>old) UI_Bar(w,value,old,value>w->size?w->size:value);
+			else UI_Bar(w,value,value,old>w->size?w->size:old);
+			break;
+
+		case UI_LED:
+			LCD_Fill(w->x,w->y,w->x+w->w-1,w->y+w->h-1,value?w->fg:w->bg);
+			break;
+
+		case UI_DRAW:
+			if(full) w->draw(w->x,w->y);
+			break;
+	}
+}
+
+// 显示页面：清屏后按表中顺序画出全部控件，记下各控件的值
+void UI_Show(const UI_Page *page)
+{
+	const UI_Widget *w;
+	u8 i;
+
+	ui_page=page;
+	ui_stats.shows++;
+	LCD_Clear(page->bg);
+	for(i=0;i<page->n&&i<UI_MAX_WIDGETS;i++)
+	{
+		w=&page->w[i];
+		ui_last[i]=w->get?w->get(w->arg):0;
+		UI_Draw(w,ui_last[i],0,1);
+	}
+}
+
+// 更新当前页面：只重画绑定值与上一次不同的控件
+void UI_Update(void)
+{
+	const UI_Widget *w;
+	u32 v;
+	u8 i;
+
+	if(ui_page==0) return;
+	ui_stats.updates++;
+	for(i=0;i<ui_page->n&&i<UI_MAX_WIDGETS;i++)
+	{
+		w=&ui_page->w[i];
+		if(w->get==0) continue;
+		v=w->get(w->arg);
+		if(v==ui_last[i]) continue;
+		UI_Draw(w,v,ui_last[i],0);
+		ui_last[i]=v;
+		ui_stats.redraws++;
+	}
+}
+
+void UI_Get_Stats(UI_Stats *st)
+{
+	*st=ui_stats;
+}
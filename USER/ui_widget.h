@@ -0,0 +1,72 @@
+#ifndef __UI_WIDGET_H
+#define __UI_WIDGET_H
+#include "sys.h"
+//////////////////////////////////////////////////////////////////////////////////
+// 红外遥控LED调光系统 - 保留模式控件层头文件
+// 功能说明：页面是控件的常量表（存放在Flash中）：固定文字、绑定数值的文字、分段进度条、
+//          LED指示灯和自绘控件。UI_Show()清屏并画出整页，UI_Update()逐个读取控件绑定的
+//          模型值，只重画值变化了的控件（进度条只重画变化的段），值不变时不格式化也不发送
+// 绑定方式：控件登记取值函数get(arg)，arg为表中登记的参数（如LED编号）；
+//          数值文字由fmt格式化，比上一次短时用空格补齐到控件宽度，不留旧字符
+// 依赖说明：通过tftlcd.c绘制，绘制时设置POINT_COLOR/BACK_COLOR；只能在主循环中使用
+// 开发板：ALIENTEK STM32F4 NANO
+// 版本：V1.0
+// 日期：2025年7月
+//////////////////////////////////////////////////////////////////////////////////
+
+// ==================== 配置 ====================
+#define UI_MAX_WIDGETS  32          // 一页最多的控件数
+#define UI_TEXT_MAX     48          // 数值文字的最大长度（含结尾0）
+
+// ==================== 控件类型 ====================
+#define UI_LABEL        0           // 固定文字
+#define UI_VALUE        1           // 数值文字：值变化时重新格式化
+#define UI_BAR          2           // 分段进度条：值为点亮的段数
+#define UI_LED          3           // 指示灯：值非0为亮色
+#define UI_DRAW         4           // 自绘（如Logo）：只在页面显示时画一次
+
+typedef u32 (*UI_Get)(u8 arg);                  // 取绑定的模型值
+typedef void (*UI_Fmt)(char *buf,u32 value);    // 数值格式化（不超过UI_TEXT_MAX-1个字符）
+
+typedef struct
+{
+	u8  type;
+	u8  size;           // 文字：字号；进度条：段数
+	u8  arg;            // 传给get的参数
+	u16 x,y;
+	u16 w,h;            // 数值文字：补齐宽度；进度条：每段宽高；指示灯：宽高
+	u16 pitch;          // 进度条：段间距
+	u16 fg,bg;          // 文字：字体色/背景色；进度条、指示灯：亮色/暗色
+	const char *text;   // 固定文字
+	UI_Get get;
+	UI_Fmt fmt;
+	void (*draw)(u16 x,u16 y);
+} UI_Widget;
+
+typedef struct
+{
+	u16 bg;             // 页面背景色
+	const UI_Widget *w;
+	u8  n;
+} UI_Page;
+
+// 控件定义
+#define UI_LABEL_W(x,y,size,fg,bg,text)             { UI_LABEL,size,0,x,y,0,0,0,fg,bg,text,0,0,0 }
+#define UI_VALUE_W(x,y,size,w,fg,bg,get,fmt)        { UI_VALUE,size,0,x,y,w,0,0,fg,bg,0,get,fmt,0 }
+#define UI_BAR_W(x,y,n,w,h,pitch,on,off,get)        { UI_BAR,n,0,x,y,w,h,pitch,on,off,0,get,0,0 }
+#define UI_LED_W(x,y,w,h,on,off,get,arg)            { UI_LED,0,arg,x,y,w,h,0,on,off,0,get,0,0 }
+#define UI_DRAW_W(x,y,draw)                         { UI_DRAW,0,0,x,y,0,0,0,0,0,0,0,0,draw }
+#define UI_PAGE(bg,widgets)                         { bg,widgets,sizeof(widgets)/sizeof(widgets[0]) }
+
+// 统计
+typedef struct
+{
+	u32 shows;          // 整页显示次数
+	u32 updates;        // UI_Update()调用次数
+	u32 redraws;        // 值变化而重画的控件数
+} UI_Stats;
+
+void UI_Show(const UI_Page *page);      // 清屏并画出整页
+void UI_Update(void);                   // 重画绑定值变化了的控件
+void UI_Get_Stats(UI_Stats *st);
+#endif